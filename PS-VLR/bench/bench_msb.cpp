@@ -0,0 +1,188 @@
+// msb latency and traffic of the bitwise, edaBit and DCF backends
+// every party runs in its own thread over a LocalNetwork, one json object per line:
+// bench_msb [n_players] [elements] [repetitions]
+// time includes drawing the correlated randomness from the local dealer, which is
+// the whole DCF key generation for the dcf backend
+// msb_pair runs two independent msb calls one after the other, then as coroutines
+// side by side on a RoundScheduler, which merges their openings
+// piecewise_linear checks its curves against the plaintext ones, the exit code is 1 on a mismatch
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include "mpc/fsemi2k/fsemi2k_nonlinear.hpp"
+#include "mpc/semi2k/semi2k_context.hpp"
+#include "network/multi_party_player.hpp"
+
+namespace {
+
+const char* backend_name(MsbBackend backend){
+    switch(backend){
+        case MsbBackend::bitwise: return "bitwise";
+        case MsbBackend::edabit:  return "edabit";
+        case MsbBackend::dcf:     return "dcf";
+    }
+    return "unknown";
+}
+
+network::PhaseRecord total_traffic(const network::LocalMultiPartyPlayer& player){
+    network::PhaseRecord total;
+    for(const auto& [tag, record]: player.phases().records()){
+        total.rounds += record.rounds;
+        total.bytes_send += record.bytes_send;
+    }
+    return total;
+}
+
+template <size_t K>
+void bench(std::size_t n_players, std::size_t elements, std::size_t repetitions, MsbBackend backend){
+    network::run_local_parties(n_players, [&](network::LocalMultiPartyPlayer& player){
+        Semi2kContext<K> sc(&player, player.all_but_me(), player.id(), 1);
+        Semi2kDealer<K> dealer(1234, player.id(), n_players);
+        sc.set_dealer(&dealer);
+        sc.set_msb_backend(backend);
+
+        std::vector<Semi2kSharing<K>> a = sc.template rand<K>(elements);
+        player.phases().clear();
+
+        auto start = std::chrono::steady_clock::now();
+        for(std::size_t r = 0; r != repetitions; ++r) sc.msb(a);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        if(player.id() != 0) return;
+        auto total = total_traffic(player);
+        std::cout << fmt::format(
+            "{{\"bench\": \"msb\", \"backend\": \"{}\", \"K\": {}, \"players\": {}, \"elements\": {}, "
+            "\"rounds\": {}, \"bytes_send\": {}, \"ms\": {:.3f}}}",
+            backend_name(backend), K, n_players, elements,
+            total.rounds / repetitions, total.bytes_send / repetitions, elapsed.count() / repetitions) << std::endl;
+    });
+}
+
+template <size_t K>
+void bench_pair(std::size_t n_players, std::size_t elements, std::size_t repetitions, MsbBackend backend){
+    network::run_local_parties(n_players, [&](network::LocalMultiPartyPlayer& player){
+        Semi2kContext<K> sc(&player, player.all_but_me(), player.id(), 1);
+        Semi2kDealer<K> dealer(1234, player.id(), n_players);
+        sc.set_dealer(&dealer);
+        sc.set_msb_backend(backend);
+
+        std::vector<Semi2kSharing<K>> a = sc.template rand<K>(elements);
+        std::vector<Semi2kSharing<K>> b = sc.template rand<K>(elements);
+
+        for(bool scheduled: {false, true}){
+            player.phases().clear();
+            auto start = std::chrono::steady_clock::now();
+            for(std::size_t r = 0; r != repetitions; ++r){
+                if(scheduled){
+                    RoundScheduler<K> scheduler(&player);
+                    scheduler.run(sc.co_msb(a), sc.co_msb(b));
+                }
+                else{
+                    sc.msb(a);
+                    sc.msb(b);
+                }
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+            if(player.id() != 0) continue;
+            auto total = total_traffic(player);
+            std::cout << fmt::format(
+                "{{\"bench\": \"msb_pair\", \"backend\": \"{}\", \"scheduled\": {}, \"K\": {}, \"players\": {}, \"elements\": {}, "
+                "\"rounds\": {}, \"bytes_send\": {}, \"ms\": {:.3f}}}",
+                backend_name(backend), scheduled, K, n_players, elements,
+                total.rounds / repetitions, total.bytes_send / repetitions, elapsed.count() / repetitions) << std::endl;
+        }
+    });
+}
+
+struct Curve{
+    const char* name;
+    std::vector<double> thresholds, slopes, intercepts;
+};
+
+// integral differences of neighbouring slopes and intercepts keep the indicator sums at scale 0,
+// the fractional end values must not be rounded there
+const std::vector<Curve> curves{
+    {"quarter_step", {0}, {0.25, 0.25}, {0.5, 1.5}},
+    {"sigmoid_clamp", {-4, 4}, {0, 1, 0}, {0, 0, 1}},
+};
+
+double plain_piecewise_linear(const Curve& c, double x){
+    std::size_t k = std::upper_bound(c.thresholds.begin(), c.thresholds.end(), x) - c.thresholds.begin();
+    return c.slopes[k] * x + c.intercepts[k];
+}
+
+// false if a value is off by more than a few units in the last place
+template <size_t N, size_t D>
+bool bench_piecewise_linear(std::size_t n_players, std::size_t elements, std::size_t repetitions){
+    const std::vector<double> xs{-6, -3.5, -1, -0.25, 0.5, 1, 1.75, 5};
+    bool ok = true;
+    for(const auto& curve: curves){
+        double max_error = 0;
+        network::run_local_parties(n_players, [&](network::LocalMultiPartyPlayer& player){
+            Semi2kContext<N> base(&player, player.all_but_me(), player.id(), 1);
+            Semi2kDealer<N> dealer(1234, player.id(), n_players);
+            base.set_dealer(&dealer);
+            FSemi2kContext<N, D> sc(base);
+            sc.set_dealer(&dealer);
+
+            std::vector<FSemi2kSharing<N, D>> x(elements, FSemi2kSharing<N, D>(0.0));
+            if(player.id() == 0){
+                for(std::size_t i = 0; i != elements; ++i) x[i] = FSemi2kSharing<N, D>(xs[i % xs.size()]);
+            }
+            player.phases().clear();
+
+            std::vector<FSemi2kSharing<N, D>> y;
+            auto start = std::chrono::steady_clock::now();
+            for(std::size_t r = 0; r != repetitions; ++r){
+                y = nonlinear::piecewise_linear(sc, x, curve.thresholds, curve.slopes, curve.intercepts);
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            auto total = total_traffic(player);
+
+            std::vector<Semi2kSharing<N>> raw(y.size());
+            for(std::size_t i = 0; i != y.size(); ++i) raw[i] = UnsignedZ2<N>(y[i].get_data());
+            auto opened = base.open(raw);
+            if(player.id() != 0) return;
+            for(std::size_t i = 0; i != opened.size(); ++i){
+                double value = double(FSemi2kSharing<N, D>(SignedZ2<N>(opened[i])));
+                max_error = std::max(max_error, std::abs(value - plain_piecewise_linear(curve, xs[i % xs.size()])));
+            }
+            std::cout << fmt::format(
+                "{{\"bench\": \"piecewise_linear\", \"curve\": \"{}\", \"K\": {}, \"D\": {}, \"players\": {}, \"elements\": {}, "
+                "\"rounds\": {}, \"bytes_send\": {}, \"ms\": {:.3f}, \"max_error\": {:.3g}}}",
+                curve.name, N, D, n_players, elements,
+                total.rounds / repetitions, total.bytes_send / repetitions, elapsed.count() / repetitions, max_error) << std::endl;
+        });
+        if(max_error > std::ldexp(1.0, 4 - int(D))){
+            std::cerr << fmt::format("piecewise_linear {} at {}/{}: off by {}", curve.name, N, D, max_error) << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv){
+    std::size_t n_players = argc > 1 ? std::stoul(argv[1]) : 2;
+    std::size_t elements = argc > 2 ? std::stoul(argv[2]) : 1024;
+    std::size_t repetitions = argc > 3 ? std::stoul(argv[3]) : 3;
+
+    for(auto backend: {MsbBackend::bitwise, MsbBackend::edabit, MsbBackend::dcf}){
+        bench<64>(n_players, elements, repetitions, backend);
+        bench<128>(n_players, elements, repetitions, backend);
+    }
+    for(auto backend: {MsbBackend::edabit, MsbBackend::dcf}){
+        bench_pair<64>(n_players, elements, repetitions, backend);
+        bench_pair<128>(n_players, elements, repetitions, backend);
+    }
+    bool ok = bench_piecewise_linear<64, 16>(n_players, elements, repetitions);
+    ok &= bench_piecewise_linear<128, 12>(n_players, elements, repetitions);
+    return ok ? 0 : 1;
+}
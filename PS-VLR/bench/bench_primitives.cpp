@@ -0,0 +1,307 @@
+// throughput of the datatypes, serialization, randomness and network primitives under the protocols,
+// one json object per line:
+// bench_primitives [group] [elements] [repetitions] [port]
+// group is one of z2, fixed_point, zp, bit_vector, share_vector, serialization, random, network or all (default);
+// the network group runs three players over loopback TCP from port on (default 24000),
+// without shaping and with set_delay / set_bucket
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include "datatypes/Z2k.hpp"
+#include "datatypes/Zp.hpp"
+#include "datatypes/fixed_point.hpp"
+#include "mpc/aes_prg.h"
+#include "mpc/random_generator.h"
+#include "mpc/semi2k/semi2k_sharing.hpp"
+#include "network/multi_party_player.hpp"
+#include "serialization/serialization.hpp"
+#include "tools/bit_vector.hpp"
+#include "tools/thread_pool.h"
+
+namespace {
+
+// keeps the compiler from dropping a result that is never read
+template <typename T>
+void keep(T const& value){
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+// mean milliseconds of one call of f
+template <typename F>
+double time_ms(std::size_t repetitions, F&& f){
+    f();
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t r = 0; r != repetitions; ++r) f();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repetitions;
+}
+
+void report(const std::string& bench, const std::string& op, const std::string& type, std::size_t elements, double ms){
+    std::cout << fmt::format(
+        "{{\"bench\": \"{}\", \"op\": \"{}\", \"type\": \"{}\", \"elements\": {}, \"ms\": {:.4f}, \"ns_per_element\": {:.3f}}}",
+        bench, op, type, elements, ms, ms * 1e6 / elements) << std::endl;
+}
+
+template <size_t K>
+std::vector<UnsignedZ2<K>> random_z2(std::size_t n, std::mt19937_64& g){
+    std::vector<UnsignedZ2<K>> ret(n);
+    for(auto& x: ret){
+        x = UnsignedZ2<K>(g());
+        if constexpr (K > 64) x = (x << 64) + UnsignedZ2<K>(g());
+    }
+    return ret;
+}
+
+template <size_t K>
+void bench_z2(std::size_t n, std::size_t repetitions){
+    std::mt19937_64 g(1);
+    auto a = random_z2<K>(n, g), b = random_z2<K>(n, g);
+    std::vector<UnsignedZ2<K>> c(n);
+    std::vector<SignedZ2<K>> s(a.begin(), a.end());
+    std::vector<SignedZ2<K>> t(n);
+    std::string type = fmt::format("Z2<{}>", K);
+
+    report("z2", "add", type, n, time_ms(repetitions, [&]{ for(std::size_t i = 0; i != n; ++i) c[i] = a[i] + b[i]; keep(c); }));
+    report("z2", "mul", type, n, time_ms(repetitions, [&]{ for(std::size_t i = 0; i != n; ++i) c[i] = a[i] * b[i]; keep(c); }));
+    report("z2", "shl", type, n, time_ms(repetitions, [&]{ for(std::size_t i = 0; i != n; ++i) c[i] = a[i] << 12; keep(c); }));
+    report("z2", "sar", type, n, time_ms(repetitions, [&]{ for(std::size_t i = 0; i != n; ++i) t[i] = s[i] >> 12; keep(t); }));
+}
+
+template <size_t N, size_t D>
+void bench_fixed_point(std::size_t n, std::size_t repetitions){
+    std::mt19937_64 g(2);
+    std::normal_distribution<double> nd(0, 4);
+    std::vector<FixedPoint<N, D>> a(n), b(n), c(n);
+    for(std::size_t i = 0; i != n; ++i){
+        a[i] = FixedPoint<N, D>(nd(g));
+        b[i] = FixedPoint<N, D>(nd(g));
+    }
+    std::string type = fmt::format("FixedPoint<{}, {}>", N, D);
+
+    // the product is truncated by D inside operator*
+    report("fixed_point", "mul_truncate", type, n, time_ms(repetitions, [&]{ for(std::size_t i = 0; i != n; ++i) c[i] = a[i] * b[i]; keep(c); }));
+    report("fixed_point", "add", type, n, time_ms(repetitions, [&]{ for(std::size_t i = 0; i != n; ++i) c[i] = a[i] + b[i]; keep(c); }));
+}
+
+template <size_t N>
+void bench_zp(const mpz_class& modulus, std::size_t n, std::size_t repetitions){
+    Zp<N>::init(modulus);
+    gmp_randclass rng(gmp_randinit_default);
+    rng.seed(3);
+    std::vector<Zp<N>> a(n), b(n), c(n);
+    for(std::size_t i = 0; i != n; ++i){
+        a[i] = Zp<N>(mpz_class(rng.get_z_range(modulus - 1) + 1));
+        b[i] = Zp<N>(mpz_class(rng.get_z_range(modulus - 1) + 1));
+    }
+    std::string type = fmt::format("Zp<{}>", N);
+    Zp<N> one(1UL);
+
+    report("zp", "mul", type, n, time_ms(repetitions, [&]{ for(std::size_t i = 0; i != n; ++i) c[i] = a[i] * b[i]; keep(c); }));
+    report("zp", "inv", type, n, time_ms(repetitions, [&]{ for(std::size_t i = 0; i != n; ++i) c[i] = one / a[i]; keep(c); }));
+}
+
+void bench_bit_vector(std::size_t n, std::size_t repetitions){
+    std::mt19937_64 g(4);
+    BitVector a(n), b(n), d(n), r(n);
+    for(std::size_t i = 0; i != n; ++i){
+        a[i] = g() & 1;
+        b[i] = g() & 1;
+        d[i] = g() & 1;
+    }
+    std::string type = "BitVector";
+
+    // r = (a ^ b) & ~d, once as a single expression template and once eagerly, with a
+    // temporary per operator as without __bitvector_enable_expression_templates__
+    report("bit_vector", "xor_and_not_expression", type, n, time_ms(repetitions, [&]{ r = (a ^ b) & ~d; keep(r); }));
+    report("bit_vector", "xor_and_not_eager", type, n, time_ms(repetitions, [&]{
+        BitVector x(n), nd(n);
+        std::memcpy(x.data(), a.data(), a.size_in_bytes());
+        std::memcpy(nd.data(), d.data(), d.size_in_bytes());
+        x ^= b;
+        nd.invert();
+        x &= nd;
+        r = std::move(x);
+        keep(r);
+    }));
+    report("bit_vector", "xor_in_place", type, n, time_ms(repetitions, [&]{ r ^= a; keep(r); }));
+}
+
+template <size_t K>
+void bench_share_vector(std::size_t n, std::size_t repetitions){
+    std::mt19937_64 g(7);
+    auto za = random_z2<K>(n, g), zb = random_z2<K>(n, g), zc = random_z2<K>(n, g), zd = random_z2<K>(n, g), ze = random_z2<K>(n, g);
+    std::vector<Semi2kSharing<K>> a(za.begin(), za.end()), b(zb.begin(), zb.end()), c(zc.begin(), zc.end()),
+        d(zd.begin(), zd.end()), e(ze.begin(), ze.end()), r(n);
+    std::string type = fmt::format("Semi2kSharing<{}>", K);
+
+    // r = a * b + c * d + e, the local step of a Beaver multiplication, once as a single
+    // expression template and once with a copy per operation as Semi2kContext::add and mult
+    report("share_vector", "mul_add_expression", type, n, time_ms(repetitions, [&]{ assign(r, a * b + c * d + e); keep(r); }));
+    // the same expression in blocks on a pool of all cpus
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    report("share_vector", fmt::format("mul_add_expression_pool{}", pool.size()), type, n, time_ms(repetitions, [&]{ assign(r, a * b + c * d + e, &pool); keep(r); }));
+    report("share_vector", "mul_add_eager", type, n, time_ms(repetitions, [&]{
+        auto ab = a;
+        for(std::size_t i = 0; i != n; ++i) ab[i] *= b[i];
+        auto cd = c;
+        for(std::size_t i = 0; i != n; ++i) cd[i] *= d[i];
+        auto sum = ab;
+        for(std::size_t i = 0; i != n; ++i) sum[i] += cd[i];
+        r = sum;
+        for(std::size_t i = 0; i != n; ++i) r[i] += e[i];
+        keep(r);
+    }));
+}
+
+template <size_t K>
+void bench_serialization(std::size_t n, std::size_t repetitions){
+    std::mt19937_64 g(5);
+    auto values = random_z2<K>(n, g);
+    std::vector<Semi2kSharing<K>> shares(values.begin(), values.end());
+    std::string type = fmt::format("std::vector<Semi2kSharing<{}>>", K);
+
+    report("serialization", "serialize", type, n, time_ms(repetitions, [&]{
+        Serializer sr;
+        sr << shares;
+        auto bytes = sr.finalize();
+        keep(bytes);
+    }));
+    Serializer sr;
+    sr << shares;
+    ByteVector bytes = sr.finalize();
+    report("serialization", "deserialize", type, n, time_ms(repetitions, [&]{
+        ByteVector copy(bytes.data(), bytes.size());
+        auto back = Deserializer(std::move(copy)).get<std::vector<Semi2kSharing<K>>>();
+        keep(back);
+    }));
+}
+
+void bench_random(std::size_t n, std::size_t repetitions){
+    RandomGenerator generator(6);
+    std::vector<std::uint32_t> words(n);
+    report("random", "fill_u32", "RandomGenerator", n, time_ms(repetitions, [&]{
+        for(auto& w: words) w = generator.get_random();
+        keep(words);
+    }));
+
+    // one seed to two blocks per element, as in a DCF key expansion level
+    std::vector<Block> seeds(n), blocks(2 * n);
+    for(std::size_t i = 0; i != n; ++i) seeds[i] = Block{i, 7};
+    report("random", "expand_seed", "AesPrg", n, time_ms(repetitions, [&]{
+        for(std::size_t i = 0; i != n; ++i) AesPrg::local().expand(seeds[i], blocks.data() + 2 * i, 2);
+        keep(blocks);
+    }));
+}
+
+// mbroadcast_recv and mbroadcast_recv_chunked of one message of each size to both peers, on every player
+// false if a player failed, its error is reported on stderr
+bool bench_network(std::size_t repetitions, unsigned short port, const std::string& shaping,
+    std::function<void(network::PlainMultiPartyPlayer&)> shape){
+    constexpr std::size_t n_players = 3;
+    std::vector<std::thread> threads;
+    std::vector<std::string> errors(n_players);
+    for(std::size_t id = 0; id != n_players; ++id){
+        threads.emplace_back([&, id]{
+            try{
+                network::PlainMultiPartyPlayer player(id, n_players);
+                player.run(1);
+                std::vector<boost::asio::ip::tcp::endpoint> endpoints;
+                for(std::size_t i = 0; i != n_players; ++i){
+                    auto address = i == id ? boost::asio::ip::address(boost::asio::ip::address_v4())
+                                           : boost::asio::ip::address(boost::asio::ip::address_v4::loopback());
+                    endpoints.emplace_back(address, port + i);
+                }
+                player.connect(endpoints);
+                shape(player);
+
+                for(std::size_t size: {std::size_t(8), std::size_t(1) << 10, std::size_t(1) << 16, std::size_t(1) << 20, std::size_t(1) << 24}){
+                    double ms = time_ms(repetitions, [&]{
+                        auto messages = player.mbroadcast_recv(player.all_but_me(), ByteVector(size));
+                        keep(messages);
+                    });
+                    // the same, handed out in pieces of 64 KiB as they arrive
+                    double chunked_ms = time_ms(repetitions, [&]{
+                        std::size_t received = 0;
+                        player.mbroadcast_recv_chunked(player.all_but_me(), ByteVector(size), 1 << 16,
+                            [&](playerid_t, ByteVector&& chunk){ received += chunk.size(); });
+                        keep(received);
+                    });
+                    if(id != 0) continue;
+                    for(auto [op, t]: {std::pair{"mbroadcast_recv", ms}, std::pair{"mbroadcast_recv_chunked", chunked_ms}}){
+                        std::cout << fmt::format(
+                            "{{\"bench\": \"network\", \"op\": \"{}\", \"shaping\": \"{}\", \"players\": {}, "
+                            "\"bytes\": {}, \"ms\": {:.4f}, \"gbps\": {:.3f}}}",
+                            op, shaping, n_players, size, t, size * 8 * (n_players - 1) / (t * 1e6)) << std::endl;
+                    }
+                }
+                player.stop();
+            }
+            catch(const std::exception& e){
+                // the peers of a player that fails to connect time out and report as well
+                errors[id] = e.what();
+            }
+        });
+    }
+    for(auto& t: threads) t.join();
+    bool ok = true;
+    for(std::size_t id = 0; id != n_players; ++id){
+        if(errors[id].empty()) continue;
+        std::cerr << fmt::format("network ({}): player {} failed: {}", shaping, id, errors[id]) << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv){
+    std::string group = argc > 1 ? argv[1] : "all";
+    std::size_t elements = argc > 2 ? std::stoul(argv[2]) : 1 << 16;
+    std::size_t repetitions = argc > 3 ? std::stoul(argv[3]) : 5;
+    unsigned short port = argc > 4 ? std::stoi(argv[4]) : 24000;
+    auto selected = [&](const char* name){ return group == "all" || group == name; };
+
+    if(selected("z2")){
+        bench_z2<64>(elements, repetitions);
+        bench_z2<128>(elements, repetitions);
+    }
+    if(selected("fixed_point")){
+        bench_fixed_point<64, 16>(elements, repetitions);
+        bench_fixed_point<128, 12>(elements, repetitions);
+        bench_fixed_point<128, 20>(elements, repetitions);
+    }
+    if(selected("zp")){
+        bench_zp<61>((mpz_class(1) << 61) - 1, elements, repetitions);
+        bench_zp<127>((mpz_class(1) << 127) - 1, elements, repetitions);
+    }
+    if(selected("bit_vector")){
+        bench_bit_vector(elements * 64, repetitions);
+    }
+    if(selected("share_vector")){
+        bench_share_vector<64>(elements, repetitions);
+        bench_share_vector<128>(elements, repetitions);
+    }
+    if(selected("serialization")){
+        bench_serialization<64>(elements, repetitions);
+        bench_serialization<128>(elements, repetitions);
+    }
+    if(selected("random")){
+        bench_random(elements, repetitions);
+    }
+    bool ok = true;
+    if(selected("network")){
+        using namespace std::chrono_literals;
+        ok &= bench_network(repetitions, port, "none", [](auto&){});
+        ok &= bench_network(repetitions, port + 10, "delay_1ms", [](auto& player){ player.set_delay(player.all_but_me(), 1ms); });
+        ok &= bench_network(repetitions, port + 20, "bucket_1gbps", [](auto& player){ player.set_bucket(player.all_but_me(), network::GigaBitsPerSecond(1), 1 << 20); });
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Run full training over a grid of sizes, client counts and network profiles.
+
+For every combination of --rows, --clients and --profiles a synthetic dataset
+is written with gen_synthetic.py (and reused by later runs), one test process
+per client connects over loopback TCP, with the profile as link_profile of the
+network file, and the --stats-file of every client is collected. Shared
+mode runs share_data, keygen, triple_gen and train; --hybrid runs
+share_partition and train.
+
+Prints one json object per run and phase: the wall time and rounds of the
+slowest client and the bytes sent by all clients together. The phase "total"
+is the wall time of the whole run including the staggered process start and
+data loading.
+Arguments after -- are passed to every test process, e.g. -- --ring 64
+--precision 16 --dealer-seed 1.
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from gen_synthetic import generate  # noqa: E402
+
+def int_list(s):
+    return [int(x) for x in s.split(",")]
+
+
+def write_network_file(path, clients, port, profile):
+    with open(path, "w") as f:
+        f.write(f"link_profile = {profile}\n")
+        for i in range(clients):
+            f.write(f"party_{i}_ip = 127.0.0.1\n")
+        for i in range(clients):
+            f.write(f"party_{i}_port = {port + 20 * i}\n")
+
+
+def run(args, extra, rows, clients, profile, port):
+    name = f"r{rows}_c{clients}_f{args.features}_s{args.sparsity}{'_b' if args.binary_features else ''}_seed{args.seed}"
+    data_dir = os.path.join(args.work_dir, name)
+    if not os.path.exists(os.path.join(data_dir, f"client_{clients - 1}.txt")):
+        generate(data_dir, rows, clients, args.features, args.sparsity, args.binary_features, 0, args.seed)
+
+    run_dir = os.path.join(args.work_dir, f"{name}_{profile}")
+    os.makedirs(run_dir, exist_ok=True)
+    network_file = os.path.join(run_dir, "network.txt")
+    write_network_file(network_file, clients, port, profile)
+
+    stats = os.path.join(run_dir, "stats_{}.json")
+    start = time.monotonic()
+    procs = []
+    for i in range(clients):
+        cmd = [args.binary, "--client-id", str(i), "--client-num", str(clients),
+               "--network-file", network_file,
+               "--data-file", os.path.join(data_dir, f"client_{i}.txt"),
+               "--stats-file", stats]
+        if args.hybrid:
+            cmd.append("--hybrid")
+        log = open(os.path.join(run_dir, f"client_{i}.log"), "w")
+        procs.append((subprocess.Popen(cmd + extra, stdout=log, stderr=subprocess.STDOUT), log))
+        # connect retries a refused connection for about 2 s, the lower ids listen by then
+        time.sleep(args.stagger)
+
+    failed = False
+    for proc, log in procs:
+        try:
+            failed |= proc.wait(timeout=args.timeout) != 0
+        except subprocess.TimeoutExpired:
+            failed = True
+        log.close()
+    if failed:
+        for proc, _ in procs:
+            proc.kill()
+        print(f"run {name} {profile} failed, see {run_dir}", file=sys.stderr)
+        return []
+    elapsed = time.monotonic() - start
+
+    phases = {}
+    for i in range(clients):
+        with open(stats.format(i)) as f:
+            for tag, record in json.load(f)["phases"].items():
+                p = phases.setdefault(tag, {"wall_us": 0, "rounds": 0, "bytes_send": 0})
+                p["wall_us"] = max(p["wall_us"], record["wall_us"])
+                p["rounds"] = max(p["rounds"], record["rounds"])
+                p["bytes_send"] += record["bytes_send"]
+    phases["total"] = {"wall_us": int(elapsed * 1e6), "rounds": sum(p["rounds"] for p in phases.values()),
+                       "bytes_send": sum(p["bytes_send"] for p in phases.values())}
+
+    base = {"mode": "hybrid" if args.hybrid else "shared", "rows": rows, "clients": clients,
+            "features": args.features, "sparsity": args.sparsity, "profile": profile}
+    return [dict(base, phase=tag, **record) for tag, record in sorted(phases.items())]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--binary", default="build/test", help="the test executable")
+    parser.add_argument("--rows", type=int_list, default=[1024, 8192, 65536])
+    parser.add_argument("--clients", type=int_list, default=[2, 3, 4])
+    parser.add_argument("--features", default="16", help="features per client, see gen_synthetic.py")
+    parser.add_argument("--sparsity", type=float, default=0.0)
+    parser.add_argument("--binary-features", action="store_true", help="one-hot like 0/1 features")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--profiles", default="none,LAN-10G,WAN-100M-50ms",
+                        help="comma separated network profiles of test, see --network-profile")
+    parser.add_argument("--hybrid", action="store_true", help="train in hybrid mode")
+    parser.add_argument("--work-dir", default="scaling", help="datasets, stats and logs")
+    parser.add_argument("--port", type=int, default=7000, help="first port, each run moves up by 200")
+    parser.add_argument("--timeout", type=float, default=3600, help="seconds per run")
+    parser.add_argument("--stagger", type=float, default=0.5, help="seconds between starting two clients")
+    parser.add_argument("-o", "--output", help="append the json lines to this file as well")
+    argv = sys.argv[1:]
+    extra = []
+    if "--" in argv:
+        extra = argv[argv.index("--") + 1:]
+        argv = argv[:argv.index("--")]
+    args = parser.parse_args(argv)
+
+    profiles = args.profiles.split(",")
+    out = open(args.output, "a") if args.output else None
+    port = args.port
+    for rows in args.rows:
+        for clients in args.clients:
+            for profile in profiles:
+                for line in run(args, extra, rows, clients, profile, port):
+                    text = json.dumps(line)
+                    print(text, flush=True)
+                    if out:
+                        out.write(text + "\n")
+                port += 200
+    if out:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
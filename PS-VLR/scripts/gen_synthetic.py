@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Write a deterministic synthetic dataset, vertically split into client files.
+
+Every row draws its features from the seed alone, so the same arguments always
+give the same files. A zero is drawn with probability --sparsity, other entries
+are uniform in [-1, 1] or 1 with --binary. The label is 1 with probability
+sigmoid(x . w) for a hidden weight vector w over all features and is written as
+the last column of the label party's file, in the format of data/chess:
+OUT/client_<i>.txt, one comma separated row per sample.
+"""
+import argparse
+import math
+import os
+import random
+
+
+def feature_counts(spec, clients):
+    """'16' gives every client 16 features, '8,16,16' lists them per client"""
+    counts = [int(c) for c in str(spec).split(",")]
+    if len(counts) == 1:
+        counts *= clients
+    if len(counts) != clients:
+        raise ValueError(f"{len(counts)} feature counts for {clients} clients")
+    return counts
+
+
+def generate(out, rows, clients, features=16, sparsity=0.0, binary=False, label_party=0, seed=1):
+    counts = feature_counts(features, clients)
+    if not 0 <= label_party < clients:
+        raise ValueError(f"label party {label_party} out of range")
+    if not 0 <= sparsity < 1:
+        raise ValueError("sparsity must be in [0, 1)")
+
+    rng = random.Random(seed)
+    total = sum(counts)
+    # the logit keeps about the same spread whatever the width and sparsity
+    scale = 2 / math.sqrt(max(1.0, total * (1 - sparsity)))
+    weights = [rng.gauss(0, scale) for _ in range(total)]
+
+    os.makedirs(out, exist_ok=True)
+    files = [open(os.path.join(out, f"client_{i}.txt"), "w") for i in range(clients)]
+    try:
+        for _ in range(rows):
+            row = []
+            for _ in range(total):
+                if rng.random() < sparsity:
+                    row.append(0)
+                else:
+                    row.append(1 if binary else round(rng.uniform(-1, 1), 4))
+            logit = sum(w * x for w, x in zip(weights, row))
+            label = int(rng.random() < 1 / (1 + math.exp(-logit)))
+
+            first = 0
+            for i, count in enumerate(counts):
+                cols = row[first:first + count]
+                first += count
+                if i == label_party:
+                    cols = cols + [label]
+                files[i].write(",".join(map(str, cols)) + "\n")
+    finally:
+        for f in files:
+            f.close()
+    return [os.path.join(out, f"client_{i}.txt") for i in range(clients)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("out", help="output directory")
+    parser.add_argument("--rows", type=int, default=10000)
+    parser.add_argument("--clients", type=int, default=4)
+    parser.add_argument("--features", default="16", help="features per client, one count or a comma separated list")
+    parser.add_argument("--sparsity", type=float, default=0.0, help="probability of a zero entry")
+    parser.add_argument("--binary", action="store_true", help="nonzero entries are 1, as in one-hot data")
+    parser.add_argument("--label-party", type=int, default=0,
+                        help="client whose file holds the labels, test expects client 0")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    generate(args.out, args.rows, args.clients, args.features, args.sparsity, args.binary, args.label_party, args.seed)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+"""Merge per-party trace files written with --trace-file into one trace.
+
+Every party stamps its events in microseconds since the unix epoch, so merging
+is a concatenation. Timestamps are shifted so that the earliest event starts
+at zero, and --offset PARTY:US corrects a known clock skew of one party.
+"""
+import argparse
+import json
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("traces", nargs="+", help="per-party trace files")
+    parser.add_argument("-o", "--output", default="trace_merged.json")
+    parser.add_argument("--offset", action="append", default=[],
+                        help="PARTY:US, microseconds added to the party's timestamps")
+    args = parser.parse_args()
+
+    offsets = {}
+    for item in args.offset:
+        party, us = item.split(":")
+        offsets[int(party)] = int(us)
+
+    events = []
+    for path in args.traces:
+        with open(path) as f:
+            trace = json.load(f)
+        party = trace["otherData"]["party"]
+        for e in trace["traceEvents"]:
+            if "ts" in e:
+                e["ts"] += offsets.get(party, 0)
+            events.append(e)
+
+    origin = min(e["ts"] for e in events if "ts" in e)
+    for e in events:
+        if "ts" in e:
+            e["ts"] -= origin
+
+    with open(args.output, "w") as f:
+        json.dump({"displayTimeUnit": "ms", "traceEvents": events}, f)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,14 +1,17 @@
 #include "client.hpp"
 #include "openfhe.h"
 #include "../config/config.h"
+#include "../datatypes/fixed_point_codec.hpp"
+#include <bit>
 #include <cstdlib>
 #include <string>
 
 
 using std::string, std::vector, std::shared_ptr;
 
-Client::Client(int param_client_id, int param_client_num, int param_has_label,
-                FSemi2kContext<128, 12>& sc, std::string param_local_data_file, mplayerid_t parties,
+template <size_t N, size_t D>
+Client<N, D>::Client(int param_client_id, int param_client_num, int param_has_label,
+                FSemi2kContext<N, D>& sc, std::string param_local_data_file, mplayerid_t parties,
                 playerid_t id, network::MultiPartyPlayer* mplayer)
                 :parties(parties), id(id), mplayer(mplayer), sc(sc) {
 
@@ -16,6 +19,7 @@ Client::Client(int param_client_id, int param_client_num, int param_has_label,
     client_num = param_client_num;
     has_label = param_has_label == 1;
 
+    std::vector<std::vector<double>> data;
     std::ifstream data_infile(param_local_data_file);
     std::string line;
     while (std::getline(data_infile, line)) {
@@ -26,9 +30,30 @@ Client::Client(int param_client_id, int param_client_num, int param_has_label,
         {
             items.push_back(::atof(item.c_str()));
         }
-        local_data.push_back(items);
+        data.push_back(items);
     }
     data_infile.close();
+    load_local_data(std::move(data));
+}
+
+template <size_t N, size_t D>
+Client<N, D>::Client(int param_client_id, int param_client_num, int param_has_label,
+                FSemi2kContext<N, D>& sc, std::vector<std::vector<double>> param_local_data, mplayerid_t parties,
+                playerid_t id, network::MultiPartyPlayer* mplayer)
+                :parties(parties), id(id), mplayer(mplayer), sc(sc) {
+
+    client_id = param_client_id;
+    client_num = param_client_num;
+    has_label = param_has_label == 1;
+    load_local_data(std::move(param_local_data));
+}
+
+template <size_t N, size_t D>
+void Client<N, D>::load_local_data(std::vector<std::vector<double>>&& data){
+    local_data = std::move(data);
+    if (local_data.empty()) {
+        throw std::runtime_error("empty local data");
+    }
     sample_num = local_data.size();
     feature_num = local_data[0].size();
     if (has_label) {
@@ -41,10 +66,28 @@ Client::Client(int param_client_id, int param_client_num, int param_has_label,
     
 }
 
-Client::~Client(){
+template <size_t N, size_t D>
+void Client<N, D>::to_sparse(){
+    local_sparse = SparseRows<double>::from_dense(local_data);
+    local_data.clear();
+    local_data.shrink_to_fit();
+}
+
+template <size_t N, size_t D>
+Client<N, D>::Client(const Client& other, FSemi2kContext<N, D>& sc, network::MultiPartyPlayer* mplayer)
+                :client_id(other.client_id), client_num(other.client_num), has_label(other.has_label),
+                sample_num(other.sample_num), feature_num(other.feature_num),
+                cc(other.cc), sk(other.sk), pk(other.pk), batchsize(other.batchsize), sc(sc),
+                parties(other.parties), id(other.id), mplayer(mplayer) {
 }
 
-void Client::initialize_keys(unsigned int init_size, unsigned int dcrtBits, unsigned int batchSize) {
+template <size_t N, size_t D>
+Client<N, D>::~Client(){
+}
+
+template <size_t N, size_t D>
+void Client<N, D>::initialize_keys(unsigned int init_size, unsigned int dcrtBits, unsigned int batchSize) {
+    network::PhaseGuard phase(mplayer->phases(), "keygen");
 
     std::string msg;
 
@@ -216,20 +259,30 @@ void Client::initialize_keys(unsigned int init_size, unsigned int dcrtBits, unsi
 
 }
 
-Plaintext Client::encode(const std::vector<double> &vec){
+template <size_t N, size_t D>
+Plaintext Client<N, D>::encode(const std::vector<double> &vec){
     return cc->MakeCKKSPackedPlaintext(vec);
 }
 
-Ciphertext<DCRTPoly> Client::encrypt(const Plaintext &plaintext){
+template <size_t N, size_t D>
+Ciphertext<DCRTPoly> Client<N, D>::encrypt(const Plaintext &plaintext){
+    trace::Scope scope("encrypt", trace::he);
+    if(auto cost = sc.get_cost_model()) cost->he_encrypt += 1;
+    if(sc.is_symbolic()) return nullptr;
     return cc->Encrypt(pk, plaintext);
 }
 
-Ciphertext<DCRTPoly> Client::encrypt(const std::vector<double> &vec){
+template <size_t N, size_t D>
+Ciphertext<DCRTPoly> Client<N, D>::encrypt(const std::vector<double> &vec){
+    if(sc.is_symbolic()) return encrypt(Plaintext());
     Plaintext plaintext = encode(vec);
     return encrypt(plaintext);
 }
 
-Plaintext Client::thres_decrypt(const Ciphertext<DCRTPoly>& ciphertext, int to){
+template <size_t N, size_t D>
+Plaintext Client<N, D>::thres_decrypt(const Ciphertext<DCRTPoly>& ciphertext, int to){
+    network::PhaseGuard phase(mplayer->phases(), "thres_decrypt");
+    if(auto cost = sc.get_cost_model()) cost->he_decrypt += 2;
     Plaintext res;
     std::string msg;
     msg = serialize(ciphertext);
@@ -239,7 +292,10 @@ Plaintext Client::thres_decrypt(const Ciphertext<DCRTPoly>& ciphertext, int to){
         }
     }
 
-    auto ciphertextPartial = cc->MultipartyDecryptLead({ciphertext}, sk);
+    auto ciphertextPartial = [&]{
+        trace::Scope scope("decrypt_lead", trace::he);
+        return cc->MultipartyDecryptLead({ciphertext}, sk);
+    }();
     vector<Ciphertext<DCRTPoly>> partialCiphertextVec;
     partialCiphertextVec.push_back(ciphertextPartial[0]);
     for(int i = 0; i != client_num; ++i){
@@ -251,17 +307,26 @@ Plaintext Client::thres_decrypt(const Ciphertext<DCRTPoly>& ciphertext, int to){
         }
     }
 
-    cc->MultipartyDecryptFusion(partialCiphertextVec, &res);
+    {
+        trace::Scope scope("decrypt_fusion", trace::he);
+        cc->MultipartyDecryptFusion(partialCiphertextVec, &res);
+    }
     return res;
 }
 
-void Client::thres_decrypt(int to){
+template <size_t N, size_t D>
+void Client<N, D>::thres_decrypt(int to){
+    network::PhaseGuard phase(mplayer->phases(), "thres_decrypt");
+    if(auto cost = sc.get_cost_model()) cost->he_decrypt += 1;
     std::string msg;
     Ciphertext<DCRTPoly> ciphertext;
     recv_message(to, msg);
     deserialize(ciphertext, msg);
 
-    auto ciphertextPartial = cc->MultipartyDecryptMain( {ciphertext}, sk);
+    auto ciphertextPartial = [&]{
+        trace::Scope scope("decrypt_main", trace::he);
+        return cc->MultipartyDecryptMain( {ciphertext}, sk);
+    }();
     msg = serialize(ciphertextPartial);
     send_message(to, msg);
     deserialize(ciphertextPartial, msg);
@@ -269,15 +334,33 @@ void Client::thres_decrypt(int to){
 
 }
 
-std::vector<double> Client::homo2share(int from, Ciphertext<DCRTPoly> c, int size){
-    if(c == nullptr){
+template <size_t N, size_t D>
+std::vector<double> Client<N, D>::homo2share(int from, Ciphertext<DCRTPoly> c, int size){
+    if(sc.is_symbolic()){
+        auto& cost = *sc.get_cost_model();
+        size_t peers = client_num - 1;
+        if(client_id == from){
+            cost.he_ciphertexts_recv += 2 * peers;
+            cost.he_ciphertexts_send += peers;
+            cost.he_eval_add += peers;
+            cost.he_decrypt += 2;
+        }
+        else{
+            cost.he_encrypt += 1;
+            cost.he_ciphertexts_send += 2;
+            cost.he_ciphertexts_recv += 1;
+            cost.he_decrypt += 1;
+        }
+        return std::vector<double>(size, 0);
+    }
+    if(client_id != from){
         std::string msg;
         recv_message(from, msg);
         size = std::stoi(msg);
         vector<double> r(size);
         for(auto& x: r){
-            int tmp = rand()%SHARING_RING_SIZE;
-            x = double(tmp) / (1 << SHARING_DECIMAL_LEN);
+            int tmp = rand();
+            x = double(tmp) / (1UL << D);
         }
         auto cR = encrypt(r);
         send_message(from, serialize(cR));
@@ -309,7 +392,20 @@ std::vector<double> Client::homo2share(int from, Ciphertext<DCRTPoly> c, int siz
     }
 }
 
-Ciphertext<DCRTPoly> Client::share2homo(const std::vector<double>& vec, int to){
+template <size_t N, size_t D>
+Ciphertext<DCRTPoly> Client<N, D>::share2homo(const std::vector<double>& vec, int to){
+    if(sc.is_symbolic()){
+        auto& cost = *sc.get_cost_model();
+        if(client_id != to){
+            encrypt(vec);
+            cost.he_ciphertexts_send += 1;
+        }
+        else{
+            cost.he_ciphertexts_recv += client_num - 1;
+            cost.he_eval_add += client_num - 1;
+        }
+        return nullptr;
+    }
     if(client_id != to){
         Ciphertext<DCRTPoly> c = encrypt(vec);
         send_message(to, serialize(c));
@@ -335,24 +431,101 @@ Ciphertext<DCRTPoly> Client::share2homo(const std::vector<double>& vec, int to){
     }
 }
 
-std::vector<double> Client::share2double(const std::vector<FSemi2kSharing<128, 12>>& vec){
-    std::vector<double> ret(vec.size());
-    for(int i = 0; i != vec.size(); ++i){
-        ret[i] = std::stod(vec[i].get_data().to_string()) / (1 << 12);
+template <size_t N, size_t D>
+Ciphertext<DCRTPoly> Client<N, D>::share2homo(const std::vector<FSemi2kSharing<N, D>>& vec, int to){
+    // to ends up with vec minus the masks, as small as the value itself plus the masks
+    std::vector<double> small(vec.size());
+    if(client_id != to){
+        std::vector<FSemi2kSharing<N, D>> masked(vec.size());
+        for(int i = 0; i != vec.size(); ++i){
+            small[i] = double(rand()) / (1UL << D);
+            masked[i] = vec[i] - FSemi2kSharing<N, D>(small[i]);
+        }
+        Serializer sr;
+        sr << masked;
+        mplayer->send(to, sr.finalize());
     }
+    else{
+        std::vector<FSemi2kSharing<N, D>> sum = vec;
+        for(int i = 0; i != client_num; ++i){
+            if(i != client_id){
+                std::vector<FSemi2kSharing<N, D>> masked;
+                Deserializer dr(mplayer->recv(i));
+                dr >> masked;
+                for(int j = 0; j != sum.size(); ++j) sum[j] += masked[j];
+            }
+        }
+        small = share2double(sum);
+    }
+    return share2homo(small, to);
+}
+
+template <size_t N, size_t D>
+Ciphertext<DCRTPoly> Client<N, D>::broadcast(const Ciphertext<DCRTPoly>& c, int from){
+    if(sc.is_symbolic()){
+        auto& cost = *sc.get_cost_model();
+        if(client_id == from) cost.he_ciphertexts_send += client_num - 1;
+        else cost.he_ciphertexts_recv += 1;
+        return nullptr;
+    }
+    if(client_id == from){
+        std::string msg = serialize(c);
+        for(int i = 0; i != client_num; ++i){
+            if(i != client_id){
+                send_message(i, msg);
+            }
+        }
+        return c;
+    }
+    std::string msg;
+    Ciphertext<DCRTPoly> ret;
+    recv_message(from, msg);
+    deserialize(ret, msg);
     return ret;
 }
 
-std::vector<FSemi2kSharing<128, 12>> Client::double2share(const std::vector<double>& vec){
-    std::vector<FSemi2kSharing<128, 12>> ret(vec.size());
-    for(int i = 0; i != vec.size(); ++i){
-        ret[i] = vec[i];
+template <size_t N, size_t D>
+Ciphertext<DCRTPoly> Client<N, D>::inner_products(const std::vector<std::vector<double>>& rows, const Ciphertext<DCRTPoly>& c){
+    trace::Scope scope("inner_products", trace::he);
+    if(auto cost = sc.get_cost_model()){
+        for(const auto& row: rows){
+            cost->he_eval_mult += 2;
+            cost->he_eval_rotate += std::bit_width(std::bit_ceil(row.size())) - 1;
+        }
+        cost->he_eval_add += rows.size();
     }
+    if(sc.is_symbolic()) return nullptr;
+
+    std::vector<Ciphertext<DCRTPoly>> cs(rows.size());
+    parallel_for(sc.get_thread_pool(), rows.size(), 1, [&](size_t begin, size_t end){
+        for(size_t j = begin; j != end; ++j){
+            // the inner sum lands in every slot, keep slot j only
+            auto ip = cc->EvalInnerProduct(c, encode(rows[j]), std::bit_ceil(rows[j].size()));
+            std::vector<double> mask(j + 1, 0);
+            mask[j] = 1;
+            cs[j] = cc->EvalMult(ip, encode(mask));
+        }
+    });
+    return cc->EvalAddMany(cs);
+}
+
+template <size_t N, size_t D>
+std::vector<double> Client<N, D>::share2double(const std::vector<FSemi2kSharing<N, D>>& vec){
+    std::vector<double> ret(vec.size());
+    fixed_point_codec::decode<N, D>(std::span(vec), std::span(ret));
+    return ret;
+}
+
+template <size_t N, size_t D>
+std::vector<FSemi2kSharing<N, D>> Client<N, D>::double2share(const std::vector<double>& vec){
+    std::vector<FSemi2kSharing<N, D>> ret(vec.size());
+    fixed_point_codec::encode<N, D>(vec, std::span(ret));
     return ret;
 }
 
-std::vector<std::vector<Semi2kSharing<128UL>>> double_matrix_to_Z128_matrix(const std::vector<std::vector<double>>& m){
-    std::vector<std::vector<Semi2kSharing<128UL>>> ret(m.size());
+template <size_t N>
+std::vector<std::vector<Semi2kSharing<N>>> double_matrix_to_ring_matrix(const std::vector<std::vector<double>>& m){
+    std::vector<std::vector<Semi2kSharing<N>>> ret(m.size());
     for(int i = 0; i != ret.size(); ++i){
         ret[i].resize(m[i].size());
         for(int j = 0; j != ret[i].size(); ++j){
@@ -362,86 +535,201 @@ std::vector<std::vector<Semi2kSharing<128UL>>> double_matrix_to_Z128_matrix(cons
     return ret;
 }
 
-std::vector<Semi2kSharing<128UL>> double_vector_to_Z128_vector(const std::vector<double>& m){
-    std::vector<Semi2kSharing<128UL>> ret(m.size());
+template <size_t N>
+std::vector<Semi2kSharing<N>> double_vector_to_ring_vector(const std::vector<double>& m){
+    std::vector<Semi2kSharing<N>> ret(m.size());
     for(int i = 0; i != ret.size(); ++i){
         ret[i] = m[i];
     }
     return ret;
 }
 
-void Client::generate_matrix_triple(const std::vector<std::vector<std::vector<double>>>& U, size_t num, int num_blocks, int n, int m){
+template <size_t N, size_t D>
+void Client<N, D>::generate_matrix_triple(const std::vector<std::vector<std::vector<double>>>& U, size_t num, int num_blocks, int n, int m){
+    network::PhaseGuard phase(mplayer->phases(), "triple_gen");
+    if(sc.is_symbolic()){
+        count_matrix_triple(num, num_blocks, n, m);
+        return;
+    }
 
-    std::vector<FSemi2kContext<128, 12>::MatrixTripleSeries> matrix;
+    std::vector<typename FSemi2kContext<N, D>::MatrixTripleSeries> matrix;
 
     matrix.resize(num_blocks);
     for(int l = 0; l != num_blocks; ++l){
         std::cout << l << std::endl;
-        std::vector<std::vector<double>> Ui(U[l]), Ui_transpose(m);
-        matrix[l].U = double_matrix_to_Z128_matrix(Ui);
-        for(int i = 0; i != m; ++i){
-            Ui_transpose[i].resize(n, 0);
-            for(int j = 0; j != n; ++j){
-                Ui_transpose[i][j] = Ui[j][i];
-            }
-        }
-
-        std::vector<Ciphertext<DCRTPoly>> c_U_transpose(m);
-        for(int i = 0 ; i!= c_U_transpose.size(); ++i){
-            c_U_transpose[i] = share2homo(Ui_transpose[i], SUPER_CLIENT_ID);
-        }
+        matrix[l].U = double_matrix_to_ring_matrix<N>(U[l]);
+        auto c_U_transpose = encrypt_matrix_mask(U[l], n, m);
         
         for(int h = 0; h != num; ++h){
             std::cout << h << std::endl;
-            std::vector<double> Vi(m), UVi(n);
-            for(int i  = 0; i != Vi.size(); ++i){
-                Vi[i] = sc.randomGenerator.get_random();
-            }
+            auto triple = produce_matrix_triple(c_U_transpose, n, m, sc.randomGenerator);
+            matrix[l].Vs.emplace_back(std::move(triple.V));
+            matrix[l].UVs.emplace_back(std::move(triple.UV));
+        }   
+    }
+    sc.set_matrix_triple(matrix, n, m);
+}
 
-            matrix[l].Vs.emplace_back(double_vector_to_Z128_vector(Vi));
-            for(int i = 0; i != UVi.size(); ++i){
-                UVi[i] = sc.randomGenerator.get_random();
-            }
+template <size_t N, size_t D>
+std::vector<Ciphertext<DCRTPoly>> Client<N, D>::encrypt_matrix_mask(const std::vector<std::vector<double>>& U, int n, int m){
+    std::vector<std::vector<double>> U_transpose(m);
+    for(int i = 0; i != m; ++i){
+        U_transpose[i].resize(n, 0);
+        for(int j = 0; j != n; ++j){
+            U_transpose[i][j] = U[j][i];
+        }
+    }
+
+    std::vector<Ciphertext<DCRTPoly>> c_U_transpose(m);
+    for(int i = 0 ; i!= c_U_transpose.size(); ++i){
+        c_U_transpose[i] = share2homo(U_transpose[i], SUPER_CLIENT_ID);
+    }
+    return c_U_transpose;
+}
 
-            matrix[l].Vs.emplace_back(double_vector_to_Z128_vector(Vi));
+template <size_t N, size_t D>
+typename MatrixTriplePool<N>::Triple Client<N, D>::produce_matrix_triple(const std::vector<Ciphertext<DCRTPoly>>& c_U_transpose, int n, int m, RandomGenerator& rng){
+    typename MatrixTriplePool<N>::Triple triple;
 
-            std::vector<Ciphertext<DCRTPoly>> c_V(m);
-            for(int i = 0 ; i!= c_U_transpose.size(); ++i){
-                std::vector<double> tmp(n, Vi[i]);
-                c_V[i] = share2homo(tmp, SUPER_CLIENT_ID);
-            }
+    std::vector<double> Vi(m), UVi(n);
+    for(int i  = 0; i != Vi.size(); ++i){
+        Vi[i] = rng.get_random();
+    }
+    for(int i = 0; i != UVi.size(); ++i){
+        UVi[i] = rng.get_random();
+    }
+    triple.V = double_vector_to_ring_vector<N>(Vi);
+
+    std::vector<Ciphertext<DCRTPoly>> c_V(m);
+    for(int i = 0 ; i!= c_U_transpose.size(); ++i){
+        std::vector<double> tmp(n, Vi[i]);
+        c_V[i] = share2homo(tmp, SUPER_CLIENT_ID);
+    }
 
-            Ciphertext<DCRTPoly> c_UV = share2homo(UVi, SUPER_CLIENT_ID);
-            if(client_id == SUPER_CLIENT_ID){
-                std::vector<Ciphertext<DCRTPoly>> tmp(m + 1);
-                for(int i = 0; i !=m; ++i){
+    Ciphertext<DCRTPoly> c_UV = share2homo(UVi, SUPER_CLIENT_ID);
+    std::vector<double> ret(n);
+    if(client_id == SUPER_CLIENT_ID){
+        std::vector<Ciphertext<DCRTPoly>> tmp(m + 1);
+        if(auto cost = sc.get_cost_model()) cost->he_eval_mult += m;
+        {
+            // the tracer is per thread, one event for the whole batch
+            trace::Scope scope("EvalMult", trace::he);
+            parallel_for(sc.get_thread_pool(), m, 1, [&](size_t begin, size_t end){
+                for(size_t i = begin; i != end; ++i){
                     tmp[i] = cc->EvalMult(c_V[i], c_U_transpose[i]);
                 }
+            });
+        }
 
-                tmp[m] = c_UV;
+        tmp[m] = c_UV;
 
-                Ciphertext<DCRTPoly> c_UVi = cc->EvalAddMany(tmp);
-                auto UVi_transpose = thres_decrypt(c_UVi);
-                UVi_transpose->SetLength(n);
-                std::vector<double> ret(n);
-                for(int i = 0; i != n; ++i){
-                    ret[i] = UVi_transpose->GetRealPackedValue()[i] - UVi[i];
-                }
+        Ciphertext<DCRTPoly> c_UVi = cc->EvalAddMany(tmp);
+        auto UVi_transpose = thres_decrypt(c_UVi);
+        UVi_transpose->SetLength(n);
+        for(int i = 0; i != n; ++i){
+            ret[i] = UVi_transpose->GetRealPackedValue()[i] - UVi[i];
+        }
+    }
+    else{
+        thres_decrypt();
+        for(int i = 0; i != n; ++i){
+            ret[i] = - UVi[i];
+        }
+    }
+    triple.UV = double_vector_to_ring_vector<N>(ret);
+    return triple;
+}
 
-                matrix[l].UVs.emplace_back(double_vector_to_Z128_vector(ret));
+template <size_t N, size_t D>
+void Client<N, D>::start_matrix_triple_producer(MatrixTriplePool<N>& pool, network::MultiPartyPlayer* offline_player,
+        const std::vector<MatrixTripleShape>& shapes, size_t num, int num_blocks, long seed){
+    if(sc.is_symbolic()){
+        for(const auto& shape: shapes){
+            count_matrix_triple(num, num_blocks, shape.n, shape.m);
+        }
+        return;
+    }
+
+    for(const auto& shape: shapes){
+        std::vector<typename FSemi2kContext<N, D>::MatrixTripleSeries> matrix(num_blocks);
+        for(int l = 0; l != num_blocks; ++l){
+            matrix[l].U = double_matrix_to_ring_matrix<N>(shape.U[l]);
+        }
+        sc.set_matrix_triple(matrix, shape.n, shape.m);
+        pool.reserve(shape.n, shape.m, num_blocks);
+    }
+    sc.set_matrix_triple_pool(&pool);
+
+    // the producer counts into a cost model of its own while the party thread counts into sc's
+    auto offline_cost = std::make_shared<CostModel>();
+    if(auto cost = sc.get_cost_model()){
+        offline_cost->ciphertext_bytes = cost->ciphertext_bytes;
+        pool.on_join([cost, offline_cost](){ *cost += *offline_cost; });
+    }
+
+    pool.run([this, &pool, offline_player, offline_cost, shapes, num, num_blocks, seed](){
+        // nothing of sc is shared with the party thread, e.g. its thread pool: the offline
+        // context has none and runs on the background_threads OpenMP threads of the producer init
+        Semi2kContext<N> offline_base(offline_player, parties, id, seed);
+        if(sc.get_cost_model()) offline_base.set_cost_model(offline_cost.get());
+        FSemi2kContext<N, D> offline_sc(offline_base);
+        Client offline(*this, offline_sc, offline_player);
+        RandomGenerator rng(seed);
+        network::PhaseGuard phase(offline_player->phases(), "triple_gen");
+
+        // the masks first, they are fixed for the whole run
+        std::vector<std::vector<std::vector<Ciphertext<DCRTPoly>>>> c_U_transpose(shapes.size());
+        for(int s = 0; s != shapes.size(); ++s){
+            c_U_transpose[s].resize(num_blocks);
+            for(int l = 0; l != num_blocks; ++l){
+                c_U_transpose[s][l] = offline.encrypt_matrix_mask(shapes[s].U[l], shapes[s].n, shapes[s].m);
             }
-            else{
-                thres_decrypt();
-                std::vector<double> ret(n);
-                for(int i = 0; i != n; ++i){
-                    ret[i] = - UVi[i];
+        }
+
+        for(size_t h = 0; h != num; ++h){
+            for(int l = 0; l != num_blocks; ++l){
+                for(int s = 0; s != shapes.size(); ++s){
+                    const auto& shape = shapes[s];
+                    pool.push(shape.n, shape.m, l, offline.produce_matrix_triple(c_U_transpose[s][l], shape.n, shape.m, rng));
                 }
-                matrix[l].UVs.emplace_back(double_vector_to_Z128_vector(ret));
-                
             }
-            
+        }
+    });
+}
 
-        }   
+template <size_t N, size_t D>
+void Client<N, D>::count_matrix_triple(size_t num, int num_blocks, int n, int m){
+    auto& cost = *sc.get_cost_model();
+    size_t triples = num * num_blocks;
+    size_t peers = client_num - 1;
+    bool lead = (client_id == SUPER_CLIENT_ID);
+
+    // share2homo: every client but the lead encrypts and sends, the lead adds up
+    size_t share2homo_calls = size_t(num_blocks) * m + triples * (size_t(m) + 1);
+    if(lead){
+        cost.he_ciphertexts_recv += share2homo_calls * peers;
+        cost.he_eval_add += share2homo_calls * peers;
     }
-    sc.set_matrix_triple(matrix, n, m);
-}
\ No newline at end of file
+    else{
+        cost.he_encrypt += share2homo_calls;
+        cost.he_ciphertexts_send += share2homo_calls;
+    }
+
+    // per triple: m products summed up by the lead, then one threshold decryption
+    if(lead){
+        cost.he_eval_mult += triples * m;
+        cost.he_eval_add += triples * m;
+        cost.he_decrypt += triples * 2;
+        cost.he_ciphertexts_send += triples * peers;
+        cost.he_ciphertexts_recv += triples * peers;
+    }
+    else{
+        cost.he_decrypt += triples;
+        cost.he_ciphertexts_send += triples;
+        cost.he_ciphertexts_recv += triples;
+    }
+}
+
+template class Client<64, 16>;
+template class Client<128, 12>;
+template class Client<128, 20>;
\ No newline at end of file
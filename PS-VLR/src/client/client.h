@@ -6,11 +6,14 @@
 #include "openfhe.h"
 #include "../include/common.h"
 #include "../mpc/fsemi2k/fsemi2k_context.hpp"
+#include "../datatypes/sparse_rows.hpp"
 using std::vector, std::string;
 
 using namespace lbcrypto;
 
 
+// instantiated in client.cpp for the rings selectable at runtime, see test.cpp
+template <size_t N, size_t D>
 class Client {
 
 private:
@@ -21,14 +24,15 @@ public:
     int client_num;                                    // total clients in the system
     bool has_label;                                    // only one client has label, default client 0
     std::vector<std::vector<double>> local_data;      // local data
+    SparseRows<double> local_sparse;                   // local data after to_sparse, local_data is empty then
     std::vector<double> labels;                         // if has_label == true, then has labels
     int sample_num;                                    // number of samples
     int feature_num;                                   // number of features
     CryptoContext<DCRTPoly> cc;                        // crypto context of threshold CKKS
     PrivateKey<DCRTPoly> sk;                             // serect key of threshold CKKS
     PublicKey<DCRTPoly> pk;                            // public key of threshold CKKS
-    int batchsize;
-    FSemi2kContext<128, 12>& sc;
+    int batchsize = 0;                                 // CKKS slots, set by initialize_keys
+    FSemi2kContext<N, D>& sc;
     mplayerid_t parties;
     playerid_t id;
     network::MultiPartyPlayer* mplayer;
@@ -42,13 +46,26 @@ public:
 
 
     Client(int param_client_id, int param_client_num, int param_has_label,
-            FSemi2kContext<128, 12>& sc, std::string param_local_data_file, mplayerid_t parties,
+            FSemi2kContext<N, D>& sc, std::string param_local_data_file, mplayerid_t parties,
                 playerid_t id, network::MultiPartyPlayer* mplayer);
 
+    // local data given in memory, the label is the last column if param_has_label
+    Client(int param_client_id, int param_client_num, int param_has_label,
+            FSemi2kContext<N, D>& sc, std::vector<std::vector<double>> param_local_data, mplayerid_t parties,
+                playerid_t id, network::MultiPartyPlayer* mplayer);
+
+
+    // shares keys and ids with other, but talks over mplayer through sc and holds no local data
+    // used to run HE protocols on a separate channel next to the training
+    Client(const Client& other, FSemi2kContext<N, D>& sc, network::MultiPartyPlayer* mplayer);
 
     ~Client();
 
 
+    // keep the local features as compressed sparse rows only, e.g. for one-hot data
+    void to_sparse();
+    bool is_sparse() const { return local_data.empty() && local_sparse.rows() != 0; }
+
     void initialize_keys(unsigned int init_size = 4, 
         unsigned int dcrtBits = 40, unsigned int batchSize = 16);
 
@@ -74,19 +91,60 @@ public:
 
     void generate_matrix_triple(const std::vector<std::vector<std::vector<double>>>& U, size_t num, int num_blocks, int n, int m);
 
+    // symbolic mode: count the HE work of generate_matrix_triple without running it
+    void count_matrix_triple(size_t num, int num_blocks, int n, int m);
+
+    // one shape of matrix-vector triples, U holds the mask of every block
+    struct MatrixTripleShape{
+        std::vector<std::vector<std::vector<double>>> U;
+        int n;
+        int m;
+    };
+
+    // produce num triples per shape and block in a background thread over offline_player
+    // shapes are produced in the order training consumes them: all shapes of block 0,
+    // then of block 1, ..., repeated num times
+    // the masks U are installed in sc right away, pool is attached to sc
+    // the producer has a context and cost model of its own, its counts are merged at pool.join
+    // all parties must start their producers with the same arguments
+    void start_matrix_triple_producer(MatrixTriplePool<N>& pool, network::MultiPartyPlayer* offline_player,
+        const std::vector<MatrixTripleShape>& shapes, size_t num, int num_blocks, long seed);
+
+    // HE encryption of the transposed mask, m ciphertexts of length n
+    std::vector<Ciphertext<DCRTPoly>> encrypt_matrix_mask(const std::vector<std::vector<double>>& U, int n, int m);
+
+    // one triple (V, UV) for the mask encrypted by encrypt_matrix_mask
+    MatrixTriplePool<N>::Triple produce_matrix_triple(const std::vector<Ciphertext<DCRTPoly>>& c_U_transpose, int n, int m, RandomGenerator& rng);
+
     template<class T>
-    std::string Client::serialize(const T& obj);
+    std::string serialize(const T& obj);
 
     template<class T>
-    void Client::deserialize(T& obj, const std::string& s);
+    void deserialize(T& obj, const std::string& s);
 
+    // c is given at from only, every client gets a share of its first size slots
     std::vector<double> homo2share(int from, Ciphertext<DCRTPoly> c = nullptr, int size = 0);
 
+    // the encryption of the sum of all vecs, returned at to only
     Ciphertext<DCRTPoly> share2homo(const std::vector<double>& vec, int to);
 
-    std::vector<double> share2double(const std::vector<FSemi2kSharing<128, 12>>& vec);
+    // ring shares: all but to trade theirs for small masks first, CKKS cannot add up shares mod 2^N
+    Ciphertext<DCRTPoly> share2homo(const std::vector<FSemi2kSharing<N, D>>& vec, int to);
+
+    // c is given at from only and returned at every client
+    Ciphertext<DCRTPoly> broadcast(const Ciphertext<DCRTPoly>& c, int from);
+
+    // slot j holds the inner product of rows[j] with the first rows[j].size() slots of c,
+    // one plaintext product, one rotation sum and one mask per row
+    Ciphertext<DCRTPoly> inner_products(const std::vector<std::vector<double>>& rows, const Ciphertext<DCRTPoly>& c);
 
-    std::vector<FSemi2kSharing<128, 12>> double2share(const std::vector<double>& vec); 
+    // bulk fixed-point codecs, see fixed_point_codec.h
+    std::vector<double> share2double(const std::vector<FSemi2kSharing<N, D>>& vec);
+
+    std::vector<FSemi2kSharing<N, D>> double2share(const std::vector<double>& vec); 
+
+private:
+    void load_local_data(std::vector<std::vector<double>>&& data);
 
 };
 
@@ -8,8 +8,9 @@
 #include <ciphertext-ser.h>
 
 
+template <size_t N, size_t D>
 template<typename T>
-void Client::recv_message(int i, T& message) {
+void Client<N, D>::recv_message(int i, T& message) {
     // auto byte_vec = mplayer->recv(i);
     // std::cout << "receive byte_vec.size() = " << byte_vec.size() << std::endl;
     // Deserializer dr(std::move(byte_vec));
@@ -17,8 +18,9 @@ void Client::recv_message(int i, T& message) {
     dr >> message;
 }
 
+template <size_t N, size_t D>
 template<typename T>
-void Client::send_message(int i, const T& message) {
+void Client<N, D>::send_message(int i, const T& message) {
     Serializer sr;
     sr << message;
     // auto byte_vec = sr.finalize();
@@ -27,8 +29,9 @@ void Client::send_message(int i, const T& message) {
     // mplayer->send(i, std::move(byte_vec));
 }
 
+template <size_t N, size_t D>
 template<typename T>
-void Client::recv_message_spec(int i, T& message) {
+void Client<N, D>::recv_message_spec(int i, T& message) {
     int n, m;
     Deserializer dr(mplayer->recv(i));
     // dr >> n;
@@ -46,8 +49,9 @@ void Client::recv_message_spec(int i, T& message) {
     }
 }
 
+template <size_t N, size_t D>
 template<typename T>
-void Client::send_message_spec(int i, const T& message) {
+void Client<N, D>::send_message_spec(int i, const T& message) {
     Serializer sr;
     int n = message.size();
     int m = message[0].size();
@@ -61,17 +65,21 @@ void Client::send_message_spec(int i, const T& message) {
     mplayer->send(i, sr.finalize());
 }
 
+template <size_t N, size_t D>
 template<class T>
-std::string Client::serialize(const T& obj){
+std::string Client<N, D>::serialize(const T& obj){
+    trace::Scope scope("serialize", trace::serialize);
     std::string s;
     std::ostringstream os(s);
     Serial::Serialize(obj, os, SerType::BINARY);
     return os.str();
 }
 
+template <size_t N, size_t D>
 template<class T>
-void Client::deserialize(T& obj, const std::string& s){
+void Client<N, D>::deserialize(T& obj, const std::string& s){
+    trace::Scope scope("deserialize", trace::serialize);
     std::istringstream is(s);
     Serial::Deserialize(obj, is, SerType::BINARY);
     assert(is.good());
-}
\ No newline at end of file
+}
@@ -50,4 +50,8 @@ std::string const& ConfigFile::value(const std::string& section, const std::stri
     else{
         return ci->second;
     }
-}
\ No newline at end of file
+}
+
+bool ConfigFile::has(const std::string& section, const std::string& entry) const{
+    return content.find(section + '/' + entry) != content.end();
+}
@@ -0,0 +1,71 @@
+#include "execution.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <fmt/format.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+ExecutionBudget ExecutionBudget::split(std::size_t cpus, std::size_t io_threads, bool background){
+    if(cpus == 0) cpus = std::max(1u, std::thread::hardware_concurrency());
+
+    ExecutionBudget budget;
+    budget.cpus = cpus;
+    budget.io_threads = io_threads;
+    std::size_t rest = cpus > io_threads ? cpus - io_threads : 1;
+    budget.background_threads = background ? std::max<std::size_t>(1, rest / 2) : 0;
+    budget.compute_threads = std::max<std::size_t>(1, rest - std::min(rest, budget.background_threads));
+    return budget;
+}
+
+std::size_t ExecutionBudget::default_io_threads(std::size_t cpus, std::size_t n_players){
+    if(cpus == 0) cpus = std::max(1u, std::thread::hardware_concurrency());
+    return std::clamp<std::size_t>(n_players - 1, 1, std::max<std::size_t>(1, cpus / 4));
+}
+
+std::vector<int> ExecutionBudget::io_cpus() const{
+    std::vector<int> ret;
+    if(!pin_io) return ret;
+    if(io_threads >= cpus) throw std::invalid_argument("execution budget: pinned io threads need fewer io threads than cpus");
+    for(std::size_t i = cpus - io_threads; i != cpus; ++i) ret.push_back(cpu_base + i);
+    return ret;
+}
+
+std::vector<int> ExecutionBudget::compute_cpus() const{
+    std::vector<int> ret;
+    if(!pin_io) return ret;
+    if(io_threads >= cpus) throw std::invalid_argument("execution budget: pinned io threads need fewer io threads than cpus");
+    for(std::size_t i = 0; i != cpus - io_threads; ++i) ret.push_back(cpu_base + i);
+    return ret;
+}
+
+std::string ExecutionBudget::to_string() const{
+    std::string range = pin_io ? fmt::format(" ({} to {})", cpu_base, cpu_base + cpus - 1) : "";
+    return fmt::format("{} cpus{}: {} io{}, {} compute, {} background", cpus, range, io_threads, pin_io ? " pinned" : "", compute_threads, background_threads);
+}
+
+void pin_calling_thread(std::vector<int> const& cpus){
+#ifdef __linux__
+    if(cpus.empty()) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu: cpus) CPU_SET(cpu, &set);
+    if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0){
+        throw std::runtime_error(fmt::format("cannot pin the compute threads to cpus {} to {}", cpus.front(), cpus.back()));
+    }
+#endif
+}
+
+void set_openmp_threads(std::size_t n){
+#ifdef _OPENMP
+    omp_set_num_threads(std::max<std::size_t>(1, n));
+    omp_set_max_active_levels(1);
+#endif
+}
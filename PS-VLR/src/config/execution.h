@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// @brief One party's share of the CPUs. io_threads run the asio io_context of every
+/// player of the party, compute_threads run share kernels and HE loops on the thread
+/// pool, the party thread included, and size the OpenMP team OpenFHE uses outside the
+/// pool; background_threads size the OpenMP team of the background triple producer.
+struct ExecutionBudget {
+    std::size_t cpus = 1;
+    std::size_t io_threads = 1;
+    std::size_t compute_threads = 1;
+    std::size_t background_threads = 0;
+    bool pin_io = false;        // pin the io threads to the last io_threads cpus of the budget
+    std::size_t cpu_base = 0;   // first cpu of the budget, parties sharing a host need disjoint ranges
+
+    /// @brief cpus 0 takes every cpu of the machine. The background producer, if any, gets
+    /// half of what the io threads leave, the rest computes, at least one thread each.
+    static ExecutionBudget split(std::size_t cpus, std::size_t io_threads, bool background);
+
+    /// @brief One io thread per peer, at most a quarter of the cpus and at least one.
+    static std::size_t default_io_threads(std::size_t cpus, std::size_t n_players);
+
+    /// @brief The cpus to pin io threads to, empty if not pinned.
+    std::vector<int> io_cpus() const;
+
+    /// @brief The cpus of the budget the io threads leave to the party, its thread pool and
+    /// OpenMP teams, empty if not pinned.
+    std::vector<int> compute_cpus() const;
+
+    std::string to_string() const;
+};
+
+/// @brief Restricts the calling thread to cpus, threads it starts later inherit them, e.g.
+/// ThreadPool workers and OpenMP teams. Empty cpus, or builds for other systems than Linux, leave it as is.
+void pin_calling_thread(std::vector<int> const& cpus);
+
+/// @brief Sizes the OpenMP team of parallel regions the calling thread starts, nested
+/// regions run serially. A no-op in builds without OpenMP.
+void set_openmp_threads(std::size_t n);
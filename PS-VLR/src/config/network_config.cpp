@@ -0,0 +1,90 @@
+#include "network_config.h"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+const char* const link_entries[] = {"profile", "delay_ms", "bandwidth_mbps", "capacity", "strategy", "packet_bytes", "interval_us"};
+
+double number(ConfigFile const& config, std::string const& key){
+    try{
+        std::size_t pos = 0;
+        double ret = std::stod(config.value("", key), &pos);
+        if(pos == config.value("", key).size()) return ret;
+    }
+    catch(std::logic_error const&){
+    }
+    throw std::invalid_argument("network config: " + key + " is not a number");
+}
+
+// delays, rates and sizes, converted to unsigned or duration types
+double non_negative(ConfigFile const& config, std::string const& key){
+    double ret = number(config, key);
+    if(ret < 0) throw std::invalid_argument("network config: " + key + " is negative");
+    return ret;
+}
+
+// the entries prefix + <entry> on top of link
+void apply_entries(ConfigFile const& config, std::string const& prefix, network::LinkProfile& link){
+    using Strategy = network::LinkProfile::Strategy;
+    using std::chrono::duration;
+    using std::chrono::duration_cast;
+
+    if(config.has("", prefix + "profile")){
+        link = network::LinkProfile::preset(config.value("", prefix + "profile"));
+    }
+    if(config.has("", prefix + "delay_ms")){
+        link.delay = duration_cast<network::LinkProfile::DurationType>(duration<double, std::milli>(non_negative(config, prefix + "delay_ms")));
+    }
+    if(config.has("", prefix + "bandwidth_mbps")){
+        double mbps = non_negative(config, prefix + "bandwidth_mbps");
+        link.bandwidth = mbps == 0 ? network::LinkProfile::BitrateType::unlimited() : network::GigaBitsPerSecond(mbps / 1000);
+    }
+    if(config.has("", prefix + "capacity")){
+        link.capacity = non_negative(config, prefix + "capacity");
+    }
+    if(config.has("", prefix + "strategy")){
+        auto const& strategy = config.value("", prefix + "strategy");
+        if(strategy == "dynamic"){
+            link.strategy = Strategy(Strategy::Type::dynamic_packet_size);
+        }
+        else if(strategy == "fixed_packet"){
+            if(!config.has("", prefix + "packet_bytes")) throw std::invalid_argument("network config: " + prefix + "strategy fixed_packet needs " + prefix + "packet_bytes");
+            link.strategy = Strategy(network::Bytes(non_negative(config, prefix + "packet_bytes")));
+        }
+        else if(strategy == "fixed_interval"){
+            if(!config.has("", prefix + "interval_us")) throw std::invalid_argument("network config: " + prefix + "strategy fixed_interval needs " + prefix + "interval_us");
+            link.strategy = Strategy(duration_cast<Strategy::DurationType>(duration<double, std::micro>(non_negative(config, prefix + "interval_us"))));
+        }
+        else{
+            throw std::invalid_argument("network config: unknown " + prefix + "strategy " + strategy);
+        }
+    }
+}
+
+bool has_entries(ConfigFile const& config, std::string const& prefix){
+    for(const char* entry: link_entries){
+        if(config.has("", prefix + entry)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+std::vector<network::LinkProfile> read_link_profiles(ConfigFile const& config, std::size_t my_pid, std::size_t n_players){
+    network::LinkProfile common;
+    apply_entries(config, "link_", common);
+
+    std::vector<network::LinkProfile> links(n_players, common);
+    for(std::size_t j = 0; j != n_players; ++j){
+        if(j == my_pid) continue;
+        std::string prefix = "link_" + std::to_string(my_pid) + "_" + std::to_string(j) + "_";
+        if(!has_entries(config, prefix)){
+            prefix = "link_" + std::to_string(j) + "_" + std::to_string(my_pid) + "_";
+        }
+        apply_entries(config, prefix, links[j]);
+        links[j].validate();
+    }
+    return links;
+}
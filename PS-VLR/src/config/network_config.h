@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "config.h"
+#include "../network/link_profile.h"
+
+/// @brief Profiles of the links from my_pid to every party, entry my_pid unused.
+/// Every link starts from the preset link_profile (default none), then the entries
+/// link_delay_ms, link_bandwidth_mbps, link_capacity, link_strategy (dynamic, fixed_packet or
+/// fixed_interval), link_packet_bytes and link_interval_us override it. link_i_j_profile replaces
+/// the preset for the link from i to j, and link_i_j_<entry> the entries; a link without any
+/// link_i_j_ entry takes those of link_j_i, so one set of entries describes both directions.
+std::vector<network::LinkProfile> read_link_profiles(ConfigFile const& config, std::size_t my_pid, std::size_t n_players);
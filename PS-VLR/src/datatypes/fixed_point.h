@@ -41,7 +41,8 @@ public:
     FixedPoint& operator=(FixedPoint&&)      = default;
     FixedPoint& operator=(const FixedPoint&) = default;
 
-    underlying_type& underlying() { return _data; }
+    underlying_type&       underlying()       { return _data; }
+    underlying_type const& underlying() const { return _data; }
 
     template <std::floating_point T>
     FixedPoint(T val);
@@ -122,27 +122,33 @@ FixedPoint<N, D>::operator T() const
         return std::numeric_limits<T>::quiet_NaN();
 
     auto &x = _data;
-    auto y = abs(x);
-    auto data = y.data();
-
-    int sgn_limb = underlying_type::N_LIMBS - 1;
-    while (sgn_limb > 0 && (data[sgn_limb] == 0))
-        sgn_limb--;
-
-    if (data[sgn_limb] == 0)
-        return T{0};
-
-    int exp = sgn_limb * mp_bits_per_limb - int(D);
-    int cntlz = std::countl_zero(data[sgn_limb]);
-    if (cntlz > 0 && sgn_limb > 0) {
-        mpn_lshift(data + sgn_limb - 1, data + sgn_limb - 1, 2, cntlz);
-        exp -= cntlz;
+    if constexpr (detail::small<N>) {
+        // native word, no limbs to walk
+        return std::ldexp(static_cast<T>(typename underlying_type::value_type(x)), -int(D));
+    }
+    else {
+        auto y = abs(x);
+        auto data = y.data();
+
+        int sgn_limb = underlying_type::N_LIMBS - 1;
+        while (sgn_limb > 0 && (data[sgn_limb] == 0))
+            sgn_limb--;
+
+        if (data[sgn_limb] == 0)
+            return T{0};
+
+        int exp = sgn_limb * mp_bits_per_limb - int(D);
+        int cntlz = std::countl_zero(data[sgn_limb]);
+        if (cntlz > 0 && sgn_limb > 0) {
+            mpn_lshift(data + sgn_limb - 1, data + sgn_limb - 1, 2, cntlz);
+            exp -= cntlz;
+        }
+
+        auto s = (x.msb() ? T(-1) : T(1));
+        auto t = static_cast<T>(data[sgn_limb]);
+        auto f = std::pow(T{2}, exp);
+        return s * t * f;
     }
-
-    auto s = (x.msb() ? T(-1) : T(1));
-    auto t = static_cast<T>(data[sgn_limb]);
-    auto f = std::pow(T{2}, exp);
-    return s * t * f;
 }
 
 template <size_t N, size_t D>
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <concepts>
+#include <span>
+#include "fixed_point.hpp"
+
+/// @brief Bulk conversion between doubles and fixed-point values with D fractional bits in Z_2^N.
+/// Replaces the per-element FloatParse and GMP decimal round trips on the hot paths:
+/// rings up to 64 bits go through one int64 per element, 128-bit rings through two limbs,
+/// other widths fall back to FixedPoint(double). The loops make no GMP calls and allocate nothing;
+/// they are not vectorized, encoding branches on NaN and saturation and works on __int128.
+/// Encoding rounds to nearest, ties to even, and saturates: values out of range and infinities
+/// map to FixedPoint::max() / lowest(), NaN maps to FixedPoint::quiet_NaN().
+/// Decoding is purely numeric; the sentinels are not recognized, shares hit them by chance.
+namespace fixed_point_codec
+{
+
+template <size_t N, size_t D>
+void encode(std::span<const double> in, std::span<SignedZ2<N>> out);
+
+template <size_t N, size_t D>
+void decode(std::span<const SignedZ2<N>> in, std::span<double> out);
+
+/// @brief on FixedPoint<N, D> and types derived from it, e.g. FSemi2kSharing<N, D>
+template <size_t N, size_t D, typename T> requires std::derived_from<T, FixedPoint<N, D>>
+void encode(std::span<const double> in, std::span<T> out);
+
+template <size_t N, size_t D, typename T> requires std::derived_from<T, FixedPoint<N, D>>
+void decode(std::span<const T> in, std::span<double> out);
+
+} // namespace fixed_point_codec
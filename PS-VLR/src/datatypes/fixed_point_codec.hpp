@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include "fixed_point_codec.h"
+
+namespace fixed_point_codec
+{
+
+namespace detail
+{
+
+// the words of FixedPoint<N, D>::max(), lowest() and quiet_NaN() as two's complement 128-bit values
+template <size_t N>
+struct Sentinels {
+    static constexpr __int128 top    = __int128((static_cast<unsigned __int128>(1) << (N - 1)) - 1);
+    static constexpr __int128 max    = top - 2;
+    static constexpr __int128 lowest = -top - 1;
+    static constexpr __int128 nan    = top - 1;
+};
+
+// x * 2^D rounded and saturated to the signed N-bit range
+template <size_t N, size_t D>
+inline __int128 encode_word(double x){
+    constexpr double limit = double(static_cast<unsigned __int128>(1) << (N - 1));
+    constexpr double scale = double(std::uint64_t(1) << D);
+    double v = std::nearbyint(x * scale);
+    if(v != v) return Sentinels<N>::nan;
+    if(v >= limit) return Sentinels<N>::max;
+    if(v < -limit) return Sentinels<N>::lowest;
+    if(std::abs(v) < 0x1p63) return __int128(std::int64_t(v));
+    // |v| >= 2^63 has at most 53 significant bits above 2^11, both halves are exact
+    double hi = std::floor(std::ldexp(v, -64));
+    double lo = v - std::ldexp(hi, 64);
+    return (__int128(std::int64_t(hi)) << 64) | __int128(std::uint64_t(lo));
+}
+
+template <size_t N>
+inline void store(SignedZ2<N>& z, __int128 w){
+    if constexpr (N <= 64){
+        z = SignedZ2<N>(typename SignedZ2<N>::value_type(w));
+    }
+    else{
+        static_assert(N == 128 && GMP_LIMB_BITS == 64);
+        z.data()[0] = std::uint64_t(w);
+        z.data()[1] = std::uint64_t(w >> 64);
+    }
+}
+
+template <size_t N, size_t D>
+inline double load(const SignedZ2<N>& z){
+    constexpr double inv_scale = 1 / double(std::uint64_t(1) << D);
+    if constexpr (N <= 64){
+        return double(typename SignedZ2<N>::value_type(z)) * inv_scale;
+    }
+    else{
+        // one rounding from the full word, adding converted halves cancels for small negatives
+        __int128 w = (__int128(std::int64_t(z.data()[1])) << 64) | __int128(z.data()[0]);
+        return double(w) * inv_scale;
+    }
+}
+
+template <size_t N>
+constexpr bool has_kernel = (N <= 64 || N == 128);
+
+} // namespace detail
+
+template <size_t N, size_t D>
+void encode(std::span<const double> in, std::span<SignedZ2<N>> out){
+    if(in.size() != out.size()) throw std::invalid_argument("fixed_point_codec::encode: size mismatch");
+    if constexpr (detail::has_kernel<N>){
+        for(size_t i = 0; i < in.size(); ++i){
+            detail::store<N>(out[i], detail::encode_word<N, D>(in[i]));
+        }
+    }
+    else{
+        for(size_t i = 0; i < in.size(); ++i) out[i] = FixedPoint<N, D>(in[i]).underlying();
+    }
+}
+
+template <size_t N, size_t D>
+void decode(std::span<const SignedZ2<N>> in, std::span<double> out){
+    if(in.size() != out.size()) throw std::invalid_argument("fixed_point_codec::decode: size mismatch");
+    if constexpr (detail::has_kernel<N>){
+        for(size_t i = 0; i < in.size(); ++i){
+            out[i] = detail::load<N, D>(in[i]);
+        }
+    }
+    else{
+        for(size_t i = 0; i < in.size(); ++i){
+            FixedPoint<N, D> f;
+            f.underlying() = in[i];
+            out[i] = double(f);
+        }
+    }
+}
+
+template <size_t N, size_t D, typename T> requires std::derived_from<T, FixedPoint<N, D>>
+void encode(std::span<const double> in, std::span<T> out){
+    if(in.size() != out.size()) throw std::invalid_argument("fixed_point_codec::encode: size mismatch");
+    if constexpr (detail::has_kernel<N>){
+        for(size_t i = 0; i < in.size(); ++i){
+            detail::store<N>(out[i].underlying(), detail::encode_word<N, D>(in[i]));
+        }
+    }
+    else{
+        for(size_t i = 0; i < in.size(); ++i) out[i].underlying() = FixedPoint<N, D>(in[i]).underlying();
+    }
+}
+
+template <size_t N, size_t D, typename T> requires std::derived_from<T, FixedPoint<N, D>>
+void decode(std::span<const T> in, std::span<double> out){
+    if(in.size() != out.size()) throw std::invalid_argument("fixed_point_codec::decode: size mismatch");
+    if constexpr (detail::has_kernel<N>){
+        for(size_t i = 0; i < in.size(); ++i){
+            out[i] = detail::load<N, D>(in[i].underlying());
+        }
+    }
+    else{
+        for(size_t i = 0; i < in.size(); ++i) out[i] = double(static_cast<const FixedPoint<N, D>&>(in[i]));
+    }
+}
+
+} // namespace fixed_point_codec
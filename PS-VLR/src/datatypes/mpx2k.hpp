@@ -170,12 +170,12 @@ void mpx2k_mul(
     constexpr size_t option = 1;
 
     if constexpr(option == 1) {
-        static mp_limb_t buffer[2*N_LIMBS<K>];
+        mp_limb_t buffer[2*N_LIMBS<K>];
         mpn_mul_n(buffer, s1p, s2p, N_LIMBS<K>);
         mpn_copyi(rp, buffer, N_LIMBS<K>);
     }
     else if constexpr (option == 2) {
-        static mp_limb_t buffer[N_LIMBS<K>];
+        mp_limb_t buffer[N_LIMBS<K>];
         mpn_zero(buffer, N_LIMBS<K>);
         for(size_t i = 0; i < N_LIMBS<K>; ++i) {
             mpn_addmul_1(buffer + i, s1p, N_LIMBS<K> - i, s2p[i]);
@@ -244,12 +244,14 @@ void mpx2k_lshift(
     size_t limbcnt = cnt / MP_BITS_PER_LIMB;
     size_t bitcnt  = cnt % MP_BITS_PER_LIMB;
 
+    // mpn_lshift needs a count in [1, MP_BITS_PER_LIMB)
     if(limbcnt == 0) {
-        mpn_lshift(rp, sp, N_LIMBS<K>, bitcnt);
+        if(bitcnt != 0) mpn_lshift(rp, sp, N_LIMBS<K>, bitcnt);
+        else if(rp != sp) mpx_copy(rp, sp, N_LIMBS<K>);
     } else {
         mpx_copy(rp + limbcnt, sp, N_LIMBS<K> - limbcnt);
         mpn_zero(rp, limbcnt);
-        mpn_lshift(rp + limbcnt, rp + limbcnt, N_LIMBS<K> - limbcnt, bitcnt);
+        if(bitcnt != 0) mpn_lshift(rp + limbcnt, rp + limbcnt, N_LIMBS<K> - limbcnt, bitcnt);
     }
 
 }
@@ -266,11 +268,13 @@ void mpx2k_rshift(
     size_t limbcnt = cnt / MP_BITS_PER_LIMB;
     size_t bitcnt  = cnt % MP_BITS_PER_LIMB;
 
+    // mpn_rshift needs a count in [1, MP_BITS_PER_LIMB)
     if(limbcnt == 0) {
-        mpn_rshift(rp, sp, N_LIMBS<K>, bitcnt);
+        if(bitcnt != 0) mpn_rshift(rp, sp, N_LIMBS<K>, bitcnt);
+        else if(rp != sp) mpx_copy(rp, sp, N_LIMBS<K>);
     } else {
         mpx_copy(rp, sp + limbcnt, N_LIMBS<K> - limbcnt);
-        mpn_rshift(rp, rp, N_LIMBS<K> - limbcnt, bitcnt);
+        if(bitcnt != 0) mpn_rshift(rp, rp, N_LIMBS<K> - limbcnt, bitcnt);
     }
 
     if(Signed) {
@@ -34,7 +34,7 @@ void mpxp_add(
     const mp_limb_t* s2p,
     const mp_limb_t* pp
 ) {
-    static mp_limb_t tp[ZP_LIMBS<N>];
+    mp_limb_t tp[ZP_LIMBS<N>];
 
     auto carry = mpn_add_n(rp, s1p, s2p, ZP_LIMBS<N>);
     auto cmp   = mpn_cmp(rp, pp, ZP_LIMBS<N>);
@@ -57,7 +57,7 @@ void mpxp_sub(
     const mp_limb_t* s2p,
     const mp_limb_t* pp
 ) {
-    static mp_limb_t tp[ZP_LIMBS<N>];
+    mp_limb_t tp[ZP_LIMBS<N>];
 
     auto cmp = mpn_cmp(s1p, s2p, ZP_LIMBS<N>);
 
@@ -77,8 +77,8 @@ void mpxp_mul(
     const mp_limb_t* s2p,
     const mp_limb_t* pp
 ) {
-    static mp_limb_t qp[ZP_LIMBS<N>+1];
-    static mp_limb_t tp[2*ZP_LIMBS<N>];
+    mp_limb_t qp[ZP_LIMBS<N>+1];
+    mp_limb_t tp[2*ZP_LIMBS<N>];
 
 
     mpn_mul_n(tp, s1p, s2p, ZP_LIMBS<N>);
@@ -92,10 +92,10 @@ void mpxp_inv(
     const mp_limb_t* ap,
     const mp_limb_t* pp
 ) {
-    static mp_limb_t gp[ZP_LIMBS<N>];
-    static mp_limb_t up[ZP_LIMBS<N>];
-    static mp_limb_t vp[ZP_LIMBS<N>];
-    static mp_limb_t sp[ZP_LIMBS<N>+1];  
+    mp_limb_t gp[ZP_LIMBS<N>];
+    mp_limb_t up[ZP_LIMBS<N>];
+    mp_limb_t vp[ZP_LIMBS<N>];
+    mp_limb_t sp[ZP_LIMBS<N>+1];  
 
     mp_size_t sn;
 
@@ -125,7 +125,7 @@ void mpxp_div(
     const mp_limb_t* s2p,
     const mp_limb_t* pp
 ) {
-    static mp_limb_t tp[ZP_LIMBS<N>];
+    mp_limb_t tp[ZP_LIMBS<N>];
 
     mpxp_inv<N>(tp, s2p, pp);
     mpxp_mul<N>(rp, s1p, tp, pp);
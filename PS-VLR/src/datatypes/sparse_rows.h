@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Compressed sparse rows of a matrix with values of type T.
+/// Without values every stored entry equals unit, which keeps one-hot data at one index per
+/// nonzero: products then add up the selected entries and multiply once per row.
+template <typename T>
+struct SparseRows{
+    using size_type = std::size_t;
+    using index_type = std::uint32_t;
+
+    size_type cols = 0;
+    std::vector<index_type> row_ptr{0};     // entries of row i are [row_ptr[i], row_ptr[i + 1])
+    std::vector<index_type> col_idx;
+    std::vector<T> values;                  // empty if every entry equals unit
+    T unit{};
+
+    size_type rows() const { return row_ptr.size() - 1; }
+    size_type nnz() const { return col_idx.size(); }
+    bool is_pattern() const { return values.empty(); }
+    const T& value(size_type k) const { return values.empty() ? unit : values[k]; }
+
+    /// @brief nonzeros of the rows of dense, a pattern if they are all equal
+    static SparseRows from_dense(const std::vector<std::vector<T>>& dense);
+
+    /// @brief rows [first, last) as a dense matrix
+    std::vector<std::vector<T>> to_dense(size_type first, size_type last) const;
+
+    /// @brief rows [first, last) with values and unit mapped by f, the pattern is kept
+    template <typename U, typename F>
+    SparseRows<U> slice(size_type first, size_type last, F&& f) const;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdexcept>
+#include "sparse_rows.h"
+
+template <typename T>
+SparseRows<T> SparseRows<T>::from_dense(const std::vector<std::vector<T>>& dense){
+    SparseRows<T> ret;
+    ret.cols = dense.empty() ? 0 : dense[0].size();
+    bool same = true;
+    for(const auto& row: dense){
+        if(row.size() != ret.cols) throw std::invalid_argument("SparseRows: rows of different length");
+        for(size_type j = 0; j != row.size(); ++j){
+            if(row[j] == T{}) continue;
+            if(!ret.col_idx.empty() && !(row[j] == ret.values.back())) same = false;
+            ret.col_idx.push_back(index_type(j));
+            ret.values.push_back(row[j]);
+        }
+        ret.row_ptr.push_back(index_type(ret.col_idx.size()));
+    }
+    if(same && !ret.values.empty()){
+        ret.unit = ret.values[0];
+        ret.values.clear();
+        ret.values.shrink_to_fit();
+    }
+    return ret;
+}
+
+template <typename T>
+std::vector<std::vector<T>> SparseRows<T>::to_dense(size_type first, size_type last) const{
+    std::vector<std::vector<T>> ret(last - first, std::vector<T>(cols, T{}));
+    for(size_type i = first; i != last; ++i){
+        for(size_type k = row_ptr[i]; k != row_ptr[i + 1]; ++k){
+            ret[i - first][col_idx[k]] = value(k);
+        }
+    }
+    return ret;
+}
+
+template <typename T>
+template <typename U, typename F>
+SparseRows<U> SparseRows<T>::slice(size_type first, size_type last, F&& f) const{
+    SparseRows<U> ret;
+    ret.cols = cols;
+    ret.row_ptr.resize(last - first + 1);
+    for(size_type i = first; i <= last; ++i){
+        ret.row_ptr[i - first] = row_ptr[i] - row_ptr[first];
+    }
+    ret.col_idx.assign(col_idx.begin() + row_ptr[first], col_idx.begin() + row_ptr[last]);
+    if(is_pattern()){
+        ret.unit = f(unit);
+    }
+    else{
+        ret.values.reserve(ret.col_idx.size());
+        for(size_type k = row_ptr[first]; k != row_ptr[last]; ++k){
+            ret.values.push_back(f(values[k]));
+        }
+    }
+    return ret;
+}
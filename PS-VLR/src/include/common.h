@@ -3,9 +3,3 @@
 
 #define SUPER_CLIENT_ID     (0)
 
-#define SHARING_DECIMAL_LEN (12)
-#define SHARING_TOTAL_LEN   (128)
-#define SHARING_RING_SIZE   (1 << SHARING_TOTAL_LEN)
-#define SHARING_DECIMAL_SIZE   (1 << SHARING_DECIMAL_LEN)
-
-
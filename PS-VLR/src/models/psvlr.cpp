@@ -1,117 +1,131 @@
 #include "psvlr.h"
 #include "../serialization/serialization.hpp"
+#include "../datatypes/fixed_point_codec.hpp"
+#include <bit>
 
-PSVLR::PSVLR(Client& client, int batchsize): client(client), batchsize(batchsize){}
+template <size_t N, size_t D>
+PSVLR<N, D>::PSVLR(Client<N, D>& client, int batchsize): client(client), batchsize(batchsize), sigmoid_scheduler(client.mplayer){}
 
-PSVLR::~PSVLR(){}
+template <size_t N, size_t D>
+PSVLR<N, D>::~PSVLR(){}
 
-void PSVLR::share_data(){
+template <size_t N, size_t D>
+void PSVLR<N, D>::share_feature_counts(){
+    Serializer sr;
+    sr << int(client.feature_num);
+    auto counts = client.mplayer->broadcast_recv(sr.finalize());
+    feature_offsets.assign(client.client_num + 1, 0);
+    for(int i = 0; i != client.client_num; ++i){
+        int m = i == client.client_id ? client.feature_num : Deserializer(std::move(counts[i])).get<int>();
+        feature_offsets[i + 1] = feature_offsets[i] + m;
+    }
+}
+
+template <size_t N, size_t D>
+ShareStore<FSemi2kSharing<N, D>> PSVLR<N, D>::make_store(const std::string& name) const{
+    std::string path = store_dir.empty() ? "" : fmt::format("{}/psvlr_{}_{}_{}.bin", store_dir, getpid(), client.client_id, name);
+    return ShareStore<FSemi2kSharing<N, D>>(training_data.size(), feature_offsets.back(), batchsize, path);
+}
+
+template <size_t N, size_t D>
+void PSVLR<N, D>::share_data(){
+    network::PhaseGuard phase(client.mplayer->phases(), "share_data");
 
     training_data = client.local_data;
     training_data_labels = client.labels;
-    shared_data.resize(training_data.size());
+    share_feature_counts();
+    shared_data = make_store("shared");
 
-    for(int i = 0; i != client.client_num; ++i){
-        if(i == client.client_id){
-            std::vector<std::vector<FSemi2kSharing<128, 12>>> tmp(training_data.size());
-            for(int j = 0; j != training_data.size(); ++j){
-                tmp[j] = client.double2share(training_data[j]);
-            }
-            for(const auto& pid: client.parties){
-                Serializer sr;
-                std::vector<std::vector<FSemi2kSharing<128, 12>>> secret(training_data.size());
-                for(int j = 0; j != training_data.size(); ++j){
-                    for(int k = 0; k != training_data[0].size(); ++k){
-                        secret[j].emplace_back(double(client.sc.randomGenerator.get_random()) / (1 >> 12));
-                        tmp[j][k] = tmp[j][k] - secret[j][k];
+    for(size_t first = 0; first < shared_data.rows(); first += batchsize){
+        size_t last = std::min(shared_data.rows(), first + batchsize);
+        for(int i = 0; i != client.client_num; ++i){
+            std::vector<std::vector<FSemi2kSharing<N, D>>> tmp;
+            if(i == client.client_id){
+                tmp.resize(last - first);
+                for(size_t j = first; j != last; ++j){
+                    tmp[j - first] = client.double2share(training_data[j]);
+                }
+                for(const auto& pid: client.parties){
+                    std::vector<std::vector<FSemi2kSharing<N, D>>> secret(tmp.size());
+                    for(int j = 0; j != tmp.size(); ++j){
+                        for(int k = 0; k != tmp[j].size(); ++k){
+                            secret[j].emplace_back(double(client.sc.randomGenerator.get_random()) / (1UL << D));
+                            tmp[j][k] = tmp[j][k] - secret[j][k];
+                        }
                     }
+                    client.send_message_spec(pid, secret);
                 }
-                client.send_message_spec(pid, secret);
             }
-            for(int j = 0; j != tmp.size(); ++j){
-                shared_data[j].insert(shared_data[j].end(), tmp[j].begin(), tmp[j].end());
-            }  
-        }
-        else{
-            std::vector<std::vector<FSemi2kSharing<128, 12>>> tmp;
-            client.recv_message_spec(i, tmp);
-            for(int j = 0; j != tmp.size(); ++j){
-                shared_data[j].insert(shared_data[j].end(), tmp[j].begin(), tmp[j].end());
+            else{
+                client.recv_message_spec(i, tmp);
             }
+            shared_data.write(first, tmp, feature_offsets[i]);
         }
+        shared_data.release(first, last);
     }
-    
-    w.resize(shared_data[0].size());
+
+    w.resize(shared_data.cols());
 }
 
-std::vector<double> PSVLR::compute_aggregate_value(int left, int right, int block_id){
+template <size_t N, size_t D>
+std::vector<double> PSVLR<N, D>::compute_aggregate_value(int left, int right, int block_id){
+    network::PhaseGuard phase(client.mplayer->phases(), "aggregate");
+    trace::Scope scope("aggregate");
     auto secret = client.double2share(w);
-    std::vector<std::vector<FSemi2kSharing<128UL, 12UL>>> tmp(masked_shared_data.begin() + left, masked_shared_data.begin() + right);
-    vector<FSemi2kSharing<128UL, 12UL>> ret = client.sc.mult_sharing_matrix(tmp, secret, block_id);
+    auto tmp = masked_shared_data.read(left, right);
+    vector<FSemi2kSharing<N, D>> ret = client.sc.mult_sharing_matrix(tmp, secret, block_id);
     return client.share2double(ret);
 }
 
-std::vector<double> PSVLR::compute_y_hat(const std::vector<double>& aggregate_value){
-    std::vector<FSemi2kSharing<128,12>> share(aggregate_value.size());
-    for(int i = 0; i != aggregate_value.size(); ++i){
-        share[i] = aggregate_value[i];
-    }
-    std::vector<FSemi2kSharing<128, 12>> aggregate_value_2, aggregate_value_3, u, b1(aggregate_value.size()), b2(aggregate_value.size()), t1, t2;
-    aggregate_value_2 = client.sc.mult_sharing(share, share);
-    aggregate_value_3 = client.sc.mult_sharing(aggregate_value_2, share);
-    u = client.sc.add(client.sc.mult(aggregate_value_3, -0.006), client.sc.mult(share, 0.214));
-    if(client.id == SUPER_CLIENT_ID){
-        u = client.sc.add(u, 0.5);
-        std::vector<Semi2kSharing<128>> tmp_1(u.size()), tmp_2(u.size());
-        std::vector<FSemi2kSharing<128, 12>> tmp_a, tmp_b;
-        tmp_a = client.sc.add(u, 4.0);
-        tmp_b = client.sc.add(u, -4.0);
-        for(int i = 0; i != u.size(); ++i){
-            tmp_1[i] = UnsignedZ2<128>(tmp_a[i].get_data());
-            tmp_2[i] = UnsignedZ2<128>(tmp_b[i].get_data());
-        }
-        std::vector<Semi2kSharing<128>> msb_1, msb_2;
-        msb_1 = client.sc.msb(tmp_1);
-        
-
-        msb_2 = client.sc.msb(tmp_2);
+template <size_t N, size_t D>
+std::vector<double> PSVLR<N, D>::compute_y_hat(const std::vector<double>& aggregate_value){
+    return client.share2double(compute_y_hat(client.double2share(aggregate_value)));
+}
 
-        for(int i = 0; i != u.size(); ++i){
-            b1[i] = FSemi2kSharing<128, 12>(SignedZ2<128>(msb_1[i] << 12));
-            b2[i] = FSemi2kSharing<128, 12>(SignedZ2<128>(msb_2[i] << 12));
-        }
-        t1 = client.sc.mult(client.sc.add(b2, -1.0), -1.0);
-        t2 = client.sc.mult(client.sc.add(b1, -1.0), -1.0);
-    }
-    else{
-        std::vector<Semi2kSharing<128>> tmp_0(u.size());
-        for(int i = 0; i != u.size(); ++i){
-            tmp_0[i] = UnsignedZ2<128>(u[i].get_data());
-        }
-        std::vector<Semi2kSharing<128>> msb_1, msb_2;
-        msb_1 = client.sc.msb(tmp_0);
-        msb_2 = client.sc.msb(tmp_0);
-        for(int i = 0; i != u.size(); ++i){
-            b1[i] = FSemi2kSharing<128, 12>(SignedZ2<128>(msb_1[i] << 12));
-            b2[i] = FSemi2kSharing<128, 12>(SignedZ2<128>(msb_2[i] << 12));
-        }
-        t1 = client.sc.mult(b2, -1.0);
-        t2 = client.sc.mult(b1, -1.0);
-    }
+template <size_t N, size_t D>
+std::vector<FSemi2kSharing<N, D>> PSVLR<N, D>::compute_y_hat(const std::vector<FSemi2kSharing<N, D>>& aggregate_value){
+    network::PhaseGuard phase(client.mplayer->phases(), "sigmoid");
+    return std::get<0>(sigmoid_scheduler.run(co_compute_y_hat(aggregate_value)));
+}
 
-    std::vector<FSemi2kSharing<128, 12>> tmp = client.sc.mult_sharing(client.sc.mult_sharing(b2, t2), u);
+template <size_t N, size_t D>
+Task<std::vector<FSemi2kSharing<N, D>>> PSVLR<N, D>::co_compute_y_hat(const std::vector<FSemi2kSharing<N, D>>& aggregate_value){
+    trace::Scope scope("sigmoid");
+    // u = 0.5 + 0.214 x - 0.006 x^3, saturated to 0 below -4 and to 1 from 4 on
+    static const std::vector<double> coeffs{0.5, 0.214, 0, -0.006};
+    static const std::vector<double> thresholds{-4.0, 4.0}, slopes{0, 1, 0}, intercepts{0, 0, 1};
+    auto u = co_await nonlinear::co_polynomial(client.sc, aggregate_value, coeffs);
+    co_return co_await nonlinear::co_piecewise_linear(client.sc, u, thresholds, slopes, intercepts);
+}
 
-    auto ll = client.sc.add(t1, tmp);
+template <size_t N, size_t D>
+Task<std::vector<FSemi2kSharing<N, D>>> PSVLR<N, D>::co_predict_batch(const PlainMatrix<N>& batch){
+    auto aggregate_value = co_await client.sc.co_mult_plain_matrix(batch, shared_w);
+    co_return co_await co_compute_y_hat(aggregate_value);
+}
 
-    std::vector<double> ret(ll.size());
-    for(int i = 0; i != ll.size(); ++i){
-        ret[i] = double(ll[i]);
+template <size_t N, size_t D>
+std::vector<FSemi2kSharing<N, D>> PSVLR<N, D>::predict_hybrid(RoundScheduler<N>* scheduler){
+    network::PhaseGuard phase(client.mplayer->phases(), "predict");
+    std::vector<PlainMatrix<N>> batches;
+    for(int left = 0; left < client.sample_num; left += batchsize){
+        batches.push_back(plain_batch(left, std::min(client.sample_num, left + batchsize), 1, false));
     }
+    std::vector<Task<std::vector<FSemi2kSharing<N, D>>>> tasks;
+    for(const auto& batch: batches) tasks.push_back(co_predict_batch(batch));
 
+    RoundScheduler<N> own(client.mplayer);
+    auto y_hats = (scheduler ? *scheduler : own).run_all(std::move(tasks));
+    std::vector<FSemi2kSharing<N, D>> ret;
+    ret.reserve(client.sample_num);
+    for(const auto& y: y_hats) ret.insert(ret.end(), y.begin(), y.end());
     return ret;
 }
 
-void PSVLR::update_parameters(int left, int right, const std::vector<double>& y_hat, double alpha, int block_id){
+template <size_t N, size_t D>
+void PSVLR<N, D>::update_parameters(int left, int right, const std::vector<double>& y_hat, double alpha, int block_id){
+    network::PhaseGuard phase(client.mplayer->phases(), "gradient");
+    trace::Scope scope("gradient");
 
     std::vector<double> res(y_hat.size());
     if(client.client_id == SUPER_CLIENT_ID){
@@ -126,53 +140,228 @@ void PSVLR::update_parameters(int left, int right, const std::vector<double>& y_
     }
     auto secret = client.double2share(res);
     
-    vector<vector<FSemi2kSharing<128, 12>>> masked_shared_x_T(shared_data[0].size());
-    for(int i = 0; i != masked_shared_x_T.size(); ++i){
-        masked_shared_x_T[i].resize(right - left);
-        for(int j = 0; j != masked_shared_x_T[i].size(); ++j){
-
-            masked_shared_x_T[i][j] = masked_shared_data[left + j][i];
+    vector<vector<FSemi2kSharing<N, D>>> masked_shared_x_T(masked_shared_data.cols(), vector<FSemi2kSharing<N, D>>(right - left));
+    for(int j = 0; j != right - left; ++j){
+        auto row = masked_shared_data.row(left + j);
+        for(int i = 0; i != masked_shared_x_T.size(); ++i){
+            masked_shared_x_T[i][j] = row[i];
         }
     }
 
-    std::vector<FSemi2kSharing<128, 12>> gradients = client.sc.mult_sharing_matrix(masked_shared_x_T, secret, block_id);
+    std::vector<FSemi2kSharing<N, D>> gradients = client.sc.mult_sharing_matrix(masked_shared_x_T, secret, block_id);
     auto double_gradients = client.share2double(gradients);
     add_in_place(w, double_gradients,  -alpha / (right - left));
 
 }
 
-void PSVLR::mask_shared_data(){
-    masked_shared_data.resize(shared_data.size());
-    std::vector<std::vector<std::vector<Semi2kSharing<128>>>> U;
-    auto& tmp = client.sc.matrix_triples[std::make_pair(batchsize, shared_data[0].size())];
+template <size_t N, size_t D>
+void PSVLR<N, D>::mask_shared_data(){
+    network::PhaseGuard phase(client.mplayer->phases(), "mask");
+    masked_shared_data = make_store("masked");
+    if(client.sc.is_symbolic()){
+        for(size_t first = 0; first < shared_data.rows(); first += batchsize){
+            masked_shared_data.write(first, shared_data.read(first, std::min(shared_data.rows(), first + batchsize)));
+        }
+        return;
+    }
+    auto& tmp = client.sc.matrix_triples[std::make_pair(batchsize, int(shared_data.cols()))];
     for(int i = 0; i != tmp.size(); ++i){
-        for(int j = 0; j != tmp[0].U.size(); ++j){
-            std::vector<FSemi2kSharing<128, 12>> ret(shared_data[0].size());
-            std::vector<Semi2kSharing<128>> unsignedz(shared_data[0].size());
+        for(int j = 0; j != tmp[i].U.size() && i * tmp[0].U.size() + j < shared_data.rows(); ++j){
+            auto src = shared_data.row(i * tmp[0].U.size() + j);
+            auto dst = masked_shared_data.row(i * tmp[0].U.size() + j);
+            std::vector<Semi2kSharing<N>> unsignedz(src.size());
             for(int k = 0; k != unsignedz.size(); ++k){
-                unsignedz[k] = UnsignedZ2<128>(shared_data[i * tmp[0].U.size() + j][k].get_data());
+                unsignedz[k] = UnsignedZ2<N>(src[k].get_data());
             }
-            std::vector<Semi2kSharing<128>> unsigned_zret = client.sc.add(unsignedz, mult(U[i][j], -1));
-            for(int k = 0; k != ret.size(); ++k){
-                ret[i] = SignedZ2<128>(unsigned_zret[i]);
+            std::vector<Semi2kSharing<N>> unsigned_zret = evaluate(unsignedz - tmp[i].U[j]);
+            for(int k = 0; k != dst.size(); ++k){
+                dst[k] = SignedZ2<N>(unsigned_zret[k]);
             }
-            masked_shared_data[i * tmp[0].U.size() + j] = ret;
         }
+        // batch i is written out, neither copy is needed until training reaches it
+        shared_data.release(i * tmp[0].U.size(), (i + 1) * tmp[0].U.size());
+        masked_shared_data.release(i * tmp[0].U.size(), (i + 1) * tmp[0].U.size());
     }
 }
 
-void PSVLR::train(int iter, double alpha){
+template <size_t N, size_t D>
+void PSVLR<N, D>::train(int iter, double alpha){
+    network::PhaseGuard phase(client.mplayer->phases(), "train");
     mask_shared_data();
+    int rows = masked_shared_data.rows();
     for(int j = 0; j != iter; ++j){
-        for(int i = 0; i * batchsize < shared_data.size(); ++i){
-            std::vector<double> aggregate_value = compute_aggregate_value(i * batchsize, shared_data.size() < i * batchsize + batchsize ? shared_data.size(): i * batchsize + batchsize, i);
+        for(int i = 0; i * batchsize < rows; ++i){
+            trace::Scope scope("batch");
+            int left = i * batchsize, right = std::min(rows, left + batchsize);
+            // read the next batch ahead while this one is computed, the first one again at the end of an epoch
+            masked_shared_data.prefetch(right < rows ? right : 0, right < rows ? right + batchsize : batchsize);
+            std::vector<double> aggregate_value = compute_aggregate_value(left, right, i);
             std::vector<double> y_hat = compute_y_hat(aggregate_value);
-            update_parameters(i * batchsize, shared_data.size() < i * batchsize + batchsize ? shared_data.size(): i * batchsize + batchsize, y_hat, alpha, i);
+            update_parameters(left, right, y_hat, alpha, i);
+            masked_shared_data.release(left, right);
+        }
+    }
+}
+
+template <size_t N, size_t D>
+void PSVLR<N, D>::share_partition(){
+    network::PhaseGuard phase(client.mplayer->phases(), "share_partition");
+
+    training_data = client.local_data;
+    training_data_labels = client.labels;
+
+    share_feature_counts();
+    shared_w.assign(feature_offsets.back(), FSemi2kSharing<N, D>(0.0));
+}
+
+template <size_t N, size_t D>
+PlainMatrix<N> PSVLR<N, D>::plain_batch(int left, int right, double factor, bool transpose) const{
+    size_t rows = right - left, features = feature_offsets.back();
+    PlainMatrix<N> ret{transpose ? features : rows, transpose ? rows : features, {}};
+    for(int p = 0; p != client.client_num; ++p){
+        size_t col = feature_offsets[p], cols = feature_offsets[p + 1] - feature_offsets[p];
+        typename PlainMatrix<N>::Block b = transpose
+            ? typename PlainMatrix<N>::Block{playerid_t(p), col, 0, cols, rows, {}}
+            : typename PlainMatrix<N>::Block{playerid_t(p), 0, col, rows, cols, {}};
+        if(p == client.client_id && client.is_sparse()){
+            // the same rows serve X and X^T, only the values are encoded
+            b.sparse = client.local_sparse.template slice<Semi2kSharing<N>>(left, right, [&](double x){
+                double scaled = x * factor;
+                SignedZ2<N> encoded;
+                fixed_point_codec::encode<N, D>(std::span<const double>(&scaled, 1), std::span(&encoded, 1));
+                return Semi2kSharing<N>(UnsignedZ2<N>(encoded));
+            });
+            b.transposed = transpose;
+        }
+        else if(p == client.client_id){
+            b.data.assign(b.rows, std::vector<Semi2kSharing<N>>(b.cols));
+            std::vector<double> scaled(cols);
+            std::vector<SignedZ2<N>> encoded(cols);
+            for(size_t i = 0; i != rows; ++i){
+                for(size_t j = 0; j != cols; ++j) scaled[j] = training_data[left + i][j] * factor;
+                fixed_point_codec::encode<N, D>(scaled, std::span(encoded));
+                for(size_t j = 0; j != cols; ++j){
+                    (transpose ? b.data[j][i] : b.data[i][j]) = UnsignedZ2<N>(encoded[j]);
+                }
+            }
+        }
+        ret.blocks.push_back(std::move(b));
+    }
+    return ret;
+}
+
+template <size_t N, size_t D>
+std::vector<std::vector<double>> PSVLR<N, D>::local_columns(int left, int right, double factor) const{
+    std::vector<std::vector<double>> ret(client.feature_num, std::vector<double>(right - left, 0));
+    if(client.is_sparse()){
+        const auto& a = client.local_sparse;
+        for(int i = left; i != right; ++i){
+            for(size_t k = a.row_ptr[i]; k != a.row_ptr[i + 1]; ++k){
+                ret[a.col_idx[k]][i - left] = a.value(k) * factor;
+            }
+        }
+        return ret;
+    }
+    for(int i = left; i != right; ++i){
+        for(int j = 0; j != ret.size(); ++j){
+            ret[j][i - left] = training_data[i][j] * factor;
+        }
+    }
+    return ret;
+}
+
+template <size_t N, size_t D>
+std::vector<FSemi2kSharing<N, D>> PSVLR<N, D>::compute_step_he(const std::vector<std::vector<double>>& columns, const std::vector<FSemi2kSharing<N, D>>& residual, size_t extra){
+    trace::Scope scope("gradient_he");
+    auto c_r = client.broadcast(client.share2homo(residual, SUPER_CLIENT_ID), SUPER_CLIENT_ID);
+
+    std::vector<FSemi2kSharing<N, D>> step;
+    step.reserve(feature_offsets.back());
+    for(int p = 0; p != client.client_num; ++p){
+        Ciphertext<DCRTPoly> c_g = nullptr;
+        if(p == client.client_id) c_g = client.inner_products(columns, c_r);
+        auto g = client.double2share(client.homo2share(p, c_g, feature_offsets[p + 1] - feature_offsets[p]));
+        step.insert(step.end(), g.begin(), g.end());
+    }
+    if(extra == 0) return step;
+
+    // the shares are rounded to 2^-D of the scaled step, i.e. to 2^-(D + extra) of the step
+    std::vector<Semi2kSharing<N>> scaled(step.size());
+    for(int k = 0; k != step.size(); ++k) scaled[k] = UnsignedZ2<N>(step[k].get_data());
+    return client.sc.truncate(scaled, extra);
+}
+
+template <size_t N, size_t D>
+void PSVLR<N, D>::train_hybrid(int iter, double alpha){
+    network::PhaseGuard phase(client.mplayer->phases(), "train");
+
+    // the owners fold the step size c into X^T, with extra fractional bits so that c * x keeps
+    // the precision of x, and the product is truncated by all of them at once
+    // with |x| <= 1 the step c * X^T r is at most alpha and carries 2D + extra fractional bits
+    // before the truncation, which fails with probability about its size / 2^(N-1): extra keeps
+    // 24 bits of headroom below that, so 64-bit rings trade precision of c * x for it
+    constexpr int headroom = 24;
+    int max_extra = std::max(0, int(N) - 1 - headroom - 2 * int(D) - int(std::ceil(std::log2(alpha))));
+    std::vector<PlainMatrix<N>> batches, batches_T;
+    std::vector<size_t> bits_T, extra_he;
+    std::vector<std::vector<std::vector<double>>> columns;
+    if(he_gradient && client.batchsize != 0){
+        // Enc(r) holds a batch, the step of client p comes back in feature_num(p) slots
+        size_t slots = client.batchsize;
+        for(int p = 0; p != client.client_num; ++p){
+            if(size_t(feature_offsets[p + 1] - feature_offsets[p]) > slots){
+                throw std::invalid_argument("train_hybrid: client " + std::to_string(p) + " has more features than the "
+                    + std::to_string(slots) + " CKKS slots");
+            }
+        }
+        if(std::bit_ceil(size_t(batchsize)) > slots){
+            throw std::invalid_argument("train_hybrid: batch size exceeds the " + std::to_string(slots) + " CKKS slots");
+        }
+    }
+    for(int left = 0; left < client.sample_num; left += batchsize){
+        int right = std::min(client.sample_num, left + batchsize);
+        double c = alpha / (right - left);
+        int wanted = int(nonlinear::detail::extra_bits<N, D>) + std::max(0, int(std::ceil(-std::log2(c))));
+        size_t extra = std::min(wanted, max_extra);
+        batches.push_back(plain_batch(left, right, 1, false));
+        if(he_gradient){
+            // the scaled step stays in the range of the homo2share masks, below 2^(31 - D)
+            size_t mask_extra = std::max(0, 31 - int(D) - int(std::ceil(std::log2(alpha))));
+            extra_he.push_back(std::min(extra, mask_extra));
+            columns.push_back(local_columns(left, right, std::ldexp(c, extra_he.back())));
+        }
+        else{
+            batches_T.push_back(plain_batch(left, right, std::ldexp(c, extra), true));
+            bits_T.push_back(D + extra);
+        }
+    }
+
+    for(int j = 0; j != iter; ++j){
+        for(int i = 0; i != batches.size(); ++i){
+            trace::Scope scope("batch");
+            int left = i * batchsize;
+            std::vector<FSemi2kSharing<N, D>> aggregate_value;
+            {
+                network::PhaseGuard phase(client.mplayer->phases(), "aggregate");
+                trace::Scope scope("aggregate");
+                aggregate_value = client.sc.mult_plain_matrix(batches[i], shared_w);
+            }
+            auto residual = compute_y_hat(aggregate_value);
+            {
+                network::PhaseGuard phase(client.mplayer->phases(), "gradient");
+                trace::Scope scope("gradient");
+                if(client.client_id == SUPER_CLIENT_ID){
+                    for(int k = 0; k != residual.size(); ++k) residual[k] -= FSemi2kSharing<N, D>(training_data_labels[left + k]);
+                }
+                auto step = he_gradient ? compute_step_he(columns[i], residual, extra_he[i]) : client.sc.mult_plain_matrix(batches_T[i], residual, bits_T[i]);
+                for(int k = 0; k != shared_w.size(); ++k) shared_w[k] -= step[k];
+            }
         }
     }
 }
 
-std::vector<double> PSVLR::predict(std::vector<std::vector<double>> X){
+template <size_t N, size_t D>
+std::vector<double> PSVLR<N, D>::predict(std::vector<std::vector<double>> X){
 
     std::vector<std::vector<double>> X_transpose(X[0].size());
     for(int i = 0; i != X_transpose.size(); ++i){
@@ -183,8 +372,14 @@ std::vector<double> PSVLR::predict(std::vector<std::vector<double>> X){
     }
 
     std::vector<Ciphertext<DCRTPoly>> cs(X_transpose.size());
-    for(int i = 0; i != cs.size(); ++i){
-        cs[i] = client.cc->EvalMult(client.encode(X_transpose[i]), w_for_predict[i]);
+    {
+        // the tracer is per thread, one event for the whole batch
+        trace::Scope scope("EvalMult", trace::he);
+        parallel_for(client.sc.get_thread_pool(), cs.size(), 1, [&](size_t begin, size_t end){
+            for(size_t i = begin; i != end; ++i){
+                cs[i] = client.cc->EvalMult(client.encode(X_transpose[i]), w_for_predict[i]);
+            }
+        });
     }
     Ciphertext<DCRTPoly> c = client.cc->EvalAddMany(cs);
 
@@ -211,3 +406,7 @@ std::vector<double> PSVLR::predict(std::vector<std::vector<double>> X){
     }
 
 }
+
+template class PSVLR<64, 16>;
+template class PSVLR<128, 12>;
+template class PSVLR<128, 20>;
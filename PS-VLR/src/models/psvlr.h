@@ -1,34 +1,67 @@
 #pragma once
 
+#include <string>
 #include <vector>
 #include "../client/client.hpp"
+#include "../mpc/fsemi2k/fsemi2k_nonlinear.hpp"
+#include "../tools/share_store.hpp"
 #include "openfhe.h"
 
+// instantiated in psvlr.cpp for the rings selectable at runtime, see test.cpp
+template <size_t N, size_t D>
 class PSVLR {
 public:
     std::vector<double> w;                              // weight of each feature
     std::vector<Ciphertext<DCRTPoly>> w_for_predict;    // 
     std::vector<double> training_data_labels;           // labels of training dataset
     std::vector< std::vector<double>> training_data;    // training dataset
-    std::vector<std::vector<FSemi2kSharing<128, 12>>> shared_data;
-    std::vector<std::vector<FSemi2kSharing<128, 12>>> masked_shared_data;
+    ShareStore<FSemi2kSharing<N, D>> shared_data;       // chunked by batch
+    ShareStore<FSemi2kSharing<N, D>> masked_shared_data;
+    std::string store_dir;                              // directory of the share files, empty keeps the shares in memory
+    std::vector<FSemi2kSharing<N, D>> shared_w;         // hybrid: share of the weights
+    std::vector<int> feature_offsets;                   // hybrid: first column of each client, client_num + 1 entries
+    bool he_gradient = false;                           // hybrid: X_p^T * r by HE instead of plaintext-by-share products
 
     int batchsize;                                      // batchsize of minibatch-sgd
-    Client& client;                                     // client
+    Client<N, D>& client;                                     // client
+    RoundScheduler<N> sigmoid_scheduler;                // runs every compute_y_hat, rounds and openings add up
 
 public:
 
-    PSVLR(Client& client, int batchsize);
+    PSVLR(Client<N, D>& client, int batchsize);
 
     ~PSVLR();
 
+    // shares are exchanged, stored and masked batch by batch, with store_dir set only the
+    // batch in use and the next one read ahead stay in memory
     void share_data();
 
     void train(int iter = 1, double alpha = 0.001);
 
+    // hybrid mode: the data stays with its owners in plaintext and only the weights are shared.
+    // X_p * w_p and X_p^T * r are plaintext-by-share products: per batch one vector of the size
+    // of the weights and one of the batch are opened, and each client only touches its own columns
+    // sparse local data (Client::to_sparse) stays sparse, X and X^T are products over its nonzeros
+    void share_partition();
+
+    // with he_gradient the label client gathers Enc(r) and sends it around, every client computes
+    // X_p^T * Enc(r) locally and turns it into shares with homo2share: no triples in the backward
+    // pass, a threshold decryption per client instead, needs initialize_keys
+    void train_hybrid(int iter = 1, double alpha = 0.001);
+
     std::vector<double> predict(std::vector<std::vector<double>> X);
 
+    // hybrid mode: shares of the predicted probabilities of this client's training rows with the
+    // current weights. the batches run as coroutines side by side on scheduler, or on a scheduler
+    // of its own, so all of them take the rounds of one
+    std::vector<FSemi2kSharing<N, D>> predict_hybrid(RoundScheduler<N>* scheduler = nullptr);
+
 private:
+    // feature counts of all clients, columns are laid out in client order
+    void share_feature_counts();
+
+    ShareStore<FSemi2kSharing<N, D>> make_store(const std::string& name) const;
+
     void mask_shared_data();
 
     void update_parameters(int left, int right, const std::vector<double>& y_hat, double alpha, int block_id);
@@ -36,4 +69,21 @@ private:
     std::vector<double> compute_aggregate_value(int left, int right, int block_id);
 
     std::vector<double> compute_y_hat(const std::vector<double>& aggregate_value);
+
+    // runs co_compute_y_hat on a RoundScheduler, the independent steps inside share their rounds
+    std::vector<FSemi2kSharing<N, D>> compute_y_hat(const std::vector<FSemi2kSharing<N, D>>& aggregate_value);
+
+    Task<std::vector<FSemi2kSharing<N, D>>> co_compute_y_hat(const std::vector<FSemi2kSharing<N, D>>& aggregate_value);
+
+    // hybrid mode: y_hat of one batch, X * w and the sigmoid
+    Task<std::vector<FSemi2kSharing<N, D>>> co_predict_batch(const PlainMatrix<N>& batch);
+
+    // rows [left, right) of this client's columns times factor, column blocks owned by their clients
+    PlainMatrix<N> plain_batch(int left, int right, double factor, bool transpose) const;
+
+    // rows [left, right) of this client's columns times factor, one vector per column
+    std::vector<std::vector<double>> local_columns(int left, int right, double factor) const;
+
+    // columns hold c * 2^extra * X_p^T, the step comes back with D + extra fractional bits and is truncated
+    std::vector<FSemi2kSharing<N, D>> compute_step_he(const std::vector<std::vector<double>>& columns, const std::vector<FSemi2kSharing<N, D>>& residual, size_t extra);
 };
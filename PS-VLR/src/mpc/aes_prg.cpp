@@ -0,0 +1,43 @@
+#include "aes_prg.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <openssl/evp.h>
+
+namespace {
+// any public constant works, the PRG is keyed by the seed through MMO
+const unsigned char fixed_key[16] = {
+    0x61, 0x7e, 0x8d, 0xa2, 0xa0, 0x51, 0x1e, 0x96,
+    0x5e, 0x41, 0xc2, 0x9b, 0x15, 0x3f, 0xc7, 0x7a
+};
+constexpr size_t max_blocks = 8;
+}
+
+AesPrg::AesPrg(): ctx(EVP_CIPHER_CTX_new()){
+    if(!ctx || EVP_EncryptInit_ex(ctx, EVP_aes_128_ecb(), nullptr, fixed_key, nullptr) != 1){
+        throw std::runtime_error("cannot initialize AES");
+    }
+    EVP_CIPHER_CTX_set_padding(ctx, 0);
+}
+
+AesPrg::~AesPrg(){
+    EVP_CIPHER_CTX_free(ctx);
+}
+
+void AesPrg::expand(const Block& seed, Block* out, size_t n){
+    if(n > max_blocks) throw std::invalid_argument("AesPrg: too many output blocks");
+    Block in[max_blocks];
+    for(size_t j = 0; j != n; ++j) in[j] = seed ^ Block{j, 0};
+
+    int len = 0;
+    if(EVP_EncryptUpdate(ctx, reinterpret_cast<unsigned char*>(out), &len,
+            reinterpret_cast<const unsigned char*>(in), int(n * sizeof(Block))) != 1){
+        throw std::runtime_error("AES encryption failed");
+    }
+    for(size_t j = 0; j != n; ++j) out[j] ^= in[j];
+}
+
+AesPrg& AesPrg::local(){
+    thread_local AesPrg prg;
+    return prg;
+}
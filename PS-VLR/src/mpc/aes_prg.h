@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/// @brief 128-bit seed or PRG output block
+struct Block{
+    std::uint64_t lo = 0;
+    std::uint64_t hi = 0;
+
+    Block operator^(const Block& rhs) const { return Block{lo ^ rhs.lo, hi ^ rhs.hi}; }
+    Block& operator^=(const Block& rhs) { lo ^= rhs.lo; hi ^= rhs.hi; return *this; }
+    bool operator==(const Block& rhs) const = default;
+
+    bool lsb() const { return lo & 1; }
+};
+
+struct evp_cipher_ctx_st;
+
+/// @brief Length-doubling PRG from fixed-key AES-128 in Matyas-Meyer-Oseas mode,
+/// out_j = AES_k(seed ^ j) ^ seed ^ j with a public key k
+/// one instance per thread, see local()
+class AesPrg{
+private:
+    evp_cipher_ctx_st* ctx;
+
+public:
+    AesPrg();
+    ~AesPrg();
+    AesPrg(const AesPrg&)            = delete;
+    AesPrg& operator=(const AesPrg&) = delete;
+
+    /// @brief n output blocks from one seed
+    void expand(const Block& seed, Block* out, size_t n);
+
+    static AesPrg& local();
+};
@@ -0,0 +1,45 @@
+#include "cost_model.h"
+
+#include <fmt/format.h>
+
+CostModel& CostModel::operator+=(const CostModel& other){
+    triples += other.triples;
+    binary_triples += other.binary_triples;
+    rand_bits += other.rand_bits;
+    edabits += other.edabits;
+    dabits += other.dabits;
+    dcf_keys += other.dcf_keys;
+    king_openings += other.king_openings;
+    for(const auto& [shape, count]: other.matrix_triples) matrix_triples[shape] += count;
+    for(const auto& [shape, count]: other.plain_matrix_triples) plain_matrix_triples[shape] += count;
+    he_encrypt += other.he_encrypt;
+    he_eval_mult += other.he_eval_mult;
+    he_eval_add += other.he_eval_add;
+    he_eval_rotate += other.he_eval_rotate;
+    he_decrypt += other.he_decrypt;
+    he_ciphertexts_send += other.he_ciphertexts_send;
+    he_ciphertexts_recv += other.he_ciphertexts_recv;
+    return *this;
+}
+
+std::string CostModel::to_json() const{
+    auto format_shapes = [](const std::map<std::pair<int, int>, size_type>& triples){
+        std::string shapes;
+        for(const auto& [shape, count]: triples){
+            shapes += fmt::format("{}\"{}x{}\": {}", shapes.empty() ? "" : ", ", shape.first, shape.second, count);
+        }
+        return shapes;
+    };
+    return fmt::format(
+        "{{\"symbolic\": {}, \"triples\": {}, \"binary_triples\": {}, \"rand_bits\": {}, "
+        "\"edabits\": {}, \"dabits\": {}, \"dcf_keys\": {}, \"king_openings\": {}, "
+        "\"matrix_triples\": {{{}}}, \"plain_matrix_triples\": {{{}}}, "
+        "\"he_encrypt\": {}, \"he_eval_mult\": {}, \"he_eval_add\": {}, \"he_eval_rotate\": {}, \"he_decrypt\": {}, "
+        "\"he_ciphertexts_send\": {}, \"he_ciphertexts_recv\": {}, "
+        "\"he_bytes_send\": {}, \"he_bytes_recv\": {}}}",
+        symbolic, triples, binary_triples, rand_bits, edabits, dabits, dcf_keys, king_openings,
+        format_shapes(matrix_triples), format_shapes(plain_matrix_triples),
+        he_encrypt, he_eval_mult, he_eval_add, he_eval_rotate, he_decrypt,
+        he_ciphertexts_send, he_ciphertexts_recv,
+        he_ciphertexts_send * ciphertext_bytes, he_ciphertexts_recv * ciphertext_bytes);
+}
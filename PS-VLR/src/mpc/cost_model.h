@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+
+/// @brief Tally of correlated randomness and HE work consumed by the protocols.
+/// Network rounds and bytes are counted by the player, see network::PhaseStatistics.
+/// In symbolic mode the protocols skip local arithmetic and HE evaluation
+/// and only count, so a whole training run can be costed without peers.
+struct CostModel{
+    using size_type = std::size_t;
+
+    bool symbolic = false;                                      // count only, do not compute
+
+    size_type triples = 0;                                      // beaver triples over Z_2^K
+    size_type binary_triples = 0;                               // beaver triples over Z_2
+    size_type rand_bits = 0;                                    // shared random bits
+    size_type edabits = 0;                                      // random values shared over Z_2^K and bitwise
+    size_type dabits = 0;                                       // random bits shared over Z_2^K and Z_2
+    size_type dcf_keys = 0;                                     // DCF key pairs of the msb comparison
+    size_type king_openings = 0;                                // openings relayed by a king, one extra hop each
+    std::map<std::pair<int, int>, size_type> matrix_triples;    // (n, m) -> matrix-vector triples
+    std::map<std::pair<int, int>, size_type> plain_matrix_triples;  // (n, m) -> triples of plaintext-by-share products
+
+    size_type he_encrypt = 0;
+    size_type he_eval_mult = 0;
+    size_type he_eval_add = 0;
+    size_type he_eval_rotate = 0;                               // rotations, e.g. inside inner sums
+    size_type he_decrypt = 0;                                   // partial decryptions and fusions
+    size_type he_ciphertexts_send = 0;
+    size_type he_ciphertexts_recv = 0;
+    size_type ciphertext_bytes = 0;                             // estimated size of one ciphertext
+
+    CostModel() = default;
+    explicit CostModel(bool symbolic): symbolic(symbolic){}
+
+    // adds the counts of other, e.g. of a background producer; symbolic and ciphertext_bytes stay
+    CostModel& operator+=(const CostModel& other);
+
+    std::string to_json() const;
+};
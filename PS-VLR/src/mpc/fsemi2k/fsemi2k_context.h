@@ -10,6 +10,8 @@ public:
     using typename Semi2kContext<N>::MatrixTripleSeries;
     using Semi2kContext<N>::add;
     using Semi2kContext<N>::mult;
+    using Semi2kContext<N>::mult_sharing_many;
+    using Semi2kContext<N>::co_mult_sharing_many;
     FSemi2kContext(Semi2kContext<N>& sc): Semi2kContext<N>(sc), sc(sc){};
     ~FSemi2kContext();
 
@@ -19,12 +21,31 @@ public:
     std::vector<FSemi2kSharing<N, D>> mult(const std::vector<FSemi2kSharing<N, D>>& sharings, const Plain& a);
     std::vector<FSemi2kSharing<N, D>> mult(const std::vector<FSemi2kSharing<N, D>>& sharings, const std::vector<Plain>& a);
     std::vector<FSemi2kSharing<N, D>> mult_sharing(const std::vector<FSemi2kSharing<N, D>>& sharings_a, const std::vector<FSemi2kSharing<N, D>>& sharings_b);
+    std::vector<std::vector<FSemi2kSharing<N, D>>> mult_sharing_many(const std::vector<std::vector<FSemi2kSharing<N, D>>>& sharings_a, const std::vector<std::vector<FSemi2kSharing<N, D>>>& sharings_b);
+    // coroutines behind mult_sharing and mult_sharing_many, see Semi2kContext::co_open
+    Task<std::vector<FSemi2kSharing<N, D>>> co_mult_sharing(const std::vector<FSemi2kSharing<N, D>>& sharings_a, const std::vector<FSemi2kSharing<N, D>>& sharings_b);
+    Task<std::vector<std::vector<FSemi2kSharing<N, D>>>> co_mult_sharing_many(const std::vector<std::vector<FSemi2kSharing<N, D>>>& sharings_a, const std::vector<std::vector<FSemi2kSharing<N, D>>>& sharings_b);
     std::vector<FSemi2kSharing<N, D>> mult_sharing_matrix(const std::vector<std::vector<FSemi2kSharing<N, D>>>& sharings_a, const std::vector<FSemi2kSharing<N, D>>& sharings_b, int block_id);
-    std::vector<FSemi2kSharing<N, D>> truncation(const std::vector<Semi2kSharing<N>>& sharings);
+    // a holds fixed-point values with bits fractional bits, see Semi2kContext::mult_plain_matrix
+    std::vector<FSemi2kSharing<N, D>> mult_plain_matrix(const PlainMatrix<N>& a, const std::vector<FSemi2kSharing<N, D>>& sharings_b, size_t bits = D);
+    Task<std::vector<FSemi2kSharing<N, D>>> co_mult_plain_matrix(const PlainMatrix<N>& a, const std::vector<FSemi2kSharing<N, D>>& sharings_b, size_t bits = D);
+    // shift right by bits with one opening, exact up to one ulp; the mask wraps with probability
+    // about |x| / 2^(N-1), which callers keep small by bounding the fractional bits of x
+    std::vector<FSemi2kSharing<N, D>> truncation(const std::vector<Semi2kSharing<N>>& sharings, size_t bits = D);
+    // shares carrying bits extra fractional bits, e.g. products: two parties shift their shares
+    // locally, which is off with probability about |x| / 2^N; with more parties the shares
+    // sum past the signed range almost surely, so they take one round through truncation
+    std::vector<FSemi2kSharing<N, D>> truncate(const std::vector<Semi2kSharing<N>>& sharings, size_t bits = D);
+    Task<std::vector<FSemi2kSharing<N, D>>> co_truncation(const std::vector<Semi2kSharing<N>>& sharings, size_t bits = D);
+    Task<std::vector<FSemi2kSharing<N, D>>> co_truncate(const std::vector<Semi2kSharing<N>>& sharings, size_t bits = D);
     void generate_triple(size_t n);
     void generate_rand_bit(size_t n);
     void generate_binary_triple(size_t n);
     void set_matrix_triple(const std::vector<MatrixTripleSeries>& triples, int n, int m);
+    void set_cost_model(CostModel* cost_model);
+    void set_matrix_triple_pool(MatrixTriplePool<N>* pool);
+    void set_dealer(Semi2kDealer<N>* dealer);
+    void set_msb_backend(MsbBackend backend);
     
 private:
     Semi2kContext<N>& sc;
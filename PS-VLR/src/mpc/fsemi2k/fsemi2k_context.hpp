@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include "fsemi2k_context.h"
 
 template <size_t N, size_t D>
@@ -51,18 +52,48 @@ std::vector<FSemi2kSharing<N, D>> FSemi2kContext<N, D>::mult(const std::vector<F
 
 template<size_t N, size_t D>
 std::vector<FSemi2kSharing<N, D>> FSemi2kContext<N, D>::mult_sharing(const std::vector<FSemi2kSharing<N, D>>& sharings_a, const std::vector<FSemi2kSharing<N, D>>& sharings_b){
+    return run_now<N>(co_mult_sharing(sharings_a, sharings_b));
+}
+
+template<size_t N, size_t D>
+Task<std::vector<FSemi2kSharing<N, D>>> FSemi2kContext<N, D>::co_mult_sharing(const std::vector<FSemi2kSharing<N, D>>& sharings_a, const std::vector<FSemi2kSharing<N, D>>& sharings_b){
     std::vector<Semi2kSharing<N>> unsigned_za(sharings_a.size()), unsigned_zb(sharings_b.size());
     for(int i = 0; i != unsigned_za.size(); ++i){
         unsigned_za[i] = UnsignedZ2<N>(sharings_a[i].get_data());
         unsigned_zb[i] = UnsignedZ2<N>(sharings_b[i].get_data());
     }
-    std::vector<Semi2kSharing<N>> unsigned_zret = sc.mult_sharing(unsigned_za, unsigned_zb);
-    // std::vector<FSemi2kSharing<N, D>> ret = truncation(unsigned_zret);
-    std::vector<FSemi2kSharing<N, D>> ret(unsigned_zret.size());
-    for(int i = 0; i != ret.size(); ++i){
-        ret[i] = (SignedZ2<N>(unsigned_zret[i]) >> D);
+    std::vector<Semi2kSharing<N>> unsigned_zret = co_await sc.co_mult_sharing(unsigned_za, unsigned_zb);
+    co_return co_await co_truncate(unsigned_zret);
+}
+
+template<size_t N, size_t D>
+std::vector<std::vector<FSemi2kSharing<N, D>>> FSemi2kContext<N, D>::mult_sharing_many(const std::vector<std::vector<FSemi2kSharing<N, D>>>& sharings_a, const std::vector<std::vector<FSemi2kSharing<N, D>>>& sharings_b){
+    return run_now<N>(co_mult_sharing_many(sharings_a, sharings_b));
+}
+
+template<size_t N, size_t D>
+Task<std::vector<std::vector<FSemi2kSharing<N, D>>>> FSemi2kContext<N, D>::co_mult_sharing_many(const std::vector<std::vector<FSemi2kSharing<N, D>>>& sharings_a, const std::vector<std::vector<FSemi2kSharing<N, D>>>& sharings_b){
+    std::vector<std::vector<Semi2kSharing<N>>> unsigned_za(sharings_a.size()), unsigned_zb(sharings_b.size());
+    for(int k = 0; k != unsigned_za.size(); ++k){
+        unsigned_za[k].resize(sharings_a[k].size());
+        for(int i = 0; i != unsigned_za[k].size(); ++i) unsigned_za[k][i] = UnsignedZ2<N>(sharings_a[k][i].get_data());
     }
-    return ret;
+    for(int k = 0; k != unsigned_zb.size(); ++k){
+        unsigned_zb[k].resize(sharings_b[k].size());
+        for(int i = 0; i != unsigned_zb[k].size(); ++i) unsigned_zb[k][i] = UnsignedZ2<N>(sharings_b[k][i].get_data());
+    }
+    auto unsigned_zret = co_await sc.co_mult_sharing_many(unsigned_za, unsigned_zb);
+    // all products share one truncation
+    std::vector<Semi2kSharing<N>> flat;
+    for(const auto& z: unsigned_zret) flat.insert(flat.end(), z.begin(), z.end());
+    auto truncated = co_await co_truncate(flat);
+    std::vector<std::vector<FSemi2kSharing<N, D>>> ret(unsigned_zret.size());
+    auto it = truncated.begin();
+    for(int k = 0; k != ret.size(); ++k){
+        ret[k].assign(it, it + unsigned_zret[k].size());
+        it += unsigned_zret[k].size();
+    }
+    co_return ret;
 }
 
 template<size_t N, size_t D>
@@ -80,45 +111,75 @@ std::vector<FSemi2kSharing<N, D>> FSemi2kContext<N, D>::mult_sharing_matrix(cons
     }
     // std::cout << "(" << unsigned_za.size() << ", " << unsigned_za[0].size() << "), " << unsigned_zb.size() << std::endl;
     std::vector<Semi2kSharing<N>> unsigned_zret = sc.mult_sharing_matrix(unsigned_za, unsigned_zb, block_id);
-    // std::vector<FSemi2kSharing<N, D>> ret = truncation(unsigned_zret);
-    std::vector<FSemi2kSharing<N, D>> ret(unsigned_zret.size());
-    for(int i = 0; i != ret.size(); ++i){
-        ret[i] = (SignedZ2<N>(unsigned_zret[i]) >> D);
+    return truncate(unsigned_zret);
+}
+
+template<size_t N, size_t D>
+std::vector<FSemi2kSharing<N, D>> FSemi2kContext<N, D>::mult_plain_matrix(const PlainMatrix<N>& a, const std::vector<FSemi2kSharing<N, D>>& sharings_b, size_t bits){
+    return run_now<N>(co_mult_plain_matrix(a, sharings_b, bits));
+}
+
+template<size_t N, size_t D>
+Task<std::vector<FSemi2kSharing<N, D>>> FSemi2kContext<N, D>::co_mult_plain_matrix(const PlainMatrix<N>& a, const std::vector<FSemi2kSharing<N, D>>& sharings_b, size_t bits){
+    std::vector<Semi2kSharing<N>> unsigned_zb(sharings_b.size());
+    for(int i = 0; i != unsigned_zb.size(); ++i){
+        unsigned_zb[i] = UnsignedZ2<N>(sharings_b[i].get_data());
     }
-    return ret;
+    auto product = co_await sc.co_mult_plain_matrix(a, unsigned_zb);
+    co_return co_await co_truncate(product, bits);
+}
+
+template<size_t N, size_t D>
+std::vector<FSemi2kSharing<N, D>> FSemi2kContext<N, D>::truncation(const std::vector<Semi2kSharing<N>>& sharings, size_t bits){
+    return run_now<N>(co_truncation(sharings, bits));
 }
 
 template<size_t N, size_t D>
-std::vector<FSemi2kSharing<N, D>> FSemi2kContext<N, D>::truncation(const std::vector<Semi2kSharing<N>>& sharings){
-    std::vector<std::vector<Semi2kSharing<N>>> rs(sharings.size());
+Task<std::vector<FSemi2kSharing<N, D>>> FSemi2kContext<N, D>::co_truncation(const std::vector<Semi2kSharing<N>>& sharings, size_t bits){
+    // phases nest as a stack, which interleaved coroutines would break
+    std::optional<network::PhaseGuard> phase;
+    if(!RoundScheduler<N>::current()) phase.emplace(this->mplayer->phases(), "truncation");
+    trace::Scope scope("truncation");
     std::vector<Semi2kSharing<N>> r(sharings.size(), 0), rr(sharings.size(), 0), c;
     std::vector<FSemi2kSharing<N, D>> b(sharings.size());
 
+    // r = rr * 2^bits + low from two edaBits, r < 2^(N-1) so r - x stays in the signed range
+    auto low = sc.get_edabit(sharings.size(), bits);
+    auto high = sc.get_edabit(sharings.size(), N - bits - 1);
     for(int i = 0; i != sharings.size(); ++i){
-        rs[i] = sc.get_rand_bit(N);
-        std::vector<Semi2kSharing<N>> tmp(N, 0);
-        rs[i] = tmp;
-
-        for(int j = 0; j != N; ++j){
-            r[i] += (rs[i][j] << j);
-        }
-        for(int j = D; j != N; ++j){
-            rr[i] += (rs[i][j] << (j - D));
-        }
+        rr[i] = high[i].r;
+        r[i] = (high[i].r << bits) + low[i].r;
     }
-    c = sc.open(sc.add(r, sc.mult(sharings, -1)));
+    auto masked = evaluate(r - sharings);
+    c = co_await sc.co_open(masked);
     for(int i = 0; i != sharings.size(); ++i){
         // b[i] = SignedZ2<N>((c[i] >> D) * (-1) + rr[i]);
         // b[i] = (SignedZ2<N>(c[i]) >> D) * (-1) + SignedZ2<N>(rr[i]);
         // b[i] = SignedZ2<N>(rr[i]);
         if(*this->parties.begin() > this->id){
-            b[i] = (SignedZ2<N>(c[i]) >> D) * (-1) + SignedZ2<N>(rr[i]);
+            b[i] = (SignedZ2<N>(c[i]) >> bits) * (-1) + SignedZ2<N>(rr[i]);
         }
         else {
             b[i] = SignedZ2<N>(rr[i]);
         }
     }
-    return b;
+    co_return b;
+}
+
+template<size_t N, size_t D>
+std::vector<FSemi2kSharing<N, D>> FSemi2kContext<N, D>::truncate(const std::vector<Semi2kSharing<N>>& sharings, size_t bits){
+    if(this->parties.size() > 1) return truncation(sharings, bits);
+    std::vector<FSemi2kSharing<N, D>> ret(sharings.size());
+    for(int i = 0; i != ret.size(); ++i){
+        ret[i] = (SignedZ2<N>(sharings[i]) >> bits);
+    }
+    return ret;
+}
+
+template<size_t N, size_t D>
+Task<std::vector<FSemi2kSharing<N, D>>> FSemi2kContext<N, D>::co_truncate(const std::vector<Semi2kSharing<N>>& sharings, size_t bits){
+    if(this->parties.size() > 1) co_return co_await co_truncation(sharings, bits);
+    co_return truncate(sharings, bits);
 }
 
 template<size_t N, size_t D>
@@ -143,4 +204,28 @@ template<size_t N, size_t D>
 void FSemi2kContext<N, D>::set_matrix_triple(const std::vector<MatrixTripleSeries>& triples, int n, int m){
     Semi2kContext<N>::set_matrix_triple(triples, n, m);
     sc.set_matrix_triple(triples, n, m);
-}
\ No newline at end of file
+}
+
+template<size_t N, size_t D>
+void FSemi2kContext<N, D>::set_cost_model(CostModel* cost_model){
+    Semi2kContext<N>::set_cost_model(cost_model);
+    sc.set_cost_model(cost_model);
+}
+
+template<size_t N, size_t D>
+void FSemi2kContext<N, D>::set_dealer(Semi2kDealer<N>* dealer){
+    Semi2kContext<N>::set_dealer(dealer);
+    sc.set_dealer(dealer);
+}
+
+template<size_t N, size_t D>
+void FSemi2kContext<N, D>::set_msb_backend(MsbBackend backend){
+    Semi2kContext<N>::set_msb_backend(backend);
+    sc.set_msb_backend(backend);
+}
+
+template<size_t N, size_t D>
+void FSemi2kContext<N, D>::set_matrix_triple_pool(MatrixTriplePool<N>* pool){
+    Semi2kContext<N>::set_matrix_triple_pool(pool);
+    sc.set_matrix_triple_pool(pool);
+}
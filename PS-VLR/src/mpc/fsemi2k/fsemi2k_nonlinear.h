@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "fsemi2k_scaled.hpp"
+
+/// @brief Secure nonlinear functions on vectors of fixed-point shares.
+/// Counterparts of the plaintext PPPU routines in datatypes/math.hpp, built for few rounds:
+/// independent products share one opening (mult_sharing_many), powers are computed
+/// by repeated doubling and polynomials are evaluated with the Paterson-Stockmeyer split,
+/// so a polynomial of degree d costs about log2(d) + 1 rounds instead of d
+/// (one more with more than two parties, see FSemi2kContext::truncate).
+/// Comparison bits and intermediate products that feed one more product are kept as
+/// ScaledSharings, so they are truncated once at the end rather than after every step.
+/// Constants are added by the leader only, like every other public value.
+/// Each function with openings has a coroutine co_ counterpart, see Semi2kContext::co_open:
+/// under a RoundScheduler independent calls, e.g. the predictions of several batches, share
+/// their rounds, and so do the independent steps inside one call.
+namespace nonlinear
+{
+
+template <size_t N, size_t D>
+using Sharings = std::vector<FSemi2kSharing<N, D>>;
+
+/// @brief x^1, ..., x^k, element i holds x^(i+1)
+/// ceil(log2 k) rounds
+template <size_t N, size_t D>
+std::vector<Sharings<N, D>> powers(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, size_t k);
+
+template <size_t N, size_t D>
+Task<std::vector<Sharings<N, D>>> co_powers(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, size_t k);
+
+/// @brief constant + sum coeffs[i] * terms[i]
+/// integer coefficients are local, fractional ones carry extra fractional bits and the sum is
+/// truncated once, which takes one round with more than two parties
+template <size_t N, size_t D>
+Sharings<N, D> linear_combination(FSemi2kContext<N, D>& ctx, const std::vector<const Sharings<N, D>*>& terms, const std::vector<double>& coeffs, double constant = 0);
+
+template <size_t N, size_t D>
+Task<Sharings<N, D>> co_linear_combination(FSemi2kContext<N, D>& ctx, const std::vector<const Sharings<N, D>*>& terms, const std::vector<double>& coeffs, double constant = 0);
+
+/// @brief sum coeffs[i] * x^i
+/// Paterson-Stockmeyer with k ~ sqrt(d): powers of x up to k and powers of x^k are
+/// both computed by doubling, the block polynomials are local and the final products
+/// share one round, ceil(log2 k) + ceil(log2 (d / k)) + 1 rounds in total,
+/// plus one truncation round for the blocks with more than two parties, which the coroutine
+/// overlaps with the last power of x when that one is computed alone, e.g. for degree 3
+template <size_t N, size_t D>
+Sharings<N, D> polynomial(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& coeffs);
+
+template <size_t N, size_t D>
+Task<Sharings<N, D>> co_polynomial(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& coeffs);
+
+/// @brief monomial coefficients in t of the Chebyshev interpolant of f on [lo, hi]
+/// t = (2x - lo - hi) / (hi - lo) lies in [-1, 1], which keeps the powers small
+inline std::vector<double> chebyshev_fit(const std::function<double(double)>& f, double lo, double hi, size_t degree);
+
+/// @brief f on [lo, hi] by a Chebyshev interpolant of the given degree
+/// inputs outside [lo, hi] are not clamped and diverge quickly
+template <size_t N, size_t D>
+Sharings<N, D> approximate(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::function<double(double)>& f, double lo, double hi, size_t degree);
+
+template <size_t N, size_t D>
+Sharings<N, D> exp(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, double lo = -8, double hi = 8, size_t degree = 16);
+
+template <size_t N, size_t D>
+Sharings<N, D> sigmoid(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, double bound = 8, size_t degree = 9);
+
+/// @brief 1 / x for x in [lo, hi], lo > 0
+/// the interpolant is refined by Newton iterations, 2 rounds each, plus one truncation
+/// round with more than two parties, two if the ring has no room for a 3D-bit product
+template <size_t N, size_t D>
+Sharings<N, D> reciprocal(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, double lo, double hi, size_t degree = 8, size_t newton_iterations = 1);
+
+/// @brief indicators [x < thresholds[j]] as fixed-point 0/1 shares, element j per threshold
+/// all comparisons run as one batched msb, so any number of thresholds costs one comparison latency
+template <size_t N, size_t D>
+std::vector<Sharings<N, D>> compare_many(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& thresholds);
+
+template <size_t N, size_t D>
+Task<std::vector<Sharings<N, D>>> co_compare_many(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& thresholds);
+
+/// @brief slopes[k] * x + intercepts[k] on the k-th interval cut by the ascending thresholds,
+/// interval 0 is x < thresholds[0], the last is x >= thresholds.back()
+/// one batched comparison and one multiplication round; the indicators are bits, so with
+/// integer slopes and intercepts the result needs no truncation
+template <size_t N, size_t D>
+Sharings<N, D> piecewise_linear(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& thresholds,
+    const std::vector<double>& slopes, const std::vector<double>& intercepts);
+
+template <size_t N, size_t D>
+Task<Sharings<N, D>> co_piecewise_linear(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& thresholds,
+    const std::vector<double>& slopes, const std::vector<double>& intercepts);
+
+} // namespace nonlinear
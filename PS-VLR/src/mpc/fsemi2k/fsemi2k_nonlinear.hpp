@@ -0,0 +1,351 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include "fsemi2k_nonlinear.h"
+
+namespace nonlinear
+{
+
+template <size_t N, size_t D>
+std::vector<Sharings<N, D>> powers(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, size_t k){
+    return run_now<N>(co_powers(ctx, x, k));
+}
+
+template <size_t N, size_t D>
+Task<std::vector<Sharings<N, D>>> co_powers(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, size_t k){
+    std::vector<Sharings<N, D>> ret;
+    ret.reserve(k);
+    if(k == 0) co_return ret;
+    ret.push_back(x);
+
+    // round r computes x^(h+1), ..., x^(2h) as x^h * x^i with h = 2^r
+    while(ret.size() < k){
+        size_t have = ret.size();
+        size_t next = std::min(2 * have, k);
+        std::vector<Sharings<N, D>> as, bs;
+        for(size_t i = have + 1; i <= next; ++i){
+            as.push_back(ret[have - 1]);
+            bs.push_back(ret[i - have - 1]);
+        }
+        for(auto& p: co_await ctx.co_mult_sharing_many(as, bs)) ret.push_back(std::move(p));
+    }
+    co_return ret;
+}
+
+namespace detail
+{
+
+using scaled::extra_bits;
+
+inline bool all_integral(const std::vector<double>& coeffs){
+    return std::all_of(coeffs.begin(), coeffs.end(), [](double c){ return c == std::round(c); });
+}
+
+// sum coeffs[j] * terms[j] with coefficients scaled by 2^shift, D + shift fractional bits
+template <size_t N, size_t D>
+std::vector<Semi2kSharing<N>> accumulate(const std::vector<const Sharings<N, D>*>& terms, const std::vector<double>& coeffs, size_t shift){
+    if(terms.size() != coeffs.size()) throw std::invalid_argument("linear_combination: term and coefficient count mismatch");
+    if(terms.empty()) throw std::invalid_argument("linear_combination: no terms");
+
+    std::vector<SignedZ2<N>> cs(coeffs.size());
+    for(int j = 0; j != coeffs.size(); ++j) cs[j] = SignedZ2<N>(long(std::round(std::ldexp(coeffs[j], shift))));
+
+    size_t len = terms[0]->size();
+    std::vector<Semi2kSharing<N>> ret(len);
+    for(int i = 0; i != len; ++i){
+        SignedZ2<N> acc(0);
+        for(int j = 0; j != terms.size(); ++j){
+            if(coeffs[j] == 0) continue;
+            acc += (*terms[j])[i].get_data() * cs[j];
+        }
+        ret[i] = UnsignedZ2<N>(acc);
+    }
+    return ret;
+}
+
+// linear combinations with their constants, all fractional coefficients truncated together
+template <size_t N, size_t D>
+Task<std::vector<Sharings<N, D>>> co_linear_combinations(FSemi2kContext<N, D>& ctx, const std::vector<std::vector<const Sharings<N, D>*>>& terms,
+    const std::vector<std::vector<double>>& coeffs, const std::vector<double>& constants){
+    std::vector<Sharings<N, D>> ret(terms.size());
+    std::vector<Semi2kSharing<N>> scaled;
+    std::vector<int> truncated;
+    for(int k = 0; k != terms.size(); ++k){
+        if(all_integral(coeffs[k])){
+            // exact in the ring, nothing to truncate
+            auto acc = accumulate(terms[k], coeffs[k], 0);
+            ret[k].resize(acc.size());
+            for(int i = 0; i != acc.size(); ++i) ret[k][i] = FSemi2kSharing<N, D>(SignedZ2<N>(acc[i]));
+        }
+        else{
+            auto acc = accumulate(terms[k], coeffs[k], D + extra_bits<N, D>);
+            scaled.insert(scaled.end(), acc.begin(), acc.end());
+            truncated.push_back(k);
+        }
+    }
+    if(!truncated.empty()){
+        auto shifted = co_await ctx.co_truncate(scaled, D + extra_bits<N, D>);
+        auto it = shifted.begin();
+        for(int k: truncated){
+            size_t len = terms[k][0]->size();
+            ret[k].assign(it, it + len);
+            it += len;
+        }
+    }
+    for(int k = 0; k != terms.size(); ++k){
+        if(constants[k] != 0 && ctx.is_leader()){
+            for(auto& r: ret[k]) r += FSemi2kSharing<N, D>(constants[k]);
+        }
+    }
+    co_return ret;
+}
+
+// y^1, ..., y^count of y = x^k, with x^k first computed from x^(k-1) if xs stops there
+template <size_t N, size_t D>
+Task<std::vector<Sharings<N, D>>> block_powers(FSemi2kContext<N, D>& ctx, const std::vector<Sharings<N, D>>& xs, size_t k, size_t count){
+    if(xs.size() >= k) co_return co_await co_powers(ctx, xs[k - 1], count);
+    // the last doubling step of powers(x, k)
+    auto y = co_await ctx.co_mult_sharing(xs[k - 2], xs[0]);
+    co_return co_await co_powers(ctx, y, count);
+}
+
+} // namespace detail
+
+template <size_t N, size_t D>
+Sharings<N, D> linear_combination(FSemi2kContext<N, D>& ctx, const std::vector<const Sharings<N, D>*>& terms, const std::vector<double>& coeffs, double constant){
+    return run_now<N>(co_linear_combination(ctx, terms, coeffs, constant));
+}
+
+template <size_t N, size_t D>
+Task<Sharings<N, D>> co_linear_combination(FSemi2kContext<N, D>& ctx, const std::vector<const Sharings<N, D>*>& terms, const std::vector<double>& coeffs, double constant){
+    std::vector<std::vector<const Sharings<N, D>*>> all_terms(1, terms);
+    std::vector<std::vector<double>> all_coeffs(1, coeffs);
+    std::vector<double> constants(1, constant);
+    co_return std::move((co_await detail::co_linear_combinations(ctx, all_terms, all_coeffs, constants))[0]);
+}
+
+template <size_t N, size_t D>
+Sharings<N, D> polynomial(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& coeffs){
+    return run_now<N>(co_polynomial(ctx, x, coeffs));
+}
+
+template <size_t N, size_t D>
+Task<Sharings<N, D>> co_polynomial(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& coeffs){
+    if(coeffs.empty()) throw std::invalid_argument("polynomial: no coefficients");
+    size_t degree = coeffs.size() - 1;
+    if(degree == 0){
+        Sharings<N, D> ret(x.size(), FSemi2kSharing<N, D>(0.0));
+        if(ctx.is_leader()) ret.assign(x.size(), FSemi2kSharing<N, D>(coeffs[0]));
+        co_return ret;
+    }
+    if(degree == 1){
+        std::vector<const Sharings<N, D>*> terms(1, &x);
+        std::vector<double> cs(1, coeffs[1]);
+        co_return co_await co_linear_combination(ctx, terms, cs, coeffs[0]);
+    }
+
+    // p(x) = sum_j q_j(x) * y^j with y = x^k and deg q_j < k
+    size_t k = std::ceil(std::sqrt(double(degree + 1)));
+    size_t m = (degree + k) / k;                       // number of blocks, ceil((degree + 1) / k)
+    // the blocks need x, ..., x^(k-1) only: if the last doubling step computes x^k alone,
+    // it and the powers of y run next to the truncation of the blocks
+    size_t h = 1;
+    while(2 * h < k) h *= 2;
+    auto xs = co_await co_powers(ctx, x, h == k - 1 ? k - 1 : k);
+
+    // the block polynomials q_j, zero blocks above the first are skipped
+    std::vector<std::vector<const Sharings<N, D>*>> terms;
+    std::vector<std::vector<double>> cs;
+    std::vector<double> constants;
+    std::vector<size_t> blocks;
+    for(size_t j = 0; j != m; ++j){
+        std::vector<const Sharings<N, D>*> block_terms;
+        std::vector<double> block_cs;
+        size_t base = j * k;
+        bool is_zero = (coeffs[base] == 0);
+        for(size_t i = 1; i < k && base + i <= degree; ++i){
+            block_terms.push_back(&xs[i - 1]);
+            block_cs.push_back(coeffs[base + i]);
+            is_zero &= (coeffs[base + i] == 0);
+        }
+        if(j != 0 && is_zero) continue;
+        if(block_terms.empty()){
+            block_terms.push_back(&x);
+            block_cs.push_back(0);
+        }
+        terms.push_back(std::move(block_terms));
+        cs.push_back(std::move(block_cs));
+        constants.push_back(coeffs[base]);
+        blocks.push_back(j);
+    }
+    // ys[j - 1] = y^j
+    auto [ys, qs] = co_await when_all(detail::block_powers(ctx, xs, k, m - 1), detail::co_linear_combinations(ctx, terms, cs, constants));
+
+    Sharings<N, D> ret = std::move(qs[0]);
+    std::vector<Sharings<N, D>> as, bs;
+    for(size_t b = 1; b != blocks.size(); ++b){
+        as.push_back(std::move(qs[b]));
+        bs.push_back(ys[blocks[b] - 1]);
+    }
+    if(!as.empty()){
+        for(const auto& p: co_await ctx.co_mult_sharing_many(as, bs)) ret = ctx.add(ret, p);
+    }
+    co_return ret;
+}
+
+inline std::vector<double> chebyshev_fit(const std::function<double(double)>& f, double lo, double hi, size_t degree){
+    if(!(hi > lo)) throw std::invalid_argument("chebyshev_fit: empty interval");
+    size_t n = degree + 1;
+
+    // chebyshev coefficients from the values at the chebyshev nodes
+    std::vector<double> values(n), c(n, 0);
+    for(size_t i = 0; i != n; ++i){
+        double t = std::cos(std::numbers::pi * (i + 0.5) / n);
+        values[i] = f(0.5 * (hi - lo) * t + 0.5 * (hi + lo));
+    }
+    for(size_t j = 0; j != n; ++j){
+        for(size_t i = 0; i != n; ++i){
+            c[j] += values[i] * std::cos(std::numbers::pi * j * (i + 0.5) / n);
+        }
+        c[j] *= (j == 0 ? 1.0 : 2.0) / n;
+    }
+
+    // T_0 = 1, T_1 = t, T_j = 2t T_(j-1) - T_(j-2), accumulated in the monomial basis
+    std::vector<double> ret(n, 0), t_prev(n, 0), t_cur(n, 0);
+    t_prev[0] = 1;
+    ret[0] += c[0];
+    if(n > 1){
+        t_cur[1] = 1;
+        ret[1] += c[1];
+    }
+    for(size_t j = 2; j < n; ++j){
+        std::vector<double> t_next(n, 0);
+        for(size_t i = 0; i + 1 < n; ++i) t_next[i + 1] += 2 * t_cur[i];
+        for(size_t i = 0; i != n; ++i) t_next[i] -= t_prev[i];
+        for(size_t i = 0; i != n; ++i) ret[i] += c[j] * t_next[i];
+        t_prev = std::move(t_cur);
+        t_cur = std::move(t_next);
+    }
+    return ret;
+}
+
+template <size_t N, size_t D>
+Sharings<N, D> approximate(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::function<double(double)>& f, double lo, double hi, size_t degree){
+    auto t = linear_combination(ctx, {&x}, {2 / (hi - lo)}, -(hi + lo) / (hi - lo));
+    return polynomial(ctx, t, chebyshev_fit(f, lo, hi, degree));
+}
+
+template <size_t N, size_t D>
+Sharings<N, D> exp(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, double lo, double hi, size_t degree){
+    return approximate(ctx, x, [](double v){ return std::exp(v); }, lo, hi, degree);
+}
+
+template <size_t N, size_t D>
+Sharings<N, D> sigmoid(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, double bound, size_t degree){
+    return approximate(ctx, x, [](double v){ return 1 / (1 + std::exp(-v)); }, -bound, bound, degree);
+}
+
+template <size_t N, size_t D>
+Sharings<N, D> reciprocal(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, double lo, double hi, size_t degree, size_t newton_iterations){
+    if(!(lo > 0)) throw std::invalid_argument("reciprocal: interval must be positive");
+    auto r = approximate(ctx, x, [](double v){ return 1 / v; }, lo, hi, degree);
+
+    // r <- r * (2 - x * r), x * r stays at scale 2D and is truncated only if r * (2 - x * r)
+    // would not fit, so one truncation per iteration in 128-bit rings instead of two
+    auto sx = scaled::from(x);
+    for(size_t i = 0; i != newton_iterations; ++i){
+        auto sr = scaled::from(r);
+        auto xr = scaled::mult(ctx, sx, sr);
+        auto e = scaled::linear_combination(ctx, {&xr}, {-1.0}, 2.0);
+        r = scaled::rescale(ctx, scaled::mult(ctx, sr, e));
+    }
+    return r;
+}
+
+namespace detail
+{
+
+// [x < thresholds[j]] as shared bits at scale 0, element j per threshold
+template <size_t N, size_t D>
+Task<std::vector<ScaledSharings<N>>> co_compare_bits(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& thresholds){
+    trace::Scope scope("compare_many");
+    size_t len = x.size();
+
+    // [x - t_0, x - t_1, ...] in one vector, the msb of each is [x < t_j]
+    std::vector<Semi2kSharing<N>> diffs(len * thresholds.size());
+    for(int j = 0; j != thresholds.size(); ++j){
+        FSemi2kSharing<N, D> t(ctx.is_leader() ? thresholds[j] : 0.0);
+        for(int i = 0; i != len; ++i){
+            diffs[j * len + i] = UnsignedZ2<N>(x[i].get_data() - t.get_data());
+        }
+    }
+    auto bits = co_await ctx.co_msb(diffs);
+
+    std::vector<ScaledSharings<N>> ret(thresholds.size());
+    for(int j = 0; j != thresholds.size(); ++j){
+        ret[j] = scaled::integers(std::vector<Semi2kSharing<N>>(bits.begin() + j * len, bits.begin() + (j + 1) * len));
+    }
+    co_return ret;
+}
+
+} // namespace detail
+
+template <size_t N, size_t D>
+std::vector<Sharings<N, D>> compare_many(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& thresholds){
+    return run_now<N>(co_compare_many(ctx, x, thresholds));
+}
+
+template <size_t N, size_t D>
+Task<std::vector<Sharings<N, D>>> co_compare_many(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& thresholds){
+    // bits at scale 0 are lifted to D locally, nothing is truncated
+    auto bits = co_await detail::co_compare_bits(ctx, x, thresholds);
+    co_return co_await scaled::co_rescale_many(ctx, bits);
+}
+
+template <size_t N, size_t D>
+Sharings<N, D> piecewise_linear(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& thresholds,
+    const std::vector<double>& slopes, const std::vector<double>& intercepts){
+    return run_now<N>(co_piecewise_linear(ctx, x, thresholds, slopes, intercepts));
+}
+
+template <size_t N, size_t D>
+Task<Sharings<N, D>> co_piecewise_linear(FSemi2kContext<N, D>& ctx, const Sharings<N, D>& x, const std::vector<double>& thresholds,
+    const std::vector<double>& slopes, const std::vector<double>& intercepts){
+    if(slopes.size() != thresholds.size() + 1 || intercepts.size() != thresholds.size() + 1){
+        throw std::invalid_argument("piecewise_linear: need one slope and intercept per interval");
+    }
+    if(!std::is_sorted(thresholds.begin(), thresholds.end())){
+        throw std::invalid_argument("piecewise_linear: thresholds must be ascending");
+    }
+    if(thresholds.empty()){
+        std::vector<const Sharings<N, D>*> terms(1, &x);
+        std::vector<double> cs(1, slopes[0]);
+        co_return co_await co_linear_combination(ctx, terms, cs, intercepts[0]);
+    }
+
+    auto lt = co_await detail::co_compare_bits(ctx, x, thresholds);
+
+    // interval indicators are differences of neighbouring [x < t_j]:
+    // I_0 = lt_0, I_k = lt_k - lt_(k-1), I_T = 1 - lt_(T-1)
+    // so sum_k c_k I_k = c_T + sum_j (c_j - c_(j+1)) lt_j is local.
+    // The indicators are bits at scale 0: with integer slopes the product with x is at scale D
+    // and nothing is truncated, fractional ones are truncated once after the product
+    std::vector<const ScaledSharings<N>*> terms;
+    std::vector<double> slope_cs, intercept_cs;
+    for(int j = 0; j != thresholds.size(); ++j){
+        terms.push_back(&lt[j]);
+        slope_cs.push_back(slopes[j] - slopes[j + 1]);
+        intercept_cs.push_back(intercepts[j] - intercepts[j + 1]);
+    }
+    auto slope = scaled::linear_combination(ctx, terms, slope_cs, slopes.back());
+    auto intercept = scaled::linear_combination(ctx, terms, intercept_cs, intercepts.back());
+
+    auto sx = scaled::from(x);
+    auto product = co_await scaled::co_mult(ctx, slope, sx);
+    co_return co_await scaled::co_rescale(ctx, scaled::add(product, intercept));
+}
+
+} // namespace nonlinear
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "fsemi2k_context.hpp"
+
+/// @brief Fixed-point shares whose number of fractional bits is tracked at runtime.
+/// The ring element of a value v is v * 2^scale. Integers and bits, e.g. msb outputs or one-hot
+/// features, enter at scale 0 and are never shifted up; products add the scales of their operands
+/// and are left untruncated, sums lift the lower scale by a local shift. A chain of products and
+/// sums is thus truncated once, where it is turned back into FSemi2kSharing<N, D> by rescale,
+/// or earlier only if the next product would grow beyond max_scale.
+template <size_t N>
+struct ScaledSharings{
+    std::vector<Semi2kSharing<N>> data;
+    size_t scale = 0;
+
+    size_t size() const { return data.size(); }
+};
+
+namespace scaled
+{
+
+template <size_t N, size_t D>
+using Sharings = std::vector<FSemi2kSharing<N, D>>;
+
+// E extra fractional bits keep tiny coefficients, bounded so products stay far below 2^N
+template <size_t N, size_t D>
+constexpr size_t extra_bits = std::min(D, (N - 2 * D) / 4);
+
+// the largest scale a product may reach, the one of a D-bit value times a (D + E)-bit coefficient
+template <size_t N, size_t D>
+constexpr size_t max_scale = 2 * D + extra_bits<N, D>;
+
+/// @brief x at scale D, no communication
+template <size_t N, size_t D>
+ScaledSharings<N> from(const Sharings<N, D>& x);
+
+/// @brief shares of integers, e.g. bits, at scale 0
+template <size_t N>
+ScaledSharings<N> integers(std::vector<Semi2kSharing<N>> x);
+
+/// @brief x at a scale not below its own, a local shift
+template <size_t N>
+ScaledSharings<N> lift(const ScaledSharings<N>& x, size_t scale);
+
+/// @brief a + b at the larger of both scales
+template <size_t N>
+ScaledSharings<N> add(const ScaledSharings<N>& a, const ScaledSharings<N>& b);
+
+/// @brief x + c, added by the leader at the scale of x, or at D if c needs more bits than x has
+template <size_t N, size_t D>
+ScaledSharings<N> add(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& x, double c);
+
+/// @brief constant + sum coeffs[i] * terms[i], local
+/// the terms are lifted to a common scale; integer coefficients and constant keep it, fractional
+/// ones are encoded with D + E bits and add them to the scale
+template <size_t N, size_t D>
+ScaledSharings<N> linear_combination(FSemi2kContext<N, D>& ctx, const std::vector<const ScaledSharings<N>*>& terms,
+    const std::vector<double>& coeffs, double constant = 0);
+
+/// @brief independent products as[k] * bs[k] in one opening round, at the sum of their scales
+/// operands whose product would exceed max_scale are brought down to D first,
+/// all in one truncation round
+template <size_t N, size_t D>
+std::vector<ScaledSharings<N>> mult_many(FSemi2kContext<N, D>& ctx, const std::vector<ScaledSharings<N>>& as, const std::vector<ScaledSharings<N>>& bs);
+
+template <size_t N, size_t D>
+ScaledSharings<N> mult(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& a, const ScaledSharings<N>& b);
+
+/// @brief coroutines behind mult_many and mult, see Semi2kContext::co_open
+template <size_t N, size_t D>
+Task<std::vector<ScaledSharings<N>>> co_mult_many(FSemi2kContext<N, D>& ctx, const std::vector<ScaledSharings<N>>& as, const std::vector<ScaledSharings<N>>& bs);
+
+template <size_t N, size_t D>
+Task<ScaledSharings<N>> co_mult(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& a, const ScaledSharings<N>& b);
+
+/// @brief xs[k] as fixed-point shares with D fractional bits, one truncation round for all
+/// operands above scale D, none if all are at or below it
+template <size_t N, size_t D>
+std::vector<Sharings<N, D>> rescale_many(FSemi2kContext<N, D>& ctx, const std::vector<ScaledSharings<N>>& xs);
+
+template <size_t N, size_t D>
+Sharings<N, D> rescale(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& x);
+
+template <size_t N, size_t D>
+Task<std::vector<Sharings<N, D>>> co_rescale_many(FSemi2kContext<N, D>& ctx, const std::vector<ScaledSharings<N>>& xs);
+
+template <size_t N, size_t D>
+Task<Sharings<N, D>> co_rescale(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& x);
+
+} // namespace scaled
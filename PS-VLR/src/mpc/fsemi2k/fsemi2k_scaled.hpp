@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "fsemi2k_scaled.h"
+
+namespace scaled
+{
+
+namespace detail
+{
+
+// truncates xs[k] down to scales[k] in one round, entries already at their scale are untouched,
+// false if nothing needed a truncation
+template <size_t N, size_t D>
+Task<bool> reduce_many(FSemi2kContext<N, D>& ctx, std::vector<ScaledSharings<N>>& xs, const std::vector<size_t>& scales){
+    // the truncation protocol shifts every element by the same amount: entries with a smaller
+    // one are lifted first, so all of them open together
+    size_t amount = 0;
+    for(int k = 0; k != xs.size(); ++k){
+        if(xs[k].scale > scales[k]) amount = std::max(amount, xs[k].scale - scales[k]);
+    }
+    if(amount == 0) co_return false;
+    std::vector<Semi2kSharing<N>> flat;
+    for(int k = 0; k != xs.size(); ++k){
+        if(xs[k].scale <= scales[k]) continue;
+        xs[k] = lift(xs[k], scales[k] + amount);
+        flat.insert(flat.end(), xs[k].data.begin(), xs[k].data.end());
+    }
+    auto shifted = co_await ctx.co_truncate(flat, amount);
+    auto it = shifted.begin();
+    for(int k = 0; k != xs.size(); ++k){
+        if(xs[k].scale <= scales[k]) continue;
+        for(auto& d: xs[k].data) d = UnsignedZ2<N>((it++)->get_data());
+        xs[k].scale = scales[k];
+    }
+    co_return true;
+}
+
+// c * 2^scale in the ring, rounded at D + E bits at most and shifted from there so the
+// conversion through long cannot overflow for large scales
+template <size_t N, size_t D>
+Semi2kSharing<N> encode(double c, size_t scale){
+    size_t bits = std::min(scale, D + extra_bits<N, D>);
+    return UnsignedZ2<N>(SignedZ2<N>(long(std::round(std::ldexp(c, bits)))) << (scale - bits));
+}
+
+} // namespace detail
+
+template <size_t N, size_t D>
+ScaledSharings<N> from(const Sharings<N, D>& x){
+    ScaledSharings<N> ret{std::vector<Semi2kSharing<N>>(x.size()), D};
+    for(int i = 0; i != x.size(); ++i) ret.data[i] = UnsignedZ2<N>(x[i].get_data());
+    return ret;
+}
+
+template <size_t N>
+ScaledSharings<N> integers(std::vector<Semi2kSharing<N>> x){
+    return ScaledSharings<N>{std::move(x), 0};
+}
+
+template <size_t N>
+ScaledSharings<N> lift(const ScaledSharings<N>& x, size_t scale){
+    if(scale < x.scale) throw std::invalid_argument("scaled::lift: lowering the scale needs a truncation");
+    if(scale == x.scale) return x;
+    ScaledSharings<N> ret{x.data, scale};
+    for(auto& d: ret.data) d = d << (scale - x.scale);
+    return ret;
+}
+
+template <size_t N>
+ScaledSharings<N> add(const ScaledSharings<N>& a, const ScaledSharings<N>& b){
+    if(a.size() != b.size()) throw std::invalid_argument("scaled::add: size mismatch");
+    size_t scale = std::max(a.scale, b.scale);
+    auto ret = lift(a, scale);
+    auto rhs = lift(b, scale);
+    for(int i = 0; i != ret.size(); ++i) ret.data[i] += rhs.data[i];
+    return ret;
+}
+
+template <size_t N, size_t D>
+ScaledSharings<N> add(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& x, double c){
+    if(c == 0) return x;
+    // a constant not exact at the scale of x, e.g. 0.25 on bits, gets the D bits of FSemi2kSharing
+    ScaledSharings<N> ret = x;
+    double exact = std::ldexp(c, x.scale);
+    if(exact != std::round(exact) && x.scale < D) ret = lift(x, D);
+    if(ctx.is_leader()){
+        auto v = detail::encode<N, D>(c, ret.scale);
+        for(auto& d: ret.data) d += v;
+    }
+    return ret;
+}
+
+template <size_t N, size_t D>
+ScaledSharings<N> linear_combination(FSemi2kContext<N, D>& ctx, const std::vector<const ScaledSharings<N>*>& terms,
+    const std::vector<double>& coeffs, double constant){
+    if(terms.size() != coeffs.size()) throw std::invalid_argument("scaled::linear_combination: term and coefficient count mismatch");
+    if(terms.empty()) throw std::invalid_argument("scaled::linear_combination: no terms");
+
+    size_t scale = 0;
+    for(const auto* t: terms) scale = std::max(scale, t->scale);
+    bool integral = constant == std::round(constant) &&
+        std::all_of(coeffs.begin(), coeffs.end(), [](double c){ return c == std::round(c); });
+    size_t shift = integral ? 0 : D + extra_bits<N, D>;
+
+    std::vector<Semi2kSharing<N>> cs(coeffs.size());
+    for(int j = 0; j != coeffs.size(); ++j) cs[j] = detail::encode<N, D>(coeffs[j], shift);
+
+    ScaledSharings<N> ret{std::vector<Semi2kSharing<N>>(terms[0]->size(), 0), scale + shift};
+    for(int j = 0; j != terms.size(); ++j){
+        if(coeffs[j] == 0) continue;
+        auto t = lift(*terms[j], scale);
+        for(int i = 0; i != ret.size(); ++i) ret.data[i] += t.data[i] * cs[j];
+    }
+    return add(ctx, ret, constant);
+}
+
+template <size_t N, size_t D>
+std::vector<ScaledSharings<N>> mult_many(FSemi2kContext<N, D>& ctx, const std::vector<ScaledSharings<N>>& as, const std::vector<ScaledSharings<N>>& bs){
+    return run_now<N>(co_mult_many(ctx, as, bs));
+}
+
+template <size_t N, size_t D>
+Task<std::vector<ScaledSharings<N>>> co_mult_many(FSemi2kContext<N, D>& ctx, const std::vector<ScaledSharings<N>>& as, const std::vector<ScaledSharings<N>>& bs){
+    if(as.size() != bs.size()) throw std::invalid_argument("scaled::mult_many: operand count mismatch");
+
+    // operands in one vector [a_0, b_0, a_1, b_1, ...], the larger scale of a pair goes to D first
+    std::vector<ScaledSharings<N>> ops;
+    std::vector<size_t> targets;
+    for(int k = 0; k != as.size(); ++k){
+        size_t sa = as[k].scale, sb = bs[k].scale;
+        if(sa + sb > max_scale<N, D>){
+            if(sa >= sb) sa = std::min(sa, D);
+            else sb = std::min(sb, D);
+        }
+        if(sa + sb > max_scale<N, D>){
+            sa = std::min(sa, D);
+            sb = std::min(sb, D);
+        }
+        ops.push_back(as[k]);
+        ops.push_back(bs[k]);
+        targets.push_back(sa);
+        targets.push_back(sb);
+    }
+    co_await detail::reduce_many(ctx, ops, targets);
+
+    std::vector<std::vector<Semi2kSharing<N>>> za(as.size()), zb(bs.size());
+    for(int k = 0; k != as.size(); ++k){
+        za[k] = std::move(ops[2 * k].data);
+        zb[k] = std::move(ops[2 * k + 1].data);
+    }
+    auto products = co_await ctx.co_mult_sharing_many(za, zb);
+    std::vector<ScaledSharings<N>> ret(as.size());
+    for(int k = 0; k != as.size(); ++k){
+        ret[k] = ScaledSharings<N>{std::move(products[k]), ops[2 * k].scale + ops[2 * k + 1].scale};
+    }
+    co_return ret;
+}
+
+template <size_t N, size_t D>
+ScaledSharings<N> mult(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& a, const ScaledSharings<N>& b){
+    return run_now<N>(co_mult(ctx, a, b));
+}
+
+template <size_t N, size_t D>
+Task<ScaledSharings<N>> co_mult(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& a, const ScaledSharings<N>& b){
+    std::vector<ScaledSharings<N>> as(1, a), bs(1, b);
+    co_return std::move((co_await co_mult_many(ctx, as, bs))[0]);
+}
+
+template <size_t N, size_t D>
+std::vector<Sharings<N, D>> rescale_many(FSemi2kContext<N, D>& ctx, const std::vector<ScaledSharings<N>>& xs){
+    return run_now<N>(co_rescale_many(ctx, xs));
+}
+
+template <size_t N, size_t D>
+Task<std::vector<Sharings<N, D>>> co_rescale_many(FSemi2kContext<N, D>& ctx, const std::vector<ScaledSharings<N>>& xs){
+    std::vector<ScaledSharings<N>> ys(xs.size());
+    for(int k = 0; k != xs.size(); ++k) ys[k] = xs[k].scale < D ? lift(xs[k], D) : xs[k];
+    std::vector<size_t> scales(ys.size(), D);
+    co_await detail::reduce_many(ctx, ys, scales);
+
+    std::vector<Sharings<N, D>> ret(ys.size());
+    for(int k = 0; k != ys.size(); ++k){
+        ret[k].resize(ys[k].size());
+        for(int i = 0; i != ys[k].size(); ++i) ret[k][i] = FSemi2kSharing<N, D>(SignedZ2<N>(ys[k].data[i]));
+    }
+    co_return ret;
+}
+
+template <size_t N, size_t D>
+Sharings<N, D> rescale(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& x){
+    return run_now<N>(co_rescale(ctx, x));
+}
+
+template <size_t N, size_t D>
+Task<Sharings<N, D>> co_rescale(FSemi2kContext<N, D>& ctx, const ScaledSharings<N>& x){
+    std::vector<ScaledSharings<N>> xs(1, x);
+    co_return std::move((co_await co_rescale_many(ctx, xs))[0]);
+}
+
+} // namespace scaled
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../datatypes/fixed_point.hpp"
+#include "../semi2k/semi2k_sharing.hpp"
 
 template<size_t N, size_t D>
 class FSemi2kSharing: public FixedPoint<N, D>{
@@ -10,4 +11,23 @@ public:
     FSemi2kSharing(SignedZ2<N> _data): FixedPoint<N, D>(_data) {}
     SignedZ2<N> get_data()const{return this->_data;}
 
-};
\ No newline at end of file
+};
+
+// share vector expressions, see semi2k_sharing.hpp: sums, differences and negations only
+
+template <size_t N, size_t D>
+struct ExprTraits<FSemi2kSharing<N, D>>
+{
+    static constexpr auto expr_type = EnumExprType::scalar;
+    using ref_type = FSemi2kSharing<N, D>;
+};
+
+template <size_t N, size_t D>
+struct ExprTraits<std::vector<FSemi2kSharing<N, D>>>
+{
+    static constexpr auto expr_type = EnumExprType::array;
+    using ref_type = std::vector<FSemi2kSharing<N, D>> const &;
+};
+
+template <size_t N, size_t D>
+struct ShareExprElement<FSemi2kSharing<N, D>> { using type = FSemi2kSharing<N, D>; };
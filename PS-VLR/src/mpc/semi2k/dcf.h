@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "semi2k_sharing.hpp"
+#include "../aes_prg.h"
+
+/// @brief Distributed comparison function f(x) = beta if x < alpha else 0,
+/// x and alpha of n bits, beta in Z_2^K, after Boyle et al., "Function Secret Sharing
+/// for Mixed-Mode and Fixed-Point Secure Computation" (Eurocrypt 2021), Fig. 3.
+/// Two keys evaluate to additive shares of f(x) without interaction,
+/// each level of the GGM tree costs one AES expansion of 4 blocks.
+template <size_t K>
+struct DcfKey{
+    struct Correction{
+        Block s;
+        Semi2kSharing<K> v;
+        bool t_left;
+        bool t_right;
+    };
+
+    Block seed;
+    std::vector<Correction> cws;        // one per input bit, most significant first
+    Semi2kSharing<K> final_cw;
+};
+
+/// @brief keys of f for parties 0 and 1, seeds are the two root seeds
+template <size_t K>
+std::pair<DcfKey<K>, DcfKey<K>> dcf_gen(const Semi2kSharing<K>& alpha, size_t n_bits, const Semi2kSharing<K>& beta, const Block& seed_0, const Block& seed_1);
+
+/// @brief share of f(x) held by party b
+template <size_t K>
+Semi2kSharing<K> dcf_eval(bool b, const DcfKey<K>& key, const Semi2kSharing<K>& x, size_t n_bits);
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "dcf.h"
+
+namespace detail {
+
+template <size_t K>
+Semi2kSharing<K> convert(const Block& block){
+    if constexpr (K <= 64){
+        return Semi2kSharing<K>(typename UnsignedZ2<K>::value_type(block.lo));
+    }
+    else{
+        Semi2kSharing<K> ret = Semi2kSharing<K>(long(block.hi >> 32));
+        ret = (ret << 32) ^ Semi2kSharing<K>(long(block.hi & 0xffffffffUL));
+        ret = (ret << 32) ^ Semi2kSharing<K>(long(block.lo >> 32));
+        ret = (ret << 32) ^ Semi2kSharing<K>(long(block.lo & 0xffffffffUL));
+        return ret;
+    }
+}
+
+// G(s) = s_L || v_L || t_L || s_R || v_R || t_R, the control bits are the lsb of the seeds
+struct DcfExpansion{
+    Block s[2];
+    Block v[2];
+    bool t[2];
+};
+
+inline DcfExpansion dcf_expand(const Block& seed){
+    Block out[4];
+    AesPrg::local().expand(seed, out, 4);
+    DcfExpansion e;
+    for(int side = 0; side != 2; ++side){
+        e.s[side] = out[2 * side];
+        e.t[side] = e.s[side].lsb();
+        e.s[side].lo &= ~std::uint64_t(1);
+        e.v[side] = out[2 * side + 1];
+    }
+    return e;
+}
+
+template <size_t K>
+Semi2kSharing<K> signed_by(bool negative, const Semi2kSharing<K>& x){
+    return negative ? Semi2kSharing<K>(-x) : x;
+}
+
+} // namespace detail
+
+template <size_t K>
+std::pair<DcfKey<K>, DcfKey<K>> dcf_gen(const Semi2kSharing<K>& alpha, size_t n_bits, const Semi2kSharing<K>& beta, const Block& seed_0, const Block& seed_1){
+    using detail::convert;
+    using detail::signed_by;
+
+    DcfKey<K> k0, k1;
+    k0.seed = seed_0;
+    k1.seed = seed_1;
+    k0.cws.reserve(n_bits);
+
+    Block s0 = seed_0, s1 = seed_1;
+    s0.lo &= ~std::uint64_t(1);
+    s1.lo &= ~std::uint64_t(1);
+    bool t0 = 0, t1 = 1;
+    Semi2kSharing<K> v_alpha(0);
+
+    for(size_t level = 0; level != n_bits; ++level){
+        bool a = alpha.bit(n_bits - 1 - level);
+        auto e0 = detail::dcf_expand(s0);
+        auto e1 = detail::dcf_expand(s1);
+        int keep = a, lose = 1 - a;
+
+        typename DcfKey<K>::Correction cw;
+        cw.s = e0.s[lose] ^ e1.s[lose];
+        Semi2kSharing<K> v_cw = signed_by(t1, Semi2kSharing<K>(convert<K>(e1.v[lose]) - convert<K>(e0.v[lose]) - v_alpha));
+        if(lose == 0) v_cw += signed_by(t1, beta);
+        cw.v = v_cw;
+        v_alpha = v_alpha - convert<K>(e1.v[keep]) + convert<K>(e0.v[keep]) + signed_by(t1, v_cw);
+        cw.t_left = e0.t[0] ^ e1.t[0] ^ a ^ 1;
+        cw.t_right = e0.t[1] ^ e1.t[1] ^ a;
+        bool t_cw_keep = keep ? cw.t_right : cw.t_left;
+
+        s0 = t0 ? (e0.s[keep] ^ cw.s) : e0.s[keep];
+        s1 = t1 ? (e1.s[keep] ^ cw.s) : e1.s[keep];
+        bool nt0 = e0.t[keep] ^ (t0 & t_cw_keep);
+        bool nt1 = e1.t[keep] ^ (t1 & t_cw_keep);
+        t0 = nt0;
+        t1 = nt1;
+        k0.cws.push_back(cw);
+    }
+    k0.final_cw = signed_by(t1, Semi2kSharing<K>(convert<K>(s1) - convert<K>(s0) - v_alpha));
+    k1.cws = k0.cws;
+    k1.final_cw = k0.final_cw;
+    return {std::move(k0), std::move(k1)};
+}
+
+template <size_t K>
+Semi2kSharing<K> dcf_eval(bool b, const DcfKey<K>& key, const Semi2kSharing<K>& x, size_t n_bits){
+    using detail::convert;
+
+    Block s = key.seed;
+    s.lo &= ~std::uint64_t(1);
+    bool t = b;
+    Semi2kSharing<K> v(0);
+
+    for(size_t level = 0; level != n_bits; ++level){
+        const auto& cw = key.cws[level];
+        auto e = detail::dcf_expand(s);
+        if(t){
+            e.s[0] ^= cw.s;
+            e.s[1] ^= cw.s;
+            e.t[0] ^= cw.t_left;
+            e.t[1] ^= cw.t_right;
+        }
+        int side = x.bit(n_bits - 1 - level);
+        Semi2kSharing<K> step = convert<K>(e.v[side]);
+        if(t) step += cw.v;
+        v += detail::signed_by(b, step);
+        s = e.s[side];
+        t = e.t[side];
+    }
+    Semi2kSharing<K> last = convert<K>(s);
+    if(t) last += key.final_cw;
+    v += detail::signed_by(b, last);
+    return v;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "semi2k_sharing.hpp"
+#include "../../tools/spsc_ring.h"
+
+/// @brief Matrix-vector triples (V, UV) for a fixed mask U, produced in the background.
+/// Every (n, m, block) shape owns a bounded single-producer single-consumer ring,
+/// the producer thread refills it while the training thread moves triples out.
+/// The producer must follow the order in which triples are consumed, so producers
+/// of all parties stay in lockstep on their offline channel and can never block
+/// on a full ring that the consumer would only drain after an empty one.
+/// Once the last producer returns or throws, the rings are closed: acquire rethrows the
+/// producer's exception, or fails if the triples ran out, instead of waiting forever.
+template <size_t K>
+class MatrixTriplePool{
+public:
+    using Key = std::tuple<int, int, int>;      // (n, m, block)
+
+    struct Triple{
+        std::vector<Semi2kSharing<K>> V;
+        std::vector<Semi2kSharing<K>> UV;
+    };
+
+private:
+    size_t capacity;
+    std::map<Key, std::unique_ptr<SPSCRing<Triple>>> rings;
+    std::vector<std::thread> producers;
+    std::function<void()> producer_init;
+    std::vector<std::function<void()>> join_hooks;
+    std::atomic<size_t> running_count{0};
+    std::mutex error_mutex;
+    std::exception_ptr producer_error;
+    std::atomic<size_t> stall_count{0};
+    std::atomic<size_t> produced_count{0};
+    std::atomic<size_t> consumed_count{0};
+
+public:
+    MatrixTriplePool()                                      = delete;
+    MatrixTriplePool(const MatrixTriplePool&)               = delete;
+    MatrixTriplePool& operator=(const MatrixTriplePool&)    = delete;
+
+    /// @param capacity number of triples buffered per (n, m, block)
+    explicit MatrixTriplePool(size_t capacity);
+    ~MatrixTriplePool();
+
+    /// @brief create the rings of a shape, must happen before any producer starts
+    void reserve(int n, int m, int num_blocks);
+    bool contains(int n, int m, int block) const;
+
+    /// @brief producer side, blocks while the ring is full, throws once the pool is closed
+    void push(int n, int m, int block, Triple&& triple);
+
+    /// @brief consumer side, blocks while the ring is empty
+    /// rethrows the exception of a failed producer
+    Triple acquire(int n, int m, int block);
+
+    /// @brief runs first in every producer thread, e.g. to size its OpenMP team
+    void set_producer_init(std::function<void()> init) { producer_init = std::move(init); }
+    /// @brief runs on the joining thread after the producers finished, e.g. to merge their counts
+    void on_join(std::function<void()> hook) { join_hooks.push_back(std::move(hook)); }
+    /// @brief run a producer in a background thread
+    void run(std::function<void()> producer);
+    /// @brief stop the producers at their next push, pending acquires drain the rings
+    void close();
+    /// @brief wait for all producers to finish, rethrows the exception of a failed producer
+    void join();
+
+    size_t stalls() const { return stall_count.load(); }       // acquires that had to wait
+    size_t produced() const { return produced_count.load(); }
+    size_t consumed() const { return consumed_count.load(); }
+
+private:
+    SPSCRing<Triple>& ring(int n, int m, int block);
+    void join_producers();
+};
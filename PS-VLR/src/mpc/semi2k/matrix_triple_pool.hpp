@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "matrix_triple_pool.h"
+
+template <size_t K>
+MatrixTriplePool<K>::MatrixTriplePool(size_t capacity): capacity(capacity){
+    if(capacity == 0) throw std::invalid_argument("matrix triple pool capacity must be positive");
+}
+
+template <size_t K>
+MatrixTriplePool<K>::~MatrixTriplePool(){
+    // the consumer is gone, a producer blocked on a full ring must not wait for it
+    close();
+    join_producers();
+}
+
+template <size_t K>
+void MatrixTriplePool<K>::reserve(int n, int m, int num_blocks){
+    if(!producers.empty()) throw std::runtime_error("matrix triple pool: reserve after a producer started");
+    for(int l = 0; l != num_blocks; ++l){
+        auto& r = rings[Key(n, m, l)];
+        if(!r) r = std::make_unique<SPSCRing<Triple>>(capacity);
+    }
+}
+
+template <size_t K>
+bool MatrixTriplePool<K>::contains(int n, int m, int block) const{
+    return rings.find(Key(n, m, block)) != rings.end();
+}
+
+template <size_t K>
+SPSCRing<typename MatrixTriplePool<K>::Triple>& MatrixTriplePool<K>::ring(int n, int m, int block){
+    auto it = rings.find(Key(n, m, block));
+    if(it == rings.end()){
+        throw std::runtime_error("no matrix triple of shape (" + std::to_string(n) + ", " + std::to_string(m)
+            + ") for block " + std::to_string(block));
+    }
+    return *it->second;
+}
+
+template <size_t K>
+void MatrixTriplePool<K>::push(int n, int m, int block, Triple&& triple){
+    if(!ring(n, m, block).push(std::move(triple))) throw std::runtime_error("matrix triple pool: closed");
+    produced_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <size_t K>
+typename MatrixTriplePool<K>::Triple MatrixTriplePool<K>::acquire(int n, int m, int block){
+    bool waited = false;
+    auto triple = ring(n, m, block).pop(&waited);
+    if(waited) stall_count.fetch_add(1, std::memory_order_relaxed);
+    if(!triple){
+        std::lock_guard lock(error_mutex);
+        if(producer_error) std::rethrow_exception(producer_error);
+        throw std::runtime_error("matrix triple pool: producers finished before the triple of shape (" + std::to_string(n)
+            + ", " + std::to_string(m) + ") for block " + std::to_string(block));
+    }
+    consumed_count.fetch_add(1, std::memory_order_relaxed);
+    return std::move(*triple);
+}
+
+template <size_t K>
+void MatrixTriplePool<K>::run(std::function<void()> producer){
+    running_count.fetch_add(1);
+    producers.emplace_back([this, init = producer_init, producer = std::move(producer)](){
+        try{
+            if(init) init();
+            producer();
+        }
+        catch(...){
+            std::lock_guard lock(error_mutex);
+            if(!producer_error) producer_error = std::current_exception();
+        }
+        // no more triples: the last producer ends the streams
+        if(running_count.fetch_sub(1) == 1) close();
+    });
+}
+
+template <size_t K>
+void MatrixTriplePool<K>::close(){
+    for(auto& [key, r]: rings) r->close();
+}
+
+template <size_t K>
+void MatrixTriplePool<K>::join_producers(){
+    for(auto& t: producers){
+        if(t.joinable()) t.join();
+    }
+    producers.clear();
+    for(auto& hook: join_hooks) hook();
+    join_hooks.clear();
+}
+
+template <size_t K>
+void MatrixTriplePool<K>::join(){
+    join_producers();
+    std::lock_guard lock(error_mutex);
+    if(producer_error) std::rethrow_exception(std::exchange(producer_error, nullptr));
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+#include "semi2k_sharing.hpp"
+#include "../../datatypes/sparse_rows.hpp"
+#include "../../network/playerid.h"
+#include "../../tools/thread_pool.h"
+
+/// @brief A public-shape matrix whose blocks are known in plaintext to one party each,
+/// e.g. the column blocks of a vertically partitioned batch or their transposes.
+/// Blocks do not overlap; block data is filled at its owner only and left empty elsewhere.
+/// An owner may keep a block sparse instead, also as the transpose of the stored rows, so
+/// that X and X^T of one-hot data cost a pass over the nonzeros each.
+template <size_t K>
+struct PlainMatrix{
+    struct Block{
+        playerid_t owner;
+        size_t row, col;                                    // offset in the whole matrix
+        size_t rows, cols;
+        std::vector<std::vector<Semi2kSharing<K>>> data;    // rows x cols at the owner
+        std::optional<SparseRows<Semi2kSharing<K>>> sparse; // instead of data, rows x cols or cols x rows
+        bool transposed = false;                            // the block is sparse^T
+    };
+
+    size_t rows = 0, cols = 0;
+    std::vector<Block> blocks;
+
+    /// @brief out[row + i] += sum_j b(i, j) * x[col + j] over the blocks b owned by id,
+    /// with a pool the rows of a block in parallel, a transposed sparse block stays serial
+    void mult_local(playerid_t id, const std::vector<Semi2kSharing<K>>& x, std::vector<Semi2kSharing<K>>& out, ThreadPool* pool = nullptr) const{
+        for(const auto& b: blocks){
+            if(b.owner != id) continue;
+            if(b.sparse && b.transposed){
+                mult_sparse_transposed(*b.sparse, x.data() + b.col, out.data() + b.row);
+                continue;
+            }
+            parallel_for(pool, b.rows, 64, [&](size_t begin, size_t end){
+                if(b.sparse) mult_sparse(*b.sparse, x.data() + b.col, out.data() + b.row, begin, end);
+                else{
+                    for(size_t i = begin; i != end; ++i){
+                        Semi2kSharing<K> acc(0);
+                        for(size_t j = 0; j != b.cols; ++j){
+                            acc += b.data[i][j] * x[b.col + j];
+                        }
+                        out[b.row + i] += acc;
+                    }
+                }
+            });
+        }
+    }
+
+    /// @brief out[i] += sum_k a(i, k) * x[k] for the rows [begin, end), a pattern multiplies once per row
+    static void mult_sparse(const SparseRows<Semi2kSharing<K>>& a, const Semi2kSharing<K>* x, Semi2kSharing<K>* out, size_t begin, size_t end){
+        for(size_t i = begin; i != end; ++i){
+            Semi2kSharing<K> acc(0);
+            if(a.is_pattern()){
+                for(size_t k = a.row_ptr[i]; k != a.row_ptr[i + 1]; ++k) acc += x[a.col_idx[k]];
+                acc = acc * a.unit;
+            }
+            else{
+                for(size_t k = a.row_ptr[i]; k != a.row_ptr[i + 1]; ++k) acc += a.values[k] * x[a.col_idx[k]];
+            }
+            out[i] += acc;
+        }
+    }
+
+    /// @brief out[k] += sum_i a(i, k) * x[i], a scatter over the nonzeros of a
+    static void mult_sparse_transposed(const SparseRows<Semi2kSharing<K>>& a, const Semi2kSharing<K>* x, Semi2kSharing<K>* out){
+        for(size_t i = 0; i != a.rows(); ++i){
+            Semi2kSharing<K> xi = x[i];
+            if(a.is_pattern()){
+                xi = xi * a.unit;
+                for(size_t k = a.row_ptr[i]; k != a.row_ptr[i + 1]; ++k) out[a.col_idx[k]] += xi;
+            }
+            else{
+                for(size_t k = a.row_ptr[i]; k != a.row_ptr[i + 1]; ++k) out[a.col_idx[k]] += a.values[k] * xi;
+            }
+        }
+    }
+};
+
+/// @brief correlated randomness of one plaintext-by-share product with a PlainMatrix A:
+/// a random vector v (A.cols) and A * v (A.rows), both shared by all parties
+template <size_t K>
+struct PlainMatrixTriple{
+    std::vector<Semi2kSharing<K>> v;
+    std::vector<Semi2kSharing<K>> av;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "semi2k_sharing.hpp"
+#include "../../tools/task.h"
+
+namespace network { class MultiPartyPlayer; }
+
+template <size_t K>
+class Semi2kContext;
+
+template <size_t K>
+class RoundScheduler;
+
+// how the shares of an opening combine
+enum class OpenKind{
+    sum,        // arithmetic shares, Semi2kContext::open
+    xor_words,  // XOR-shared words, Semi2kContext::open_xor
+    bits,       // shared bits in the low bit of each word, Semi2kContext::open_bits
+};
+
+/// @brief co_await of Semi2kContext::co_open and its siblings.
+/// Without a running RoundScheduler the opening happens at once, like open; inside
+/// RoundScheduler::run the coroutine suspends until the round its opening is merged into.
+template <size_t K>
+struct Opening{
+    Semi2kContext<K>* ctx;
+    const std::vector<Semi2kSharing<K>>* shares;
+    OpenKind kind;
+    std::vector<Semi2kSharing<K>> result;
+    std::coroutine_handle<> waiter;
+
+    void open_now();
+    bool await_ready();
+    void await_suspend(std::coroutine_handle<> h);
+    std::vector<Semi2kSharing<K>> await_resume() { return std::move(result); }
+};
+
+/// @brief Runs protocol coroutines of one party side by side. Every coroutine runs until it
+/// awaits an opening; then all openings waiting are sent as one message per peer, one
+/// round for all of them, and the coroutines resume in the order they were started.
+/// Independent sub-protocols, e.g. two msb calls or a product chain next to a comparison,
+/// thus share their rounds. The order is the same at every party, so messages match.
+/// The scheduler installs itself for the calling thread while it runs; synchronous
+/// protocol calls from within a coroutine open at once and do not interleave.
+/// Rounds are counted at the player, so the synchronous openings, e.g. of the bitwise msb,
+/// count as well, each as a round of its own.
+template <size_t K>
+class RoundScheduler{
+    network::MultiPartyPlayer* player;
+    std::vector<Opening<K>*> pending;
+    RoundScheduler* previous = nullptr;
+    size_t round_count = 0;
+    size_t opening_count = 0;
+    size_t flush_count = 0;
+
+    static RoundScheduler*& slot();
+    // sends all pending openings in one round and resumes their coroutines
+    void flush();
+    template <typename Starter>
+    void drive(Starter&& start_all);
+
+public:
+    // player: the one all openings of the tasks go over
+    explicit RoundScheduler(network::MultiPartyPlayer* player): player(player) {}
+    RoundScheduler(const RoundScheduler&) = delete;
+    RoundScheduler& operator=(const RoundScheduler&) = delete;
+
+    /// @brief the scheduler running on the calling thread, nullptr outside run
+    static RoundScheduler* current() { return slot(); }
+    /// @brief replaces the current scheduler for its lifetime, nullptr for none
+    class Install{
+        RoundScheduler* saved;
+    public:
+        explicit Install(RoundScheduler* s): saved(slot()) { slot() = s; }
+        ~Install() { slot() = saved; }
+    };
+
+    void enqueue(Opening<K>* opening) { pending.push_back(opening); }
+
+    /// @brief runs the tasks to their end and returns their results
+    template <typename... T>
+    std::tuple<T...> run(Task<T>... tasks);
+    template <typename T>
+    std::vector<T> run_all(std::vector<Task<T>> tasks);
+
+    size_t rounds() const { return round_count; }       // rounds of the player in run so far
+    // openings merged into them and the synchronous ones, as many rounds as the tasks take
+    // called one by one
+    size_t openings() const { return opening_count; }
+    // e.g. "7 rounds for 63 sequential"
+    std::string to_string() const {
+        return std::to_string(round_count) + " rounds for " + std::to_string(opening_count) + " sequential";
+    }
+};
+
+/// @brief runs a protocol coroutine to its end with its openings one after another,
+/// also from inside a scheduled coroutine
+template <size_t K, typename T>
+T run_now(Task<T> task);
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include "round_scheduler.h"
+#include "semi2k_context.h"
+
+template <size_t K>
+void Opening<K>::open_now(){
+    switch(kind){
+        case OpenKind::sum:       result = ctx->open(*shares); break;
+        case OpenKind::xor_words: result = ctx->open_xor(*shares); break;
+        case OpenKind::bits:      result = ctx->open_bits(*shares); break;
+    }
+}
+
+template <size_t K>
+bool Opening<K>::await_ready(){
+    if(RoundScheduler<K>::current()) return false;
+    open_now();
+    return true;
+}
+
+template <size_t K>
+void Opening<K>::await_suspend(std::coroutine_handle<> h){
+    waiter = h;
+    RoundScheduler<K>::current()->enqueue(this);
+}
+
+template <size_t K>
+RoundScheduler<K>*& RoundScheduler<K>::slot(){
+    thread_local RoundScheduler* scheduler = nullptr;
+    return scheduler;
+}
+
+template <size_t K>
+void RoundScheduler<K>::flush(){
+    auto batch = std::move(pending);
+    pending.clear();
+    Semi2kContext<K>* ctx = batch.front()->ctx;
+    if(ctx->mplayer != player) throw std::logic_error("round scheduler: openings over different players");
+
+    ++flush_count;
+    opening_count += batch.size();
+    if(batch.size() == 1){
+        // alone it is the plain opening, same messages as without the scheduler
+        batch.front()->open_now();
+    }
+    else{
+        // the sums first, then the XORs, bits are XORed in their words
+        auto merged = batch;
+        std::stable_partition(merged.begin(), merged.end(), [](const Opening<K>* o){ return o->kind == OpenKind::sum; });
+        std::vector<Semi2kSharing<K>> shares;
+        size_t n_sum = 0;
+        for(const auto* o: merged){
+            if(o->ctx->mplayer != player) throw std::logic_error("round scheduler: openings over different players");
+            shares.insert(shares.end(), o->shares->begin(), o->shares->end());
+            if(o->kind == OpenKind::sum) n_sum = shares.size();
+        }
+        auto opened = ctx->open_mixed(shares, n_sum);
+        auto it = opened.begin();
+        for(auto* o: merged){
+            o->result.assign(it, it + o->shares->size());
+            it += o->shares->size();
+            // the words were XORed whole, open_bits keeps the low bit only
+            if(o->kind == OpenKind::bits){
+                for(auto& r: o->result) r = Semi2kSharing<K>(r.bit(0));
+            }
+        }
+    }
+    for(auto* o: batch) o->waiter.resume();
+}
+
+template <size_t K>
+template <typename Starter>
+void RoundScheduler<K>::drive(Starter&& start_all){
+    Install self(this);
+    size_t rounds_before = player->phases().rounds(), flushes_before = flush_count;
+    start_all();
+    while(!pending.empty()) flush();
+    // a flush is one round, the rest are synchronous openings
+    size_t rounds = player->phases().rounds() - rounds_before;
+    round_count += rounds;
+    opening_count += rounds - (flush_count - flushes_before);
+}
+
+template <size_t K>
+template <typename... T>
+std::tuple<T...> RoundScheduler<K>::run(Task<T>... tasks){
+    drive([&]{ (tasks.start(), ...); });
+    if(!(tasks.done() && ...)) throw std::logic_error("round scheduler: a task suspended outside its openings");
+    return std::tuple<T...>(tasks.result()...);
+}
+
+template <size_t K>
+template <typename T>
+std::vector<T> RoundScheduler<K>::run_all(std::vector<Task<T>> tasks){
+    drive([&]{ for(auto& t: tasks) t.start(); });
+    std::vector<T> ret;
+    ret.reserve(tasks.size());
+    for(auto& t: tasks){
+        if(!t.done()) throw std::logic_error("round scheduler: a task suspended outside its openings");
+        ret.push_back(t.result());
+    }
+    return ret;
+}
+
+template <size_t K, typename T>
+T run_now(Task<T> task){
+    typename RoundScheduler<K>::Install none(nullptr);
+    return run_inline(std::move(task));
+}
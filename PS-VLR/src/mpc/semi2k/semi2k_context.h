@@ -3,11 +3,31 @@
 #include <vector>
 #include <map>
 #include "semi2k_sharing.hpp"
+#include "matrix_triple_pool.hpp"
+#include "round_scheduler.h"
+#include "semi2k_dealer.hpp"
 #include "../random_generator.h"
+#include "../cost_model.h"
 #include "../../network/multi_party_player.hpp"
 #include "../../network/playerid.h"
 #include "../../serialization/serializer.h"
 #include "../../serialization/deserializer.h"
+#include "../../tools/thread_pool.h"
+#include "../../tools/trace.h"
+
+// protocol behind Semi2kContext::msb
+enum class MsbBackend{
+    bitwise,    // K random bits per element and a sequential carry circuit, K rounds
+    edabit,     // one edaBit per element and a log-depth adder, log2(K) + 2 rounds
+    dcf,        // one DCF key pair per element, a single opening, parties 0 and 1 evaluate locally
+};
+
+// how Semi2kContext::open and rand reconstruct a value among n parties
+enum class OpenStrategy{
+    all_to_all, // every party sends its share to every other, n(n-1) messages, one hop
+    king,       // the shares go to a king who sends the value back, 2(n-1) messages, two hops
+    automatic,  // either one per opening, see Semi2kContext::use_king
+};
 
 template <size_t K>
 class Semi2kContext{
@@ -25,6 +45,9 @@ public:
     std::map<std::pair<int, int>, std::vector<MatrixTripleSeries>> matrix_triples;
 
 protected:
+    friend class RoundScheduler<K>;
+    template <size_t> friend class Semi2kContext;
+
     mplayerid_t parties;
     playerid_t id;
     network::MultiPartyPlayer* mplayer;
@@ -35,7 +58,35 @@ protected:
     std::vector<Semi2kSharing<K>> rand_bits;
 
     long seed;
-    
+
+    CostModel* cost_model = nullptr;
+
+    MatrixTriplePool<K>* matrix_triple_pool = nullptr;
+
+    ThreadPool* thread_pool = nullptr;     // local share kernels run serially without
+
+    Semi2kDealer<K>* dealer = nullptr;
+
+    MsbBackend msb_backend = MsbBackend::edabit;
+
+    OpenStrategy open_strategy = OpenStrategy::automatic;
+    int fixed_king = -1;            // -1 rotates the king over all parties, one step per king opening
+    size_t king_openings = 0;
+    double open_latency = 0;        // agreed by calibrate_open, seconds of a one-element opening
+    double open_byte_time = 0;      // agreed by calibrate_open, seconds per byte on the shared links
+    bool open_calibrated = false;
+    size_t stream_chunk_bytes = 1 << 20;   // 0 receives openings whole
+
+    // whether the opening of messages of bytes bytes per party goes through a king
+    bool use_king(size_t bytes) const;
+    playerid_t next_king();
+    // a context over the same parties that opens as this one does, for the one-bit openings
+    template <size_t KK>
+    Semi2kContext<KK> sub_context() const;
+    // sums (or XORs, with op) the shares of all parties
+    template <size_t KK, typename Op>
+    std::vector<Semi2kSharing<KK>> reconstruct(const std::vector<Semi2kSharing<KK>>& a, Op op);
+
 public:
     Semi2kContext()                                 = delete;
     ~Semi2kContext();
@@ -48,12 +99,66 @@ public:
 
     void set_matrix_triple(const std::vector<MatrixTripleSeries>& triples, int n, int m);
 
+    // shapes reserved in the pool are taken from it instead of matrix_triples
+    void set_matrix_triple_pool(MatrixTriplePool<K>* pool);
+
     void generate_rand_bit(size_t n);
 
+    // correlated randomness is drawn from the dealer if set, else zero placeholders are used
+    void set_dealer(Semi2kDealer<K>* dealer);
+    std::vector<EdaBit<K>> get_edabit(size_t n, size_t bits = K);
+    std::vector<DaBit<K>> get_dabit(size_t n);
+    std::vector<BeaverTriple<K>> get_and_triple(size_t n);
+    std::vector<DcfMsbKey<K>> get_dcf_msb_key(size_t n);
+    PlainMatrixTriple<K> get_plain_matrix_triple(const PlainMatrix<K>& a);
+
+    void set_msb_backend(MsbBackend backend) { msb_backend = backend; }
+    MsbBackend get_msb_backend() const { return msb_backend; }
+
+    // king: the party that reconstructs king openings, -1 rotates over all parties
+    void set_open_strategy(OpenStrategy strategy, int king = -1);
+    OpenStrategy get_open_strategy() const { return open_strategy; }
+
+    // times all-to-all openings of one element and of probe_bytes per party and lets the
+    // parties agree on the mean, automatic openings then weigh the extra hop of a king
+    // against the n(n-1) versus 2(n-1) messages over links assumed to share a bottleneck;
+    // uncalibrated they use a king from 5 parties on
+    void calibrate_open(size_t probe_bytes = 1 << 18);
+
+    // openings whose shares exceed chunk_bytes are summed piece by piece while the
+    // rest is received, 0 waits for whole messages
+    void set_stream_chunk(size_t chunk_bytes) { stream_chunk_bytes = chunk_bytes; }
+    size_t get_stream_chunk() const { return stream_chunk_bytes; }
+
+    // local kernels, products with public matrices and share expressions, run on pool
+    void set_thread_pool(ThreadPool* pool) { thread_pool = pool; }
+    ThreadPool* get_thread_pool() const { return thread_pool; }
+
+    void set_cost_model(CostModel* cost_model);
+    CostModel* get_cost_model() const { return cost_model; }
+    bool is_symbolic() const { return cost_model != nullptr && cost_model->symbolic; }
+
+    // the party that adds public constants to shares
+    bool is_leader() const { return id < *(parties.begin()); }
+
     template <size_t KK>
     std::vector<Semi2kSharing<KK>> rand(size_t n);
 
     std::vector<Semi2kSharing<K>> open(const std::vector<Semi2kSharing<K>>& a);
+    // open XOR-shared words
+    std::vector<Semi2kSharing<K>> open_xor(const std::vector<Semi2kSharing<K>>& a);
+    // open shared bits held in the low bit of each word, sent as Semi2kSharing<1>
+    std::vector<Semi2kSharing<K>> open_bits(const std::vector<Semi2kSharing<K>>& a);
+    // the first n_sum elements are summed, the others XORed, in one opening
+    std::vector<Semi2kSharing<K>> open_mixed(const std::vector<Semi2kSharing<K>>& a, size_t n_sum);
+
+    // protocol coroutines: co_x is the coroutine behind x, which runs it with run_now;
+    // under a RoundScheduler independent co_ calls share their opening rounds.
+    // the awaitable openings below are merged with the other openings of their round
+    // under a RoundScheduler and happen at once otherwise; a must outlive the co_await
+    Opening<K> co_open(const std::vector<Semi2kSharing<K>>& a) { return {this, &a, OpenKind::sum}; }
+    Opening<K> co_open_xor(const std::vector<Semi2kSharing<K>>& a) { return {this, &a, OpenKind::xor_words}; }
+    Opening<K> co_open_bits(const std::vector<Semi2kSharing<K>>& a) { return {this, &a, OpenKind::bits}; }
 
     template <size_t KK>
     void print_sharings(const std::vector<Semi2kSharing<KK>>& sharings);
@@ -70,7 +175,15 @@ public:
     void mult_in_place(std::vector<Semi2kSharing<K>>& sharings_a, const std::vector<Semi2kSharing<K>>& sharings_b);
 
     std::vector<Semi2kSharing<K>> mult_sharing(const std::vector<Semi2kSharing<K>>& sharings_a, const std::vector<Semi2kSharing<K>>& sharings_b);
+    // independent products sharings_a[k] * sharings_b[k] in a single opening round
+    std::vector<std::vector<Semi2kSharing<K>>> mult_sharing_many(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<std::vector<Semi2kSharing<K>>>& sharings_b);
+    Task<std::vector<Semi2kSharing<K>>> co_mult_sharing(const std::vector<Semi2kSharing<K>>& sharings_a, const std::vector<Semi2kSharing<K>>& sharings_b);
+    Task<std::vector<std::vector<Semi2kSharing<K>>>> co_mult_sharing_many(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<std::vector<Semi2kSharing<K>>>& sharings_b);
     std::vector<Semi2kSharing<K>> mult_sharing_matrix(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<Semi2kSharing<K>>& sharings_b, int block_id);
+    // a * b for a matrix held in plaintext blockwise by its owners, one opening of b - v,
+    // each owner multiplies its own blocks locally, the others only add their share of a * v
+    std::vector<Semi2kSharing<K>> mult_plain_matrix(const PlainMatrix<K>& a, const std::vector<Semi2kSharing<K>>& sharings_b);
+    Task<std::vector<Semi2kSharing<K>>> co_mult_plain_matrix(const PlainMatrix<K>& a, const std::vector<Semi2kSharing<K>>& sharings_b);
     std::vector<Semi2kSharing<1>> mult_sharing_binary(const std::vector<Semi2kSharing<1>>& sharings_a, const std::vector<Semi2kSharing<1>>& sharings_b);
 
     std::vector<Semi2kSharing<K>> add(const std::vector<Semi2kSharing<K>>& sharings, const Plain& a) const;
@@ -82,10 +195,25 @@ public:
     void add_in_place(std::vector<Semi2kSharing<K>>& sharings, const std::vector<Plain>& a) const;
     void add_in_place(std::vector<Semi2kSharing<K>>& sharings_a, const std::vector<Semi2kSharing<K>>& sharings_b) const;
 
+    // bitwise AND of XOR-shared words, sharings_a[k] & sharings_b[k] in a single opening round
+    std::vector<std::vector<Semi2kSharing<K>>> and_many(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<std::vector<Semi2kSharing<K>>>& sharings_b);
+    Task<std::vector<std::vector<Semi2kSharing<K>>>> co_and_many(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<std::vector<Semi2kSharing<K>>>& sharings_b);
+
     std::vector<Semi2kSharing<K>> msb(const std::vector<Semi2kSharing<K>>& a);
+    // the bitwise backend runs synchronously inside, its rounds do not interleave
+    Task<std::vector<Semi2kSharing<K>>> co_msb(const std::vector<Semi2kSharing<K>>& a);
+    std::vector<Semi2kSharing<K>> msb_bitwise(const std::vector<Semi2kSharing<K>>& a);
+    std::vector<Semi2kSharing<K>> msb_edabit(const std::vector<Semi2kSharing<K>>& a);
+    std::vector<Semi2kSharing<K>> msb_dcf(const std::vector<Semi2kSharing<K>>& a);
+    Task<std::vector<Semi2kSharing<K>>> co_msb_edabit(const std::vector<Semi2kSharing<K>>& a);
+    Task<std::vector<Semi2kSharing<K>>> co_msb_dcf(const std::vector<Semi2kSharing<K>>& a);
     std::vector<Semi2kSharing<K>> get_rand_bit(unsigned len);
-    std::vector<Semi2kSharing<1>> a2b(const std::vector<Semi2kSharing<K>>& a);
+    // arithmetic shares to XOR-shared words holding the same bits, edaBits and a log-depth adder
+    std::vector<Semi2kSharing<K>> a2b(const std::vector<Semi2kSharing<K>>& a);
+    Task<std::vector<Semi2kSharing<K>>> co_a2b(const std::vector<Semi2kSharing<K>>& a);
+    // shared bits to arithmetic shares, one daBit and one batched opening
     std::vector<Semi2kSharing<K>> b2a(const std::vector<Semi2kSharing<1>>& a);
+    Task<std::vector<Semi2kSharing<K>>> co_b2a(const std::vector<Semi2kSharing<1>>& a);
     std::vector<Semi2kSharing<1>> bitLT(const std::vector<Semi2kSharing<K>>& a, const std::vector<std::vector<Semi2kSharing<1>>>& b);
     std::vector<Semi2kSharing<1>> carry(const std::vector<Semi2kSharing<K>>& a, const std::vector<std::vector<Semi2kSharing<1>>>& b, const std::vector<Semi2kSharing<1>>& c);
 
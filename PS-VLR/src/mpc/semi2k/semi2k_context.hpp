@@ -1,7 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <optional>
 #include <stdexcept>
 #include "semi2k_context.h"
+#include "round_scheduler.hpp"
+#include "../../serialization/chunk_reader.h"
 #include "../../serialization/stl.h"
 #include "../../utils/utils.h"
 #include <iostream>
@@ -39,6 +45,57 @@ void Semi2kContext<K>::generate_rand_bit(size_t n){
     }
 }
 
+template <size_t K>
+void Semi2kContext<K>::set_dealer(Semi2kDealer<K>* dealer){
+    this->dealer = dealer;
+}
+
+template <size_t K>
+std::vector<EdaBit<K>> Semi2kContext<K>::get_edabit(size_t n, size_t bits){
+    if(cost_model) cost_model->edabits += n;
+    if(dealer) return dealer->edabits(n, bits);
+    return std::vector<EdaBit<K>>(n, EdaBit<K>{0, 0});
+}
+
+template <size_t K>
+std::vector<DaBit<K>> Semi2kContext<K>::get_dabit(size_t n){
+    if(cost_model) cost_model->dabits += n;
+    if(dealer) return dealer->dabits(n);
+    return std::vector<DaBit<K>>(n, DaBit<K>{0, 0});
+}
+
+template <size_t K>
+std::vector<BeaverTriple<K>> Semi2kContext<K>::get_and_triple(size_t n){
+    if(cost_model) cost_model->binary_triples += n * K;
+    if(dealer) return dealer->and_triples(n);
+    return std::vector<BeaverTriple<K>>(n, BeaverTriple<K>(0, 0, 0));
+}
+
+template <size_t K>
+std::vector<DcfMsbKey<K>> Semi2kContext<K>::get_dcf_msb_key(size_t n){
+    if(cost_model) cost_model->dcf_keys += n;
+    if(dealer) return dealer->dcf_msb_keys(n);
+    if(is_symbolic()) return std::vector<DcfMsbKey<K>>(n, DcfMsbKey<K>{0, 0, {}});
+    throw std::runtime_error("the dcf msb backend needs a dealer");
+}
+
+template <size_t K>
+PlainMatrixTriple<K> Semi2kContext<K>::get_plain_matrix_triple(const PlainMatrix<K>& a){
+    if(cost_model) cost_model->plain_matrix_triples[std::make_pair(int(a.rows), int(a.cols))] += 1;
+    if(dealer) return dealer->plain_matrix_triple(a);
+    return PlainMatrixTriple<K>{std::vector<Semi2kSharing<K>>(a.cols, 0), std::vector<Semi2kSharing<K>>(a.rows, 0)};
+}
+
+template <size_t K>
+void Semi2kContext<K>::set_cost_model(CostModel* cost_model){
+    this->cost_model = cost_model;
+}
+
+template <size_t K>
+void Semi2kContext<K>::set_matrix_triple_pool(MatrixTriplePool<K>* pool){
+    matrix_triple_pool = pool;
+}
+
 template <size_t K>
 void Semi2kContext<K>::set_matrix_triple(const std::vector<MatrixTripleSeries>& triples, int n, int m){
     matrix_triples[std::make_pair(n, m)] = triples;
@@ -48,17 +105,9 @@ void Semi2kContext<K>::set_matrix_triple(const std::vector<MatrixTripleSeries>&
 template <size_t K>
 template <size_t KK>
 std::vector<Semi2kSharing<KK>> Semi2kContext<K>::rand(size_t n){
-    std::vector<Semi2kSharing<KK>> r(n), tmp;
+    std::vector<Semi2kSharing<KK>> r(n);
     for(auto& ri: r) ri = randomGenerator.get_random();
-    Serializer sr;
-    sr << r;
-    auto msgs = mplayer->mbroadcast_recv(parties, sr.finalize());
-    for(const auto& pid: parties){
-        Deserializer dr(std::move(msgs[pid]));
-        dr >> tmp;
-        for(int i = 0; i != r.size(); ++i) r[i] += tmp[i];
-    }
-    return r;
+    return reconstruct(r, [](size_t, auto& x, const auto& y){ x += y; });
 }
 
 template <size_t K>
@@ -158,50 +207,185 @@ void  Semi2kContext<K>::add_in_place(std::vector<Semi2kSharing<K>>& sharings_a,
 
 template <size_t K>
 std::vector<Semi2kSharing<K>> Semi2kContext<K>::mult_sharing(const std::vector<Semi2kSharing<K>>& sharings_a, const std::vector<Semi2kSharing<K>>& sharings_b){
-    // if(sharings_a.size() > triples.size()){
-    //     std::cout << "The triple is not enough! need " << sharings_a.size() << ", have " << triples.size();
-    //     exit(-1);
-    // }
-    
-    std::vector<Semi2kSharing<K>> u(sharings_a.size(), 0), v(sharings_a.size(), 0), uv(sharings_a.size(), 0);
-    // for(int i = 0; i != sharings_a.size(); ++i){
+    return run_now<K>(co_mult_sharing(sharings_a, sharings_b));
+}
+
+template <size_t K>
+Task<std::vector<Semi2kSharing<K>>> Semi2kContext<K>::co_mult_sharing(const std::vector<Semi2kSharing<K>>& sharings_a, const std::vector<Semi2kSharing<K>>& sharings_b){
+    trace::Scope scope("mult_sharing");
+    std::vector<std::vector<Semi2kSharing<K>>> lhs(1, sharings_a), rhs(1, sharings_b);
+    co_return std::move((co_await co_mult_sharing_many(lhs, rhs))[0]);
+}
+
+template <size_t K>
+std::vector<std::vector<Semi2kSharing<K>>> Semi2kContext<K>::mult_sharing_many(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<std::vector<Semi2kSharing<K>>>& sharings_b){
+    return run_now<K>(co_mult_sharing_many(sharings_a, sharings_b));
+}
+
+template <size_t K>
+Task<std::vector<std::vector<Semi2kSharing<K>>>> Semi2kContext<K>::co_mult_sharing_many(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<std::vector<Semi2kSharing<K>>>& sharings_b){
+    if(sharings_a.size() != sharings_b.size()) throw std::invalid_argument("mult_sharing_many: operand count mismatch");
+
+    // all masked operands go into one opening: [a_0 - u_0, b_0 - v_0, a_1 - u_1, ...]
+    size_t total = 0;
+    for(int k = 0; k != sharings_a.size(); ++k){
+        if(sharings_a[k].size() != sharings_b[k].size()) throw std::invalid_argument("mult_sharing_many: operand size mismatch");
+        total += sharings_a[k].size();
+    }
+    if(cost_model) cost_model->triples += total;
+
+    std::vector<Semi2kSharing<K>> u(total, 0), v(total, 0), uv(total, 0);
+    if(dealer){
+        auto t = dealer->triples(total);
+        for(int i = 0; i != total; ++i){
+            u[i] = t[i].u;
+            v[i] = t[i].v;
+            uv[i] = t[i].uv;
+        }
+    }
+    // for(int i = 0; i != total; ++i){
     //     auto tmp = triples[triples.size() - 1];
     //     u[i] = tmp.u;
     //     v[i] = tmp.v;
     //     uv[i] = tmp.uv;
     //     triples.pop_back();
     // }
-    auto a_u = add(sharings_a, mult(u, -1));
-    auto b_v = add(sharings_b, mult(v, -1));
-    auto p_a_u = open(a_u);
-    auto p_b_v = open(b_v);
-    auto ret = add(add(mult(p_b_v, u), mult(p_a_u, v)), uv);
-    if(id < *(parties.begin())) ret = add(ret, mult(p_a_u, p_b_v));
-    return ret;
+    std::vector<Semi2kSharing<K>> masked;
+    masked.reserve(2 * total);
+    size_t offset = 0;
+    for(int k = 0; k != sharings_a.size(); ++k){
+        size_t len = sharings_a[k].size();
+        for(int i = 0; i != len; ++i) masked.push_back(sharings_a[k][i] - u[offset + i]);
+        for(int i = 0; i != len; ++i) masked.push_back(sharings_b[k][i] - v[offset + i]);
+        offset += len;
+    }
+    auto opened = co_await co_open(masked);
+
+    std::vector<std::vector<Semi2kSharing<K>>> ret(sharings_a.size());
+    size_t pos = 0;
+    offset = 0;
+    for(int k = 0; k != sharings_a.size(); ++k){
+        size_t len = sharings_a[k].size();
+        ret[k].resize(len);
+        for(int i = 0; i != len; ++i){
+            const auto& p_a_u = opened[pos + i];
+            const auto& p_b_v = opened[pos + len + i];
+            ret[k][i] = p_b_v * u[offset + i] + p_a_u * v[offset + i] + uv[offset + i];
+            if(is_leader()) ret[k][i] += p_a_u * p_b_v;
+        }
+        pos += 2 * len;
+        offset += len;
+    }
+    co_return ret;
+}
+
+template <size_t K>
+std::vector<std::vector<Semi2kSharing<K>>> Semi2kContext<K>::and_many(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<std::vector<Semi2kSharing<K>>>& sharings_b){
+    return run_now<K>(co_and_many(sharings_a, sharings_b));
+}
+
+template <size_t K>
+Task<std::vector<std::vector<Semi2kSharing<K>>>> Semi2kContext<K>::co_and_many(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<std::vector<Semi2kSharing<K>>>& sharings_b){
+    if(sharings_a.size() != sharings_b.size()) throw std::invalid_argument("and_many: operand count mismatch");
+
+    size_t total = 0;
+    for(int k = 0; k != sharings_a.size(); ++k){
+        if(sharings_a[k].size() != sharings_b[k].size()) throw std::invalid_argument("and_many: operand size mismatch");
+        total += sharings_a[k].size();
+    }
+    auto t = get_and_triple(total);
+
+    std::vector<Semi2kSharing<K>> masked;
+    masked.reserve(2 * total);
+    size_t offset = 0;
+    for(int k = 0; k != sharings_a.size(); ++k){
+        size_t len = sharings_a[k].size();
+        for(int i = 0; i != len; ++i) masked.push_back(sharings_a[k][i] ^ t[offset + i].u);
+        for(int i = 0; i != len; ++i) masked.push_back(sharings_b[k][i] ^ t[offset + i].v);
+        offset += len;
+    }
+    auto opened = co_await co_open_xor(masked);
+
+    std::vector<std::vector<Semi2kSharing<K>>> ret(sharings_a.size());
+    size_t pos = 0;
+    offset = 0;
+    for(int k = 0; k != sharings_a.size(); ++k){
+        size_t len = sharings_a[k].size();
+        ret[k].resize(len);
+        for(int i = 0; i != len; ++i){
+            const auto& d = opened[pos + i];
+            const auto& e = opened[pos + len + i];
+            const auto& tr = t[offset + i];
+            ret[k][i] = (d & tr.v) ^ (e & tr.u) ^ tr.uv;
+            if(is_leader()) ret[k][i] ^= (d & e);
+        }
+        pos += 2 * len;
+        offset += len;
+    }
+    co_return ret;
 }
 
 template <size_t K>
 std::vector<Semi2kSharing<K>> Semi2kContext<K>::mult_sharing_matrix(const std::vector<std::vector<Semi2kSharing<K>>>& sharings_a, const std::vector<Semi2kSharing<K>>& sharings_b, int block_id){
+    trace::Scope scope("mult_sharing_matrix");
 
     int n = sharings_a.size();
     int m = sharings_a[0].size();
 
-    std::vector<Semi2kSharing<K>> v = *(matrix_triples[std::make_pair(n, m)][block_id].Vs.end() - 1);
-    std::vector<Semi2kSharing<K>> uv = *(matrix_triples[std::make_pair(n, m)][block_id].UVs.end() - 1);
-    
-    matrix_triples[std::make_pair(n, m)][block_id].Vs.pop_back();
-    matrix_triples[std::make_pair(n, m)][block_id].UVs.pop_back();
+    if(cost_model) cost_model->matrix_triples[std::make_pair(n, m)] += 1;
+    if(is_symbolic()){
+        open(sharings_b);
+        return std::vector<Semi2kSharing<K>>(n, 0);
+    }
+
+    std::vector<Semi2kSharing<K>> v, uv;
+    if(matrix_triple_pool && matrix_triple_pool->contains(n, m, block_id)){
+        auto triple = matrix_triple_pool->acquire(n, m, block_id);
+        v = std::move(triple.V);
+        uv = std::move(triple.UV);
+    }
+    else{
+        auto it = matrix_triples.find(std::make_pair(n, m));
+        if(it == matrix_triples.end() || block_id >= it->second.size() || it->second[block_id].Vs.empty() || it->second[block_id].UVs.empty()){
+            throw std::runtime_error("The matrix triple is not enough!");
+        }
+        auto& series = it->second[block_id];
+        v = std::move(series.Vs.back());
+        uv = std::move(series.UVs.back());
+        series.Vs.pop_back();
+        series.UVs.pop_back();
+    }
 
     auto p_a_u = sharings_a;
-    auto b_v = add(sharings_b, mult(v, -1));
-    auto p_b_v = open(b_v);
-    auto ret = add(add(mult_mv(p_a_u, v), mult_mv(p_a_u, v)), uv);
-    if(id < *(parties.begin())) ret = add(ret, mult_mv(p_a_u, p_b_v));
+    auto p_b_v = open(evaluate(sharings_b - v, thread_pool));
+    auto ret = evaluate(mult_mv(p_a_u, v, thread_pool) + mult_mv(p_a_u, v, thread_pool) + uv, thread_pool);
+    if(id < *(parties.begin())) assign(ret, ret + mult_mv(p_a_u, p_b_v, thread_pool), thread_pool);
     return ret;
 }
 
+template <size_t K>
+std::vector<Semi2kSharing<K>> Semi2kContext<K>::mult_plain_matrix(const PlainMatrix<K>& a, const std::vector<Semi2kSharing<K>>& sharings_b){
+    return run_now<K>(co_mult_plain_matrix(a, sharings_b));
+}
+
+template <size_t K>
+Task<std::vector<Semi2kSharing<K>>> Semi2kContext<K>::co_mult_plain_matrix(const PlainMatrix<K>& a, const std::vector<Semi2kSharing<K>>& sharings_b){
+    trace::Scope scope("mult_plain_matrix");
+    if(sharings_b.size() != a.cols) throw std::invalid_argument("mult_plain_matrix: vector size mismatch");
+
+    auto triple = get_plain_matrix_triple(a);
+    auto masked = evaluate(sharings_b - triple.v, thread_pool);
+    auto p_b_v = co_await co_open(masked);
+    if(is_symbolic()) co_return std::vector<Semi2kSharing<K>>(a.rows, 0);
+
+    auto ret = std::move(triple.av);
+    a.mult_local(id, p_b_v, ret, thread_pool);
+    co_return ret;
+}
+
 template <size_t K>
 std::vector<Semi2kSharing<1>> Semi2kContext<K>::mult_sharing_binary(const std::vector<Semi2kSharing<1>>& sharings_a, const std::vector<Semi2kSharing<1>>& sharings_b){
+    if(cost_model) cost_model->binary_triples += sharings_a.size();
     // if(sharings_a.size() > binary_triples.size()){
     //     std::cout << "The binary triple is not enough! need " << sharings_a.size() << ", have " << binary_triples.size();
     //     exit(-1);
@@ -216,13 +400,12 @@ std::vector<Semi2kSharing<1>> Semi2kContext<K>::mult_sharing_binary(const std::v
     //     uv[i] = tmp.uv;
     //     binary_triples.pop_back();
     // }
-    Semi2kContext<1> sc(mplayer, parties, id, seed);
-    auto a_u = sc.add(sharings_a, sc.mult(u, -1));
-    auto b_v = sc.add(sharings_b, sc.mult(v, -1));
-    auto p_a_u = sc.open(a_u);
-    auto p_b_v = sc.open(b_v);
-    auto ret = sc.add(sc.add(sc.mult(p_b_v, u), sc.mult(p_a_u, v)), uv);
-    if(id < *(parties.begin())) ret = sc.add(ret, sc.mult(p_a_u, p_b_v));
+    auto sc = sub_context<1>();
+    auto p_a_u = sc.open(evaluate(sharings_a - u));
+    auto p_b_v = sc.open(evaluate(sharings_b - v));
+    king_openings = sc.king_openings;
+    auto ret = evaluate(p_b_v * u + p_a_u * v + uv);
+    if(id < *(parties.begin())) assign(ret, ret + p_a_u * p_b_v);
     return ret;
 }
 
@@ -265,6 +448,68 @@ void Semi2kContext<K>::mult_in_place(std::vector<Semi2kSharing<K>>& sharings_a,
 
 template <size_t K>
 std::vector<Semi2kSharing<K>> Semi2kContext<K>::msb(const std::vector<Semi2kSharing<K>>& a){
+    return run_now<K>(co_msb(a));
+}
+
+template <size_t K>
+Task<std::vector<Semi2kSharing<K>>> Semi2kContext<K>::co_msb(const std::vector<Semi2kSharing<K>>& a){
+    // phases nest as a stack, which interleaved coroutines would break
+    std::optional<network::PhaseGuard> phase;
+    if(!RoundScheduler<K>::current()) phase.emplace(mplayer->phases(), "msb");
+    trace::Scope scope("msb");
+    switch(msb_backend){
+        case MsbBackend::bitwise: co_return msb_bitwise(a);
+        case MsbBackend::edabit:  co_return co_await co_msb_edabit(a);
+        case MsbBackend::dcf:     co_return co_await co_msb_dcf(a);
+    }
+    throw std::invalid_argument("unknown msb backend");
+}
+
+template <size_t K>
+std::vector<Semi2kSharing<K>> Semi2kContext<K>::msb_edabit(const std::vector<Semi2kSharing<K>>& a){
+    return run_now<K>(co_msb_edabit(a));
+}
+
+template <size_t K>
+Task<std::vector<Semi2kSharing<K>>> Semi2kContext<K>::co_msb_edabit(const std::vector<Semi2kSharing<K>>& a){
+    auto words = co_await co_a2b(a);
+    std::vector<Semi2kSharing<1>> bits(a.size());
+    for(int i = 0; i != a.size(); ++i) bits[i] = Semi2kSharing<1>(words[i].bit(K - 1));
+    co_return co_await co_b2a(bits);
+}
+
+template <size_t K>
+std::vector<Semi2kSharing<K>> Semi2kContext<K>::msb_dcf(const std::vector<Semi2kSharing<K>>& a){
+    return run_now<K>(co_msb_dcf(a));
+}
+
+template <size_t K>
+Task<std::vector<Semi2kSharing<K>>> Semi2kContext<K>::co_msb_dcf(const std::vector<Semi2kSharing<K>>& a){
+    // a = y - r with y = a + r public: msb(a) = y_{K-1} ^ r_{K-1} ^ [y mod 2^(K-1) < r mod 2^(K-1)],
+    // the key evaluates to (-1)^{r_{K-1}} [y' < r'], so gamma + eval is r_{K-1} ^ [y' < r']
+    auto keys = get_dcf_msb_key(a.size());
+    std::vector<Semi2kSharing<K>> masked(a.size());
+    for(int i = 0; i != a.size(); ++i) masked[i] = a[i] + keys[i].r;
+    auto y = co_await co_open(masked);
+
+    std::vector<Semi2kSharing<K>> ret(a.size(), 0);
+    if(is_symbolic()) co_return ret;
+    for(int i = 0; i != a.size(); ++i){
+        Semi2kSharing<K> c = keys[i].gamma;
+        if(id <= 1) c += dcf_eval<K>(id, keys[i].key, Semi2kSharing<K>((y[i] << 1) >> 1), K - 1);
+        if(y[i].bit(K - 1)){
+            ret[i] = -c;
+            if(is_leader()) ret[i] += Semi2kSharing<K>(1);
+        }
+        else{
+            ret[i] = c;
+        }
+    }
+    co_return ret;
+}
+
+template <size_t K>
+std::vector<Semi2kSharing<K>> Semi2kContext<K>::msb_bitwise(const std::vector<Semi2kSharing<K>>& a){
     // Step 1
     std::vector<Semi2kSharing<K>> b = get_rand_bit(a.size());
     std::vector<std::vector<Semi2kSharing<K>>> rs(a.size());
@@ -293,7 +538,11 @@ std::vector<Semi2kSharing<K>> Semi2kContext<K>::msb(const std::vector<Semi2kShar
     
     // std::cout << rs.size() - 1 << std::endl;
     std::vector<std::vector<Semi2kSharing<1>>> r2s(rs.size());
-    for(int i = 0; i != r2s.size(); ++i) {r2s[i] = a2b(rs[i]); r2s[i].pop_back();}
+    // arithmetic shares of a bit convert to Z_2 locally, the low bits xor to the same bit
+    for(int i = 0; i != r2s.size(); ++i){
+        r2s[i].resize(K - 1);
+        for(int j = 0; j != K - 1; ++j) r2s[i][j] = Semi2kSharing<1>(rs[i][j]);
+    }
 
     // Step 5
     std::vector<Semi2kSharing<1>> u2(a.size());
@@ -305,13 +554,13 @@ std::vector<Semi2kSharing<K>> Semi2kContext<K>::msb(const std::vector<Semi2kShar
     // Step 7
     std::vector<Semi2kSharing<K>> tmp(u);
     for(int i = 0; i != a.size(); ++i) tmp[i] <<= (K - 1);
-    std::vector<Semi2kSharing<K>> d = add(add(a, r_prime), mult(tmp, -1));
-    if(id < *(parties.begin())) d = add(d, mult(c_prime, -1));
+    std::vector<Semi2kSharing<K>> d = evaluate(a + r_prime - tmp);
+    if(id < *(parties.begin())) assign(d, d - c_prime);
 
     // Step 8
     std::vector<Semi2kSharing<K>> tmp_2(b);
     for(int i = 0; i != a.size(); ++i) tmp_2[i] <<= (K - 1);
-    std::vector<Semi2kSharing<K>> e = open(add(d, tmp_2));
+    std::vector<Semi2kSharing<K>> e = open(evaluate(d + tmp_2));
     for(int i = 0; i != a.size(); ++i) e[i] >>= (K - 1); 
 
     // Step 9
@@ -325,6 +574,7 @@ std::vector<Semi2kSharing<K>> Semi2kContext<K>::msb(const std::vector<Semi2kShar
 
 template <size_t K>
 std::vector<Semi2kSharing<K>> Semi2kContext<K>::get_rand_bit(unsigned len){
+    if(cost_model) cost_model->rand_bits += len;
     // if(len > rand_bits.size()){
     //     std::cout << "The rand_bit is not enough! need " << len << ", have " << rand_bits.size();
     //     exit(-1);
@@ -335,17 +585,85 @@ std::vector<Semi2kSharing<K>> Semi2kContext<K>::get_rand_bit(unsigned len){
 }
 
 template <size_t K>
-std::vector<Semi2kSharing<1>> Semi2kContext<K>::a2b(const std::vector<Semi2kSharing<K>>& a){
-    std::vector<Semi2kSharing<1>> ret(a.size());
-    for(int i = 0; i != a.size(); ++i) ret[i] = Semi2kSharing<1>(a[i]);
-    return ret;
+std::vector<Semi2kSharing<K>> Semi2kContext<K>::a2b(const std::vector<Semi2kSharing<K>>& a){
+    return run_now<K>(co_a2b(a));
+}
+
+template <size_t K>
+Task<std::vector<Semi2kSharing<K>>> Semi2kContext<K>::co_a2b(const std::vector<Semi2kSharing<K>>& a){
+    trace::Scope scope("a2b");
+    auto e = get_edabit(a.size());
+
+    // c = a + r is public, then a = c - r = c + ~r + 1
+    std::vector<Semi2kSharing<K>> masked(a.size());
+    for(int i = 0; i != a.size(); ++i) masked[i] = a[i] + e[i].r;
+    auto c = co_await co_open(masked);
+
+    // Kogge-Stone adder of the public c and the XOR-shared y = ~r, one word per element:
+    // g = c & y and p = c ^ y, the carry-in 1 turns g_0 into g_0 | p_0 = g_0 ^ p_0
+    // level s: g ^= p & (g << s), p &= p << s, both ANDs share one round
+    const Semi2kSharing<K> one(1);
+    std::vector<Semi2kSharing<K>> g(a.size()), p(a.size()), p0;
+    for(int i = 0; i != a.size(); ++i){
+        Semi2kSharing<K> y = is_leader() ? Semi2kSharing<K>(~e[i].bits) : e[i].bits;
+        g[i] = y & c[i];
+        p[i] = is_leader() ? Semi2kSharing<K>(y ^ c[i]) : y;
+        g[i] ^= (p[i] & one);
+    }
+    p0 = p;
+
+    for(size_t s = 1; s < K; s <<= 1){
+        std::vector<Semi2kSharing<K>> g_s(a.size()), p_s(a.size());
+        for(int i = 0; i != a.size(); ++i){
+            g_s[i] = g[i] << s;
+            p_s[i] = p[i] << s;
+        }
+        // named operands, gcc 12 rejects braced lists in a co_await
+        std::vector<std::vector<Semi2kSharing<K>>> lhs(1, p), rhs(1, std::move(g_s));
+        if(2 * s < K){
+            lhs.push_back(p);
+            rhs.push_back(std::move(p_s));
+        }
+        auto r = co_await co_and_many(lhs, rhs);
+        for(int i = 0; i != a.size(); ++i) g[i] ^= r[0][i];
+        if(2 * s < K) p = std::move(r[1]);
+    }
+
+    // sum bit i = p_i ^ carry into i, the carry into bit 0 is the 1
+    std::vector<Semi2kSharing<K>> ret(a.size());
+    for(int i = 0; i != a.size(); ++i){
+        ret[i] = p0[i] ^ (g[i] << 1);
+        if(is_leader()) ret[i] ^= one;
+    }
+    co_return ret;
 }
 
 template <size_t K>
 std::vector<Semi2kSharing<K>> Semi2kContext<K>::b2a(const std::vector<Semi2kSharing<1>>& a){
+    return run_now<K>(co_b2a(a));
+}
+
+template <size_t K>
+Task<std::vector<Semi2kSharing<K>>> Semi2kContext<K>::co_b2a(const std::vector<Semi2kSharing<1>>& a){
+    trace::Scope scope("b2a");
+    auto d = get_dabit(a.size());
+
+    // c = a ^ b is public, then a = b + c - 2cb
+    std::vector<Semi2kSharing<K>> masked(a.size());
+    for(int i = 0; i != a.size(); ++i) masked[i] = Semi2kSharing<K>((a[i] + d[i].bit).bit(0));
+    auto c = co_await co_open_bits(masked);
+
     std::vector<Semi2kSharing<K>> ret(a.size());
-    for(int i = 0; i != a.size(); ++i) ret[i] = Semi2kSharing<K>(a[i]);
-    return ret;
+    for(int i = 0; i != a.size(); ++i){
+        if(c[i].bit(0)){
+            ret[i] = -d[i].arith;
+            if(is_leader()) ret[i] += Semi2kSharing<K>(1);
+        }
+        else{
+            ret[i] = d[i].arith;
+        }
+    }
+    co_return ret;
 }
 
 template <size_t K>
@@ -371,7 +689,6 @@ std::vector<Semi2kSharing<1>> Semi2kContext<K>::bitLT(const std::vector<Semi2kSh
 template <size_t K>
 std::vector<Semi2kSharing<1>> Semi2kContext<K>::carry(const std::vector<Semi2kSharing<K>>& a, const std::vector<std::vector<Semi2kSharing<1>>>& b, const std::vector<Semi2kSharing<1>>& c){
     // TODO
-    Semi2kContext<1> sc(mplayer, parties, id, seed);
     std::vector<Semi2kSharing<1>> cc;
     if(id < *(parties.begin())) cc = c;
     else cc = std::vector<Semi2kSharing<1>>(c.size(), 0);
@@ -382,25 +699,204 @@ std::vector<Semi2kSharing<1>> Semi2kContext<K>::carry(const std::vector<Semi2kSh
         for(int i = 0; i != a.size(); ++i) bb[i] = b[i][j];
 
         if(id < *(parties.begin())){
-            cc = sc.add(mult_sharing_binary(sc.add(aa, bb), cc), sc.mult(aa, bb));
+            cc = evaluate(mult_sharing_binary(evaluate(aa + bb), cc) + aa * bb);
         }
         else{
-            cc = sc.add(mult_sharing_binary(bb, cc), sc.mult(aa, bb));
+            cc = evaluate(mult_sharing_binary(bb, cc) + aa * bb);
         }
     }
     return cc;
 }
 
+template <size_t K>
+void Semi2kContext<K>::set_open_strategy(OpenStrategy strategy, int king){
+    if(king != -1 && playerid_t(king) != id && !parties.contains(king)) throw std::invalid_argument("the king is not one of the parties");
+    open_strategy = strategy;
+    fixed_king = king;
+}
+
+template <size_t K>
+bool Semi2kContext<K>::use_king(size_t bytes) const{
+    size_t n = parties.size() + 1;
+    switch(open_strategy){
+        case OpenStrategy::all_to_all: return false;
+        case OpenStrategy::king:       return true;
+        default: break;
+    }
+    if(n < 3) return false;
+    if(!open_calibrated) return n > 4;
+    // all-to-all: open_latency + n(n-1) * bytes * open_byte_time
+    // king:   2 * open_latency + 2(n-1) * bytes * open_byte_time
+    return (n - 1) * (n - 2) * double(bytes) * open_byte_time > open_latency;
+}
+
+template <size_t K>
+template <size_t KK>
+Semi2kContext<KK> Semi2kContext<K>::sub_context() const{
+    Semi2kContext<KK> sc(mplayer, parties, id, seed);
+    sc.open_strategy = open_strategy;
+    sc.fixed_king = fixed_king;
+    sc.king_openings = king_openings;
+    sc.open_latency = open_latency;
+    sc.open_byte_time = open_byte_time;
+    sc.open_calibrated = open_calibrated;
+    sc.stream_chunk_bytes = stream_chunk_bytes;
+    return sc;
+}
+
+template <size_t K>
+playerid_t Semi2kContext<K>::next_king(){
+    if(fixed_king != -1) return fixed_king;
+    mplayerid_t all = parties;
+    all.insert(id);
+    size_t k = king_openings % all.size();
+    for(auto pid: all){
+        if(k-- == 0) return pid;
+    }
+    return id;
+}
+
+template <size_t K>
+template <size_t KK, typename Op>
+std::vector<Semi2kSharing<KK>> Semi2kContext<K>::reconstruct(const std::vector<Semi2kSharing<KK>>& a, Op op){
+    std::vector<Semi2kSharing<KK>> ret(a), tmp;
+    Serializer sr;
+    {
+        trace::Scope scope("serialize", trace::serialize);
+        sr << a;
+    }
+    auto message = sr.finalize();
+    size_t bytes = message.size();
+    auto combine = [&](ByteVector&& msg){
+        {
+            trace::Scope scope("deserialize", trace::serialize);
+            Deserializer dr(std::move(msg));
+            dr >> tmp;
+        }
+        for(int i = 0; i != ret.size(); ++i) op(i, ret[i], tmp[i]);
+    };
+    // large shares are combined piece by piece as they arrive
+    bool stream = stream_chunk_bytes != 0 && bytes > stream_chunk_bytes;
+    std::vector<VectorChunkReader<Semi2kSharing<KK>>> readers(stream ? mplayer->all().size() : 0);
+    auto combine_chunk = [&](playerid_t from, ByteVector&& chunk){
+        readers.at(from).feed(chunk, [&](size_t i, const Semi2kSharing<KK>& x){
+            if(i >= ret.size()) throw std::runtime_error("opening: a party sent more shares than expected");
+            op(i, ret[i], x);
+        });
+    };
+    auto check_readers = [&]{
+        for(const auto& pid: parties){
+            if(!readers[pid].done() || readers[pid].size() != ret.size()) throw std::runtime_error("opening: a party sent fewer shares than expected");
+        }
+    };
+
+    if(!use_king(bytes)){
+        if(stream){
+            mplayer->mbroadcast_recv_chunked(parties, std::move(message), stream_chunk_bytes, combine_chunk);
+            check_readers();
+            return ret;
+        }
+        auto msgs = mplayer->mbroadcast_recv(parties, std::move(message));
+        for(const auto& pid: parties) combine(std::move(msgs[pid]));
+        return ret;
+    }
+
+    playerid_t king = next_king();
+    ++king_openings;
+    if(cost_model) cost_model->king_openings += 1;
+    if(king != id){
+        mplayer->send(king, std::move(message));
+        Deserializer dr(mplayer->recv(king, bytes));
+        dr >> ret;
+        return ret;
+    }
+    if(is_symbolic()){
+        // a symbolic recv mirrors the last message sent: send the value, as large as a share, first
+        mplayer->mbroadcast(parties, std::move(message));
+        auto msgs = mplayer->mrecv(parties);
+        for(const auto& pid: parties) combine(std::move(msgs[pid]));
+        return ret;
+    }
+    if(stream){
+        mplayer->mrecv_chunked(parties, stream_chunk_bytes, combine_chunk);
+        check_readers();
+    }
+    else{
+        auto msgs = mplayer->mrecv(parties, bytes);
+        for(const auto& pid: parties) combine(std::move(msgs[pid]));
+    }
+    Serializer out;
+    out << ret;
+    mplayer->mbroadcast(parties, out.finalize());
+    return ret;
+}
+
 template <size_t K>
 std::vector<Semi2kSharing<K>> Semi2kContext<K>::open(const std::vector<Semi2kSharing<K>>& a){
-    std::vector<Semi2kSharing<K>>ret(a), tmp;
+    trace::Scope scope("open");
+    return reconstruct(a, [](size_t, auto& x, const auto& y){ x += y; });
+}
+
+template <size_t K>
+std::vector<Semi2kSharing<K>> Semi2kContext<K>::open_xor(const std::vector<Semi2kSharing<K>>& a){
+    trace::Scope scope("open_xor");
+    return reconstruct(a, [](size_t, auto& x, const auto& y){ x ^= y; });
+}
+
+template <size_t K>
+std::vector<Semi2kSharing<K>> Semi2kContext<K>::open_bits(const std::vector<Semi2kSharing<K>>& a){
+    // a bit per element on the wire, as b2a always sent them
+    auto sc = sub_context<1>();
+    std::vector<Semi2kSharing<1>> bits(a.size());
+    for(int i = 0; i != a.size(); ++i) bits[i] = Semi2kSharing<1>(a[i].bit(0));
+    auto opened = sc.open(bits);
+    king_openings = sc.king_openings;
+    std::vector<Semi2kSharing<K>> ret(a.size());
+    for(int i = 0; i != a.size(); ++i) ret[i] = Semi2kSharing<K>(opened[i].bit(0));
+    return ret;
+}
+
+template <size_t K>
+std::vector<Semi2kSharing<K>> Semi2kContext<K>::open_mixed(const std::vector<Semi2kSharing<K>>& a, size_t n_sum){
+    trace::Scope scope("open_mixed");
+    return reconstruct(a, [n_sum](size_t i, auto& x, const auto& y){
+        if(i < n_sum) x += y;
+        else x ^= y;
+    });
+}
+
+template <size_t K>
+void Semi2kContext<K>::calibrate_open(size_t probe_bytes){
+    if(is_symbolic() || parties.empty()) return;
+    using clock = std::chrono::steady_clock;
+
+    size_t n = parties.size() + 1;
+    auto time_open = [&](size_t elements){
+        std::vector<Semi2kSharing<K>> x(elements);
+        Serializer sr;
+        sr << x;
+        auto start = clock::now();
+        mplayer->mbroadcast_recv(parties, sr.finalize());
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+    time_open(1);
+    double latency = std::min({time_open(1), time_open(1), time_open(1)});
+    size_t elements = std::max<size_t>(1, probe_bytes / sizeof(Semi2kSharing<K>));
+    double bulk = time_open(elements);
+    double byte_time = std::max(0.0, bulk - latency) / (double(n) * (n - 1) * elements * sizeof(Semi2kSharing<K>));
+
+    // summed in party order, every party computes the same bits and decides alike
+    std::vector<double> latencies(n), byte_times(n);
+    latencies[id] = latency;
+    byte_times[id] = byte_time;
     Serializer sr;
-    sr << a;
+    sr << latency << byte_time;
     auto msgs = mplayer->mbroadcast_recv(parties, sr.finalize());
     for(const auto& pid: parties){
         Deserializer dr(std::move(msgs[pid]));
-        dr >> tmp;
-        for(int i = 0; i != ret.size(); ++i) ret[i] += tmp[i];
+        dr >> latencies[pid] >> byte_times[pid];
     }
-    return ret;
-}
\ No newline at end of file
+    open_latency = std::accumulate(latencies.begin(), latencies.end(), 0.0) / n;
+    open_byte_time = std::accumulate(byte_times.begin(), byte_times.end(), 0.0) / n;
+    open_calibrated = true;
+}
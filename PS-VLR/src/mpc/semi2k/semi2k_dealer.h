@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "semi2k_sharing.hpp"
+#include "dcf.hpp"
+#include "plain_matrix.h"
+#include "../../network/playerid.h"
+
+/// @brief edaBit: a random r < 2^bits, shared additively over Z_2^K and bitwise over XOR
+/// the boolean part is one XOR-shared K-bit word whose bit i is bit i of r
+template <size_t K>
+struct EdaBit{
+    Semi2kSharing<K> r;
+    Semi2kSharing<K> bits;
+};
+
+/// @brief daBit: a random bit, shared additively over Z_2^K and over Z_2
+template <size_t K>
+struct DaBit{
+    Semi2kSharing<K> arith;
+    Semi2kSharing<1> bit;
+};
+
+/// @brief correlated randomness of one DCF-based msb
+/// r is shared by all parties, gamma = r_{K-1} as well, parties 0 and 1 also hold
+/// a DCF key of [x < r mod 2^(K-1)] with output (-1)^gamma, the other parties an empty one
+template <size_t K>
+struct DcfMsbKey{
+    Semi2kSharing<K> r;
+    Semi2kSharing<K> gamma;
+    DcfKey<K> key;
+};
+
+/// @brief Local stand-in for a trusted dealer of correlated randomness.
+/// Every party runs the same PRG from a common seed, draws the values and the shares
+/// of all parties, and keeps only its own. All parties must request the same amounts
+/// in the same order, which holds as long as the protocols are run symmetrically.
+/// The seed is known to every party, so this is for testing and benchmarking only.
+template <size_t K>
+class Semi2kDealer{
+private:
+    std::mt19937_64 prg;
+    playerid_t id;
+    size_t n_players;
+
+public:
+    Semi2kDealer()                                  = delete;
+    Semi2kDealer(unsigned long seed, playerid_t id, size_t n_players);
+
+    template <size_t KK>
+    Semi2kSharing<KK> random();
+
+    /// @brief my additive share over Z_2^KK of a dealer value
+    template <size_t KK>
+    Semi2kSharing<KK> share(const Semi2kSharing<KK>& value);
+
+    /// @brief my additive share of a value known to owner only, the others draw random shares
+    template <size_t KK>
+    Semi2kSharing<KK> share_from(playerid_t owner, const Semi2kSharing<KK>& value);
+
+    /// @brief my XOR share of a dealer value
+    template <size_t KK>
+    Semi2kSharing<KK> share_xor(const Semi2kSharing<KK>& value);
+
+    std::vector<EdaBit<K>> edabits(size_t n, size_t bits = K);
+    std::vector<DaBit<K>> dabits(size_t n);
+
+    /// @brief XOR-shared word triples with c = a & b
+    std::vector<BeaverTriple<K>> and_triples(size_t n);
+
+    /// @brief additive beaver triples over Z_2^K
+    std::vector<BeaverTriple<K>> triples(size_t n);
+
+    std::vector<DcfMsbKey<K>> dcf_msb_keys(size_t n);
+
+    /// @brief v is drawn by the dealer, A * v blockwise by the owners of a
+    PlainMatrixTriple<K> plain_matrix_triple(const PlainMatrix<K>& a);
+};
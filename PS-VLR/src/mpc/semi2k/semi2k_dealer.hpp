@@ -0,0 +1,149 @@
+#pragma once
+
+#include "semi2k_dealer.h"
+
+template <size_t K>
+Semi2kDealer<K>::Semi2kDealer(unsigned long seed, playerid_t id, size_t n_players): prg(seed), id(id), n_players(n_players){}
+
+template <size_t K>
+template <size_t KK>
+Semi2kSharing<KK> Semi2kDealer<K>::random(){
+    if constexpr (KK <= 64){
+        return Semi2kSharing<KK>(typename UnsignedZ2<KK>::value_type(prg()));
+    }
+    else{
+        Semi2kSharing<KK> ret(0);
+        for(size_t i = 0; i < KK; i += 32){
+            ret = (ret << 32) ^ Semi2kSharing<KK>(long(prg() & 0xffffffffUL));
+        }
+        return ret;
+    }
+}
+
+template <size_t K>
+template <size_t KK>
+Semi2kSharing<KK> Semi2kDealer<K>::share(const Semi2kSharing<KK>& value){
+    // parties 1..n-1 draw random shares, party 0 gets the rest
+    Semi2kSharing<KK> rest(value), mine(0);
+    for(size_t p = 1; p != n_players; ++p){
+        auto s = random<KK>();
+        rest -= s;
+        if(p == id) mine = s;
+    }
+    return id == 0 ? rest : mine;
+}
+
+template <size_t K>
+template <size_t KK>
+Semi2kSharing<KK> Semi2kDealer<K>::share_from(playerid_t owner, const Semi2kSharing<KK>& value){
+    Semi2kSharing<KK> rest(value), mine(0);
+    for(size_t p = 0; p != n_players; ++p){
+        if(p == owner) continue;
+        auto s = random<KK>();
+        rest -= s;
+        if(p == id) mine = s;
+    }
+    return id == owner ? rest : mine;
+}
+
+template <size_t K>
+template <size_t KK>
+Semi2kSharing<KK> Semi2kDealer<K>::share_xor(const Semi2kSharing<KK>& value){
+    Semi2kSharing<KK> rest(value), mine(0);
+    for(size_t p = 1; p != n_players; ++p){
+        auto s = random<KK>();
+        rest ^= s;
+        if(p == id) mine = s;
+    }
+    return id == 0 ? rest : mine;
+}
+
+template <size_t K>
+std::vector<EdaBit<K>> Semi2kDealer<K>::edabits(size_t n, size_t bits){
+    std::vector<EdaBit<K>> ret(n);
+    for(auto& e: ret){
+        Semi2kSharing<K> r = random<K>();
+        if(bits < K) r = Semi2kSharing<K>((r << (K - bits)) >> (K - bits));
+        e.r = share(r);
+        e.bits = share_xor(r);
+    }
+    return ret;
+}
+
+template <size_t K>
+std::vector<DaBit<K>> Semi2kDealer<K>::dabits(size_t n){
+    std::vector<DaBit<K>> ret(n);
+    for(auto& d: ret){
+        bool b = prg() & 1;
+        d.arith = share(Semi2kSharing<K>(long(b)));
+        d.bit = share(Semi2kSharing<1>(b));
+    }
+    return ret;
+}
+
+template <size_t K>
+std::vector<BeaverTriple<K>> Semi2kDealer<K>::and_triples(size_t n){
+    std::vector<BeaverTriple<K>> ret;
+    ret.reserve(n);
+    for(size_t i = 0; i != n; ++i){
+        auto a = random<K>(), b = random<K>();
+        auto c = Semi2kSharing<K>(a & b);
+        auto sa = share_xor(a);
+        auto sb = share_xor(b);
+        ret.emplace_back(sa, sb, share_xor(c));
+    }
+    return ret;
+}
+
+template <size_t K>
+std::vector<BeaverTriple<K>> Semi2kDealer<K>::triples(size_t n){
+    std::vector<BeaverTriple<K>> ret;
+    ret.reserve(n);
+    for(size_t i = 0; i != n; ++i){
+        auto a = random<K>(), b = random<K>();
+        auto c = Semi2kSharing<K>(a * b);
+        auto sa = share(a);
+        auto sb = share(b);
+        ret.emplace_back(sa, sb, share(c));
+    }
+    return ret;
+}
+
+template <size_t K>
+std::vector<DcfMsbKey<K>> Semi2kDealer<K>::dcf_msb_keys(size_t n){
+    std::vector<DcfMsbKey<K>> ret(n);
+    for(auto& k: ret){
+        auto r = random<K>();
+        bool r_high = r.bit(K - 1);
+        auto r_low = Semi2kSharing<K>((r << 1) >> 1);
+        Block seed_0{prg(), prg()}, seed_1{prg(), prg()};
+        k.r = share(r);
+        k.gamma = share(Semi2kSharing<K>(long(r_high)));
+        if(id <= 1){
+            auto keys = dcf_gen<K>(r_low, K - 1, Semi2kSharing<K>(long(r_high ? -1 : 1)), seed_0, seed_1);
+            k.key = id == 0 ? std::move(keys.first) : std::move(keys.second);
+        }
+    }
+    return ret;
+}
+
+template <size_t K>
+PlainMatrixTriple<K> Semi2kDealer<K>::plain_matrix_triple(const PlainMatrix<K>& a){
+    PlainMatrixTriple<K> ret;
+    std::vector<Semi2kSharing<K>> v(a.cols);
+    ret.v.resize(a.cols);
+    for(size_t j = 0; j != a.cols; ++j){
+        v[j] = random<K>();
+        ret.v[j] = share(v[j]);
+    }
+    // every block is shared by its owner, the other parties only draw the PRG
+    ret.av.assign(a.rows, Semi2kSharing<K>(0));
+    std::vector<Semi2kSharing<K>> av(a.rows, Semi2kSharing<K>(0));
+    a.mult_local(id, v, av);
+    for(const auto& b: a.blocks){
+        for(size_t i = 0; i != b.rows; ++i){
+            ret.av[b.row + i] += share_from(b.owner, av[b.row + i]);
+        }
+    }
+    return ret;
+}
@@ -1,4 +1,195 @@
 #pragma once
 
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
 #include "semi2k_sharing.h"
+#include "../../tools/expr_template.h"
+#include "../../tools/thread_pool.h"
+
+/************************ share vector expressions ************************/
+
+// a + b, a - b, -a and, for Semi2kSharing only, a * b of share vectors and single
+// shares build expressions evaluated element by element by evaluate or assign, so
+// p_b_v * u + p_a_u * v + uv takes one pass and no temporary vector
+// the operations are local: a * b is only meaningful if a or b is public
+// an expression references its vector operands, evaluate it in the same statement
+
+template <size_t K>
+struct ExprTraits<Semi2kSharing<K>>
+{
+    static constexpr auto expr_type = EnumExprType::scalar;
+    using ref_type = Semi2kSharing<K>; // save value for scalar
+};
+
+template <size_t K>
+struct ExprTraits<std::vector<Semi2kSharing<K>>>
+{
+    static constexpr auto expr_type = EnumExprType::array;
+    using ref_type = std::vector<Semi2kSharing<K>> const &; // save reference for array
+};
+
+// element type of a share vector expression, void if it mixes element types or is none
+template <typename T>
+struct ShareExprElement { using type = void; };
+
+template <size_t K>
+struct ShareExprElement<Semi2kSharing<K>> { using type = Semi2kSharing<K>; };
+
+template <typename T>
+struct ShareExprElement<std::vector<T>> { using type = typename ShareExprElement<T>::type; };
+
+template <typename Op, typename Operand>
+struct ShareExprElement<UnaryExpression<Op, Operand>>
+{
+    using type = typename ShareExprElement<std::remove_cvref_t<Operand>>::type;
+};
+
+template <typename Op, typename Lhs, typename Rhs>
+struct ShareExprElement<BinaryExpression<Op, Lhs, Rhs>>
+{
+    using lhs_type = typename ShareExprElement<std::remove_cvref_t<Lhs>>::type;
+    using rhs_type = typename ShareExprElement<std::remove_cvref_t<Rhs>>::type;
+    using type = std::conditional_t<std::is_same_v<lhs_type, rhs_type>, lhs_type, void>;
+};
+
+template <typename T>
+using share_expr_element_t = typename ShareExprElement<T>::type;
+
+template <typename T>
+concept ConceptShareExpr =
+    ConceptExpr<T> && !std::is_void_v<share_expr_element_t<T>>;
+
+template <typename T>
+struct IsSemi2kSharing : std::false_type {};
+
+template <size_t K>
+struct IsSemi2kSharing<Semi2kSharing<K>> : std::true_type {};
+
+// products only for additive shares, a fixed-point product needs a truncation
+template <typename T>
+concept ConceptSemi2kExpr =
+    ConceptShareExpr<T> && IsSemi2kSharing<share_expr_element_t<T>>::value;
+
+__define_constrained_unary_operator_expression_template__ (-, std::negate<>,     ConceptShareExpr);
+__define_constrained_binary_operator_expression_template__(+, std::plus<>,       ConceptShareExpr);
+__define_constrained_binary_operator_expression_template__(-, std::minus<>,      ConceptShareExpr);
+__define_constrained_binary_operator_expression_template__(*, std::multiplies<>, ConceptSemi2kExpr);
+
+namespace detail
+{
+
+template <typename T>
+requires (ExprTraits<T>::expr_type == EnumExprType::scalar)
+T const &share_element(T const &scalar, std::size_t)
+{
+    return scalar;
+}
+
+template <typename T>
+T const &share_element(std::vector<T> const &array, std::size_t pos)
+{
+    return array[pos];
+}
+
+// x op= y, cheaper than x = x op y for multi-limb rings
+template <typename Operation>
+struct ShareCompoundAssign;
+
+template <>
+struct ShareCompoundAssign<std::plus<>>
+{
+    template <typename X, typename Y>
+    static void apply(X &x, Y const &y) { x += y; }
+};
+
+template <>
+struct ShareCompoundAssign<std::minus<>>
+{
+    template <typename X, typename Y>
+    static void apply(X &x, Y const &y) { x -= y; }
+};
+
+template <>
+struct ShareCompoundAssign<std::multiplies<>>
+{
+    template <typename X, typename Y>
+    static void apply(X &x, Y const &y) { x *= y; }
+};
+
+template <typename Operation, typename Operand>
+auto share_element(UnaryExpression<Operation, Operand> const &expr, std::size_t pos)
+{
+    using ElementType = share_expr_element_t<UnaryExpression<Operation, Operand>>;
+    static constexpr Operation op;
+    return ElementType(op(share_element(expr.operand, pos)));
+}
+
+template <typename Operation, typename LhsOperand, typename RhsOperand>
+auto share_element(BinaryExpression<Operation, LhsOperand, RhsOperand> const &expr, std::size_t pos)
+{
+    using ElementType = share_expr_element_t<BinaryExpression<Operation, LhsOperand, RhsOperand>>;
+    ElementType x = share_element(expr.lhs, pos);
+    ShareCompoundAssign<Operation>::apply(x, share_element(expr.rhs, pos));
+    return x;
+}
+
+// 0 for a scalar, which fits any size
+template <typename T>
+requires (ExprTraits<T>::expr_type == EnumExprType::scalar)
+std::size_t share_size(T const &)
+{
+    return 0;
+}
+
+template <typename T>
+std::size_t share_size(std::vector<T> const &array)
+{
+    return array.size();
+}
+
+template <typename Operation, typename Operand>
+std::size_t share_size(UnaryExpression<Operation, Operand> const &expr)
+{
+    return share_size(expr.operand);
+}
+
+template <typename Operation, typename LhsOperand, typename RhsOperand>
+std::size_t share_size(BinaryExpression<Operation, LhsOperand, RhsOperand> const &expr)
+{
+    auto sizel = share_size(expr.lhs);
+    auto sizer = share_size(expr.rhs);
+    if (sizel != 0 && sizer != 0 && sizel != sizer)
+        throw std::invalid_argument("share expression: operand size mismatch");
+    return std::max(sizel, sizer);
+}
+
+} // namespace detail
+
+// out = expr in one pass, out may be an operand of expr
+// with a pool, blocks of the elements are evaluated in parallel
+template <ConceptExprCompound ExprType>
+requires ConceptShareExpr<ExprType>
+void assign(std::vector<share_expr_element_t<ExprType>> &out, ExprType const &expr, ThreadPool *pool = nullptr)
+{
+    auto size = detail::share_size(expr);
+    if (size == 0) throw std::invalid_argument("share expression: no vector operand");
+
+    out.resize(size);
+    parallel_for(pool, size, 1 << 14, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i != end; ++i) {
+            out[i] = detail::share_element(expr, i);
+        }
+    });
+}
 
+template <ConceptExprCompound ExprType>
+requires ConceptShareExpr<ExprType>
+std::vector<share_expr_element_t<ExprType>> evaluate(ExprType const &expr, ThreadPool *pool = nullptr)
+{
+    std::vector<share_expr_element_t<ExprType>> ret;
+    assign(ret, expr, pool);
+    return ret;
+}
@@ -17,6 +17,38 @@ boost::asio::awaitable<void> co_delay(std::chrono::steady_clock::duration delay)
     co_await timer.async_wait(boost::asio::use_awaitable);
 }
 
+/************************ chunk queue ************************/
+
+void ChunkQueue::push(MessageChunk &&chunk)
+{
+    {
+        std::lock_guard lock(_mutex);
+        _chunks.push_back(std::move(chunk));
+    }
+    _ready.notify_one();
+}
+
+void ChunkQueue::fail(std::exception_ptr error)
+{
+    {
+        std::lock_guard lock(_mutex);
+        if (!_error)
+            _error = error;
+    }
+    _ready.notify_one();
+}
+
+MessageChunk ChunkQueue::pop()
+{
+    std::unique_lock lock(_mutex);
+    _ready.wait(lock, [this] { return !_chunks.empty() || _error; });
+    if (_chunks.empty())
+        std::rethrow_exception(_error);
+    auto chunk = std::move(_chunks.front());
+    _chunks.pop_front();
+    return chunk;
+}
+
 /************************ token bucket ************************/
 
 void TokenBucket::set(BitrateType rate, size_type capacity)
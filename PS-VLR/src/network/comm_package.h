@@ -2,6 +2,10 @@
 
 #include <future>
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <variant>
 #include <cstdio>
 
@@ -13,6 +17,7 @@
 
 #include "statistics.h"
 #include "bitrate.hpp"
+#include "playerid.h"
 #include "socket_package.h"
 
 #include "../tools/byte_vector.h"
@@ -111,6 +116,7 @@ public:
 
     void set_delay (DurationType delay);
     void set_bucket(BitrateType rate, size_type capacity);
+    void set_strategy(Strategy strategy);
 
     DurationType get_delay()           const;
     BitrateType  get_bucket_bitrate()  const;
@@ -123,6 +129,31 @@ public:
 
 };
 
+// a piece of a message, the pieces of one message arrive in order
+struct MessageChunk {
+    playerid_t from;
+    ByteVector bytes;
+    bool       last;    // the final piece of the message, an empty message has one empty piece
+};
+
+// pieces of the messages from several peers
+// filled by the io threads, drained by the thread waiting on the messages
+class ChunkQueue {
+protected:
+    std::mutex               _mutex;
+    std::condition_variable  _ready;
+    std::deque<MessageChunk> _chunks;
+    std::exception_ptr       _error;
+
+public:
+    void push(MessageChunk&& chunk);
+    void fail(std::exception_ptr error);
+
+    // blocks until a piece is available, rethrows the error of a failed receive
+    MessageChunk pop();
+};
+
+
 template <typename SocketType>
 class Recver {
 protected:
@@ -146,6 +177,9 @@ public:
     DurationType get_elapsed_recv() const { return _timer.elapsed(); }
 
     std::future<ByteVector> recv(size_type size_hint);
+
+    // push the next message to queue in pieces of chunk_bytes as they arrive
+    void recv_chunked(playerid_t from, size_type chunk_bytes, std::shared_ptr<ChunkQueue> queue);
 };
 
 
@@ -187,6 +221,11 @@ public:
             _senders.at(i).set_bucket(rate, capacity);
     }
 
+    void set_strategy(mplayerid_t tos, Strategy strategy) {
+        for(auto i: tos)
+            _senders.at(i).set_strategy(strategy);
+    }
+
     size_type get_n_players() const { return _senders.size(); }
 
     std::future<void> send_copy(playerid_t to, ByteVector const& message) {
@@ -197,6 +236,10 @@ public:
         return _recvers.at(from).recv(size_hint);
     }
 
+    void recv_chunked(playerid_t from, size_type chunk_bytes, std::shared_ptr<ChunkQueue> queue) {
+        _recvers.at(from).recv_chunked(from, chunk_bytes, std::move(queue));
+    }
+
     Statistics get_statistics() const;
 
 };
@@ -78,6 +78,41 @@ boost::asio::awaitable<ByteVector> co_recv(
 }
 
 
+// receive a message piece by piece
+// every piece is pushed to queue as soon as chunk_bytes of it (or the rest) have arrived
+template <typename SocketType>
+boost::asio::awaitable<std::size_t> co_recv_chunked(
+    SocketType &socket,
+    playerid_t from,
+    std::size_t chunk_bytes,
+    ChunkQueue &queue)
+{
+    using boost::asio::async_read;
+    using boost::asio::buffer;
+    using boost::asio::use_awaitable;
+
+    ByteVector::size_type msg_size;
+
+    co_await async_read(
+        socket,
+        buffer(&msg_size, sizeof(msg_size)),
+        use_awaitable);
+
+    std::size_t received = 0;
+    do {
+        ByteVector chunk(std::min(chunk_bytes, msg_size - received));
+        co_await async_read(
+            socket,
+            buffer(chunk.data(), chunk.size()),
+            use_awaitable);
+        received += chunk.size();
+        queue.push({from, std::move(chunk), received == msg_size});
+    } while (received < msg_size);
+
+    co_return msg_size;
+}
+
+
 boost::asio::awaitable<void> co_delay(std::chrono::steady_clock::duration delay);
 
 // send std::size_t
@@ -274,7 +309,8 @@ boost::asio::awaitable<void> co_send_byte_vector_copy(
     SocketType &socket,
     ByteVector const &message,
     std::chrono::steady_clock::duration delay,
-    TokenBucket &bucket)
+    TokenBucket &bucket,
+    Strategy const &strategy)
 {
     using boost::asio::async_write;
     using boost::asio::use_awaitable;
@@ -287,32 +323,27 @@ boost::asio::awaitable<void> co_send_byte_vector_copy(
     if ( bucket.bitrate() == decltype(bucket.bitrate())::unlimited() )
     {
         co_await co_send_buffer_unlimited(socket, buffer);
-    }
-    else
-    {
-        co_await co_send_buffer_dynamic_packet_size(socket, buffer, bucket);
+        co_return;
     }
 
-    // switch (strategy.type) {
-    //     case Strategy::Type::unlimited: {
-    //         co_await co_send_buffer_unlimited(socket, buffer);
-    //         break;
-    //     }
-    //     case Strategy::Type::fixed_interval: {
-    //         auto fixed_interval = std::get<Strategy::DurationType>(strategy.data);
-    //         co_await co_send_buffer_fixed_interval(socket, buffer, bucket, fixed_interval);
-    //         break;
-    //     }
-    //     case Strategy::Type::fixed_packet_size: {
-    //         auto fixed_packet_size = std::get<Strategy::DatasizeType>(strategy.data);
-    //         co_await co_send_buffer_fixed_packet_size(socket, buffer, bucket, fixed_packet_size);
-    //         break;
-    //     }
-    //     case Strategy::Type::dynamic_packet_size: {
-            // co_await co_send_buffer_dynamic_packet_size(socket, buffer, bucket);
-    //         break;
-    //     }
-    // }
+    // a limited bucket without a strategy sends dynamic packet sizes
+    switch (strategy.type) {
+        case Strategy::Type::fixed_interval: {
+            auto fixed_interval = std::get<Strategy::DurationType>(strategy.data);
+            co_await co_send_buffer_fixed_interval(socket, buffer, bucket, fixed_interval);
+            break;
+        }
+        case Strategy::Type::fixed_packet_size: {
+            auto fixed_packet_size = std::get<Strategy::DatasizeType>(strategy.data);
+            co_await co_send_buffer_fixed_packet_size(socket, buffer, bucket, fixed_packet_size);
+            break;
+        }
+        case Strategy::Type::unlimited:
+        case Strategy::Type::dynamic_packet_size: {
+            co_await co_send_buffer_dynamic_packet_size(socket, buffer, bucket);
+            break;
+        }
+    }
 }
 
 
@@ -330,6 +361,12 @@ void Sender<SocketType>::set_bucket(BitrateType rate, size_type capacity)
     _bucket.set(rate, capacity);
 }
 
+template <typename SocketType>
+void Sender<SocketType>::set_strategy(Strategy strategy)
+{
+    _strategy = strategy;
+}
+
 template <typename SocketType>
 Sender<SocketType>::DurationType Sender<SocketType>::get_delay() const
 {
@@ -359,7 +396,7 @@ std::future<void> Sender<SocketType>::send_copy(ByteVector const &message)
     auto future_send = promise_send.get_future();
 
     auto task_send = detail::co_send_byte_vector_copy(
-        _socket, message, _delay, _bucket);
+        _socket, message, _delay, _bucket, _strategy);
 
     auto callback = [this, &message, promise_send = std::move(promise_send)](std::exception_ptr e) mutable {
         this->_timer.stop();
@@ -405,6 +442,27 @@ std::future<ByteVector> Recver<SocketType>::recv(size_type size_hint)
     return future_recv;
 }
 
+template <typename SocketType>
+void Recver<SocketType>::recv_chunked(playerid_t from, size_type chunk_bytes, std::shared_ptr<ChunkQueue> queue)
+{
+    using boost::asio::co_spawn;
+    auto executor = _socket.get_executor();
+
+    if (chunk_bytes == 0)
+        throw std::invalid_argument("chunk size is zero");
+
+    _timer.start();
+    co_spawn(
+        executor, detail::co_recv_chunked(_socket, from, chunk_bytes, *queue),
+        [this, queue](std::exception_ptr e, std::size_t msg_size) {
+            this->_timer.stop();
+            if (e)
+                queue->fail(e);
+            else
+                this->_bytes_recv += msg_size;
+        });
+}
+
 template <typename SocketType>
 Statistics CommPackage<SocketType>::get_statistics() const
 {
@@ -0,0 +1,115 @@
+#include "link_profile.h"
+#include "bitrate.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/format.h>
+
+namespace network {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// one-way latency and bandwidth of the named topologies, LAN latencies are half a typical ping
+const std::vector<std::pair<std::string, LinkProfile>>& presets()
+{
+    static const std::vector<std::pair<std::string, LinkProfile>> table = {
+        {"none",          LinkProfile{}},
+        {"LAN-10G",       LinkProfile{50us,  GigaBitsPerSecond(10),   0, LinkProfile::Strategy()}},
+        {"LAN-1G",        LinkProfile{100us, GigaBitsPerSecond(1),    0, LinkProfile::Strategy()}},
+        {"WAN-1G-10ms",   LinkProfile{10ms,  GigaBitsPerSecond(1),    0, LinkProfile::Strategy()}},
+        {"WAN-100M-50ms", LinkProfile{50ms,  GigaBitsPerSecond(0.1),  0, LinkProfile::Strategy()}},
+        {"WAN-10M-100ms", LinkProfile{100ms, GigaBitsPerSecond(0.01), 0, LinkProfile::Strategy()}},
+    };
+    return table;
+}
+
+} // namespace
+
+bool LinkProfile::is_shaped() const
+{
+    return delay != DurationType::zero() || bandwidth != BitrateType::unlimited();
+}
+
+LinkProfile::size_type LinkProfile::bucket_capacity() const
+{
+    if (capacity != 0 || bandwidth == BitrateType::unlimited())
+        return capacity;
+    return std::max<size_type>(Bytes(std::chrono::duration_cast<std::chrono::nanoseconds>(4ms) * bandwidth).count(), 1 << 16);
+}
+
+void LinkProfile::validate() const
+{
+    if (delay < DurationType::zero())
+        throw std::invalid_argument("link delay is negative");
+    if (bandwidth == BitrateType::unlimited())
+        return;
+    if (!(bandwidth > BitrateType::zero()))
+        throw std::invalid_argument("link bandwidth must be positive");
+
+    switch (strategy.type) {
+        case Strategy::Type::fixed_packet_size:
+            // TokenBucket::require waits for a whole packet
+            if (std::get<Strategy::DatasizeType>(strategy.data).count() == 0)
+                throw std::invalid_argument("link packet size is zero");
+            if (std::get<Strategy::DatasizeType>(strategy.data).count() > bucket_capacity())
+                throw std::invalid_argument("link packet size exceeds the bucket capacity");
+            break;
+        case Strategy::Type::fixed_interval:
+            if (std::get<Strategy::DurationType>(strategy.data) <= DurationType::zero())
+                throw std::invalid_argument("link send interval must be positive");
+            break;
+        default:
+            if (Bytes(std::chrono::duration_cast<std::chrono::nanoseconds>(2ms) * bandwidth).count() >= bucket_capacity())
+                throw std::invalid_argument("link bucket capacity is below 2ms of traffic");
+            break;
+    }
+}
+
+std::string LinkProfile::to_string() const
+{
+    if (!is_shaped())
+        return "unshaped";
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(delay).count();
+    std::string ret = fmt::format("delay {}us", us);
+    if (bandwidth != BitrateType::unlimited()) {
+        ret += fmt::format(", {} Mbps, bucket {} B", static_cast<double>(MegaBitsPerSecond(bandwidth).count()), bucket_capacity());
+        switch (strategy.type) {
+            case Strategy::Type::fixed_packet_size:
+                ret += fmt::format(", packets of {} B", std::get<Strategy::DatasizeType>(strategy.data).count());
+                break;
+            case Strategy::Type::fixed_interval:
+                ret += fmt::format(", every {}us", std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::get<Strategy::DurationType>(strategy.data)).count());
+                break;
+            default:
+                break;
+        }
+    }
+    return ret;
+}
+
+LinkProfile LinkProfile::preset(std::string const& name)
+{
+    for (auto const& [key, profile] : presets()) {
+        if (key == name)
+            return profile;
+    }
+    std::string names;
+    for (auto const& key : preset_names())
+        names += (names.empty() ? "" : ", ") + key;
+    throw std::invalid_argument("unknown network profile " + name + ", choose one of " + names);
+}
+
+std::vector<std::string> LinkProfile::preset_names()
+{
+    std::vector<std::string> ret;
+    for (auto const& [key, profile] : presets())
+        ret.push_back(key);
+    return ret;
+}
+
+} // namespace network
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "bitrate.h"
+#include "comm_package.h"
+
+namespace network {
+
+// emulated conditions of one outgoing link, applied by SocketMultiPartyPlayer::set_link
+struct LinkProfile
+{
+    using size_type    = std::size_t;
+    using DurationType = std::chrono::steady_clock::duration;
+    using BitrateType  = detail::TokenBucket::BitrateType;
+    using Strategy     = detail::Strategy;
+
+    DurationType delay     {0};                        // one-way latency added to every message
+    BitrateType  bandwidth = BitrateType::unlimited(); // token generation rate
+    size_type    capacity  = 0;                        // token bucket bytes, 0 for bucket_capacity()'s default
+    Strategy     strategy;                             // how a limited link splits messages, dynamic by default
+
+    bool is_shaped() const;
+
+    // capacity, or 4ms of traffic and at least one 64 KiB TCP window if it is 0:
+    // the dynamic strategy sends packets of at least 2ms of traffic
+    size_type bucket_capacity() const;
+
+    // throws std::invalid_argument if a send over the link could never complete
+    void validate() const;
+
+    std::string to_string() const;
+
+    // none, LAN-10G, LAN-1G, WAN-1G-10ms, WAN-100M-50ms, WAN-10M-100ms
+    static LinkProfile preset(std::string const& name);
+    static std::vector<std::string> preset_names();
+};
+
+} // namespace network
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace network {
+
+namespace detail {
+
+// unbounded single-producer single-consumer queue
+// a dummy node separates producer and consumer, so push and pop never
+// touch the same node and no lock is needed
+// values are moved in and moved out, never copied
+template <typename T>
+class LocalChannel
+{
+  public:
+    using size_type  = std::size_t;
+    using value_type = T;
+
+  protected:
+    struct Node {
+        T                  value;
+        std::atomic<Node*> next{nullptr};
+    };
+
+    Node*                  _head;    // dummy node, owned by consumer
+    Node*                  _tail;    // last node, owned by producer
+    std::atomic<size_type> _size;    // number of nodes after dummy
+
+  public:
+    LocalChannel(): _head(new Node), _tail(_head), _size(0) {}
+
+    ~LocalChannel()
+    {
+        while (_head) {
+            Node* next = _head->next.load(std::memory_order_relaxed);
+            delete _head;
+            _head = next;
+        }
+    }
+
+    LocalChannel(LocalChannel&&)                 = delete;
+    LocalChannel(LocalChannel const&)            = delete;
+    LocalChannel& operator=(LocalChannel&&)      = delete;
+    LocalChannel& operator=(LocalChannel const&) = delete;
+
+    // producer side, never blocks
+    void push(T&& value)
+    {
+        Node* node = new Node{std::move(value)};
+        _tail->next.store(node, std::memory_order_release);
+        _tail = node;
+        _size.fetch_add(1, std::memory_order_release);
+        _size.notify_one();
+    }
+
+    // consumer side, blocks until a value is available
+    T pop()
+    {
+        _size.wait(0, std::memory_order_acquire);
+
+        Node* next = _head->next.load(std::memory_order_acquire);
+        T value = std::move(next->value);
+        delete _head;
+        _head = next;
+        _size.fetch_sub(1, std::memory_order_release);
+        return value;
+    }
+
+    size_type size() const { return _size.load(std::memory_order_acquire); }
+    bool     empty() const { return size() == 0; }
+};
+
+} // namespace detail
+
+} // namespace network
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <iostream>
 #include <map>
 #include <future>
@@ -9,7 +10,10 @@
 #include <boost/asio/use_awaitable.hpp>
 #include <boost/asio/read.hpp>
 #include <boost/asio/write.hpp>
+#include <boost/asio/redirect_error.hpp>
 #include <boost/asio/co_spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
 #include <boost/asio/ssl/stream.hpp>
 #include <boost/asio/ssl/context.hpp>
 #include <boost/asio/ssl/host_name_verification.hpp>
@@ -23,9 +27,32 @@ namespace detail {
 static auto &get_tcp_socket(TCPSocket &s) { return s; }
 static auto &get_tcp_socket(SSLSocket &s) { return s.lowest_layer(); }
 
-// note:
-// { co_await socket.async_connect(...); } does not fail, but blocks
-// when connection is refused by remote
+// connect to endpoint, retrying while it refuses: the remote opens its acceptor
+// only once its own mp_connect runs, which may be a little later
+// the retries end well within the connect timeout of the player
+template <typename TCPSocketType>
+boost::asio::awaitable<void> co_connect_retry(
+    TCPSocketType &socket,
+    boost::asio::ip::tcp::endpoint const &endpoint)
+{
+    using boost::asio::use_awaitable;
+
+    constexpr int attempts = 80;
+    constexpr auto backoff = std::chrono::milliseconds(25);
+    for (int attempt = 1;; ++attempt)
+    {
+        boost::system::error_code ec;
+        co_await socket.async_connect(endpoint, boost::asio::redirect_error(use_awaitable, ec));
+        if (!ec)
+            co_return;
+        if (ec != boost::asio::error::connection_refused || attempt == attempts)
+            throw boost::system::system_error(ec);
+        socket.close();
+        boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor, backoff);
+        co_await timer.async_wait(use_awaitable);
+    }
+}
+
 // connect socket_send to remote endpoint
 // then accept socket_recv from remote
 template <typename SocketType>
@@ -44,11 +71,11 @@ boost::asio::awaitable<void> co_connect(
     if (order)
     {
         co_await acceptor.async_accept(tcp_socket_recv, use_awaitable);
-        co_await tcp_socket_send.async_connect(endpoint, use_awaitable);
+        co_await co_connect_retry(tcp_socket_send, endpoint);
     }
     else
     {
-        co_await tcp_socket_send.async_connect(endpoint, use_awaitable);
+        co_await co_connect_retry(tcp_socket_send, endpoint);
         co_await acceptor.async_accept(tcp_socket_recv, use_awaitable);
     }
 }
@@ -1,11 +1,16 @@
 #include "multi_party_player.hpp"
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace network
 {
 
 /************************ basic tool ************************/
 
-std::vector<std::thread> run_io_context(boost::asio::io_context &ioc, std::size_t n_threads)
+std::vector<std::thread> run_io_context(boost::asio::io_context &ioc, std::size_t n_threads, std::vector<int> const &cpus)
 {
     if (ioc.stopped())
         ioc.restart();
@@ -14,6 +19,18 @@ std::vector<std::thread> run_io_context(boost::asio::io_context &ioc, std::size_
     std::vector<std::thread> worker_threads;
     for (std::size_t i = 0; i < n_threads; ++i) {
         worker_threads.emplace_back([&ioc]() { ioc.run(); });
+#ifdef __linux__
+        if (!cpus.empty()) {
+            int cpu = cpus[i % cpus.size()];
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (pthread_setaffinity_np(worker_threads.back().native_handle(), sizeof(set), &set) != 0) {
+                stop_io_context(ioc, worker_threads);
+                throw std::runtime_error("cannot pin io thread to cpu " + std::to_string(cpu));
+            }
+        }
+#endif
     }
 
     return worker_threads;
@@ -50,62 +67,141 @@ mplayerid_t MultiPartyPlayer::all_but_me() const
 
 void MultiPartyPlayer::send(playerid_t to, ByteVector &&message_send)
 {
-    TimerGuard guard(_timer);
+    TimerGuard guard(_timer, "send", trace::network);
+    PhaseCallGuard call(_phases, false);
+    call.sent(message_send.size());
     impl_send(to, std::move(message_send));
 }
 
 void MultiPartyPlayer::msend(mplayerid_t tos, mByteVector &&messages)
 {
-    TimerGuard guard(_timer);
+    TimerGuard guard(_timer, "msend", trace::network);
+    PhaseCallGuard call(_phases, false);
+    for (auto to : tos)
+        call.sent(messages.at(to).size());
     impl_msend(tos, std::move(messages));
 }
 
 void MultiPartyPlayer::broadcast(ByteVector &&messages)
 {
-    TimerGuard guard(_timer);
+    TimerGuard guard(_timer, "broadcast", trace::network);
+    PhaseCallGuard call(_phases, false);
+    call.sent(messages.size() * (_n_players - 1), _n_players - 1);
     impl_broadcast(std::move(messages));
 }
 
 void MultiPartyPlayer::mbroadcast(mplayerid_t tos, ByteVector &&messages)
 {
-    TimerGuard guard(_timer);
+    TimerGuard guard(_timer, "mbroadcast", trace::network);
+    PhaseCallGuard call(_phases, false);
+    call.sent(messages.size() * tos.size(), tos.size());
     impl_mbroadcast(tos, std::move(messages));
 }
 
 ByteVector MultiPartyPlayer::recv(playerid_t from, size_type size_hint)
 {
-    TimerGuard guard(_timer);
-    return impl_recv(from, size_hint);
+    TimerGuard guard(_timer, "recv", trace::network);
+    PhaseCallGuard call(_phases, true);
+    auto message_recv = impl_recv(from, size_hint);
+    call.recved(message_recv.size());
+    return message_recv;
 }
 
 mByteVector MultiPartyPlayer::mrecv(mplayerid_t froms, size_type size_hint)
 {
-    TimerGuard guard(_timer);
-    return impl_mrecv(froms, size_hint);
+    TimerGuard guard(_timer, "mrecv", trace::network);
+    PhaseCallGuard call(_phases, true);
+    auto messages_recv = impl_mrecv(froms, size_hint);
+    for (auto from : froms)
+        call.recved(messages_recv.at(from).size());
+    return messages_recv;
 }
 
 ByteVector MultiPartyPlayer::exchange(playerid_t peer, ByteVector &&message_send)
 {
-    TimerGuard guard(_timer);
-    return impl_exchange(peer, std::move(message_send));
+    TimerGuard guard(_timer, "exchange", trace::network);
+    PhaseCallGuard call(_phases, true);
+    call.sent(message_send.size());
+    auto message_recv = impl_exchange(peer, std::move(message_send));
+    call.recved(message_recv.size());
+    return message_recv;
 }
 
 ByteVector MultiPartyPlayer::pass_around(offset_type offset, ByteVector &&message_send)
 {
-    TimerGuard guard(_timer);
-    return impl_pass_around(offset, std::move(message_send));
+    TimerGuard guard(_timer, "pass_around", trace::network);
+    PhaseCallGuard call(_phases, true);
+    call.sent(message_send.size());
+    auto message_recv = impl_pass_around(offset, std::move(message_send));
+    call.recved(message_recv.size());
+    return message_recv;
 }
 
 mByteVector MultiPartyPlayer::broadcast_recv(ByteVector &&message_send)
 {
-    TimerGuard guard(_timer);
-    return impl_broadcast_recv(std::move(message_send));
+    TimerGuard guard(_timer, "broadcast_recv", trace::network);
+    PhaseCallGuard call(_phases, true);
+    call.sent(message_send.size() * (_n_players - 1), _n_players - 1);
+    auto messages_recv = impl_broadcast_recv(std::move(message_send));
+    for (auto from : all_but_me())
+        call.recved(messages_recv.at(from).size());
+    return messages_recv;
 }
 
 mByteVector MultiPartyPlayer::mbroadcast_recv(mplayerid_t group, ByteVector &&message)
 {
-    TimerGuard guard(_timer);
-    return impl_mbroadcast_recv(group, std::move(message));
+    TimerGuard guard(_timer, "mbroadcast_recv", trace::network);
+    PhaseCallGuard call(_phases, true);
+    call.sent(message.size() * group.size(), group.size());
+    auto messages_recv = impl_mbroadcast_recv(group, std::move(message));
+    for (auto from : group)
+        call.recved(messages_recv.at(from).size());
+    return messages_recv;
+}
+
+void MultiPartyPlayer::mrecv_chunked(mplayerid_t froms, size_type chunk_bytes, ChunkHandler const &on_chunk)
+{
+    TimerGuard guard(_timer, "mrecv_chunked", trace::network);
+    PhaseCallGuard call(_phases, true);
+    auto bytes_recv = impl_mrecv_chunked(froms, chunk_bytes, on_chunk);
+    for (auto from : froms)
+        call.recved(bytes_recv.at(from));
+}
+
+void MultiPartyPlayer::mbroadcast_recv_chunked(mplayerid_t group, ByteVector &&message,
+                                               size_type chunk_bytes, ChunkHandler const &on_chunk)
+{
+    TimerGuard guard(_timer, "mbroadcast_recv_chunked", trace::network);
+    PhaseCallGuard call(_phases, true);
+    call.sent(message.size() * group.size(), group.size());
+    auto bytes_recv = impl_mbroadcast_recv_chunked(group, std::move(message), chunk_bytes, on_chunk);
+    for (auto from : group)
+        call.recved(bytes_recv.at(from));
+}
+
+// the defaults receive whole messages and hand each out as one chunk
+std::vector<MultiPartyPlayer::size_type> MultiPartyPlayer::impl_mrecv_chunked(
+    mplayerid_t froms, size_type /* chunk_bytes */, ChunkHandler const &on_chunk)
+{
+    auto messages_recv = impl_mrecv(froms, 0);
+    std::vector<size_type> bytes_recv(_n_players, 0);
+    for (auto from : froms) {
+        bytes_recv.at(from) = messages_recv.at(from).size();
+        on_chunk(from, std::move(messages_recv.at(from)));
+    }
+    return bytes_recv;
+}
+
+std::vector<MultiPartyPlayer::size_type> MultiPartyPlayer::impl_mbroadcast_recv_chunked(
+    mplayerid_t group, ByteVector &&message, size_type /* chunk_bytes */, ChunkHandler const &on_chunk)
+{
+    auto messages_recv = impl_mbroadcast_recv(group, std::move(message));
+    std::vector<size_type> bytes_recv(_n_players, 0);
+    for (auto from : group) {
+        bytes_recv.at(from) = messages_recv.at(from).size();
+        on_chunk(from, std::move(messages_recv.at(from)));
+    }
+    return bytes_recv;
 }
 
 /************************ socket player ************************/
@@ -153,4 +249,256 @@ SocketPackage<TCPSocket> PlainMultiPartyPlayer::get_empty_sockets()
 
 /************************ local player ************************/
 
+LocalNetwork::LocalNetwork(size_type n_players)
+    : _n_players(n_players)
+{
+    if (n_players < 2 || n_players > mplayerid_t::MAX_NUM_PLAYERS)
+        throw std::invalid_argument("invalid number of local players");
+
+    _channels.reserve(n_players * n_players);
+    for (size_type i = 0; i < n_players * n_players; ++i) {
+        _channels.emplace_back(std::make_unique<ChannelType>());
+    }
+}
+
+LocalNetwork::ChannelType &LocalNetwork::channel(playerid_t from, playerid_t to)
+{
+    if (from >= _n_players || to >= _n_players || from == to)
+        throw std::out_of_range("invalid local channel");
+    return *_channels[from * _n_players + to];
+}
+
+LocalMultiPartyPlayer::LocalMultiPartyPlayer(playerid_t my_pid, LocalNetwork &net)
+    : MultiPartyPlayer(my_pid, net.n_players()),
+      _net(net),
+      _bytes_send(net.n_players(), 0),
+      _bytes_recv(net.n_players(), 0),
+      _elapsed_recv(net.n_players(), Statistics::DurationType(0))
+{
+}
+
+void LocalMultiPartyPlayer::impl_send(playerid_t to, ByteVector &&message)
+{
+    _bytes_send.at(to) += message.size();
+    _net.channel(_my_pid, to).push(std::move(message));
+}
+
+ByteVector LocalMultiPartyPlayer::impl_recv(playerid_t from, size_type size_hint)
+{
+    Timer timer;
+    timer.start();
+    auto message = _net.channel(from, _my_pid).pop();
+    timer.stop();
+
+    _elapsed_recv.at(from) += timer.elapsed();
+    _bytes_recv.at(from) += message.size();
+    return message;
+}
+
+void LocalMultiPartyPlayer::push_all(mplayerid_t tos, ByteVector &&message)
+{
+    auto message_send = std::move(message);
+
+    size_type remaining = tos.size();
+    for (auto to : tos) {
+        if (--remaining == 0) {
+            impl_send(to, std::move(message_send));
+        } else {
+            impl_send(to, ByteVector(message_send.data(), message_send.size()));
+        }
+    }
+}
+
+ByteVector LocalMultiPartyPlayer::impl_exchange(playerid_t peer, ByteVector &&message)
+{
+    impl_send(peer, std::move(message));
+    return impl_recv(peer, 0);
+}
+
+ByteVector LocalMultiPartyPlayer::impl_pass_around(offset_type offset, ByteVector &&message)
+{
+    auto n = static_cast<offset_type>(_n_players);
+    auto me = static_cast<offset_type>(_my_pid);
+    playerid_t to   = ((me + offset) % n + n) % n;
+    playerid_t from = ((me - offset) % n + n) % n;
+
+    impl_send(to, std::move(message));
+    return impl_recv(from, 0);
+}
+
+mByteVector LocalMultiPartyPlayer::impl_broadcast_recv(ByteVector &&message)
+{
+    return impl_mbroadcast_recv(all_but_me(), std::move(message));
+}
+
+void LocalMultiPartyPlayer::impl_broadcast(ByteVector &&message)
+{
+    push_all(all_but_me(), std::move(message));
+}
+
+void LocalMultiPartyPlayer::impl_msend(mplayerid_t tos, mByteVector &&messages)
+{
+    auto messages_send = std::move(messages);
+    for (auto to : tos) {
+        impl_send(to, std::move(messages_send.at(to)));
+    }
+}
+
+mByteVector LocalMultiPartyPlayer::impl_mrecv(mplayerid_t froms, size_type size_hint)
+{
+    mByteVector messages_recv(_n_players);
+    for (auto from : froms) {
+        messages_recv.at(from) = impl_recv(from, size_hint);
+    }
+    return messages_recv;
+}
+
+void LocalMultiPartyPlayer::impl_mbroadcast(mplayerid_t tos, ByteVector &&message)
+{
+    push_all(tos, std::move(message));
+}
+
+mByteVector LocalMultiPartyPlayer::impl_mbroadcast_recv(mplayerid_t group, ByteVector &&message)
+{
+    push_all(group, std::move(message));
+    return impl_mrecv(group, 0);
+}
+
+Statistics LocalMultiPartyPlayer::get_statistics() const
+{
+    Statistics stat;
+    stat.bytes_send   = _bytes_send;
+    stat.bytes_recv   = _bytes_recv;
+    stat.elapsed_send = std::vector<Statistics::DurationType>(_n_players, Statistics::DurationType(0));
+    stat.elapsed_recv = _elapsed_recv;
+    stat.elapsed_total = MultiPartyPlayer::_timer.total_elapsed();
+    return stat;
+}
+
+void run_local_parties(std::size_t n_players,
+                       std::function<void(LocalMultiPartyPlayer &)> const &fn)
+{
+    LocalNetwork net(n_players);
+
+    std::vector<std::exception_ptr> errors(n_players);
+    std::vector<std::thread> threads;
+    for (playerid_t pid = 0; pid < n_players; ++pid) {
+        threads.emplace_back([&net, &fn, &errors, pid]() {
+            try {
+                LocalMultiPartyPlayer player(pid, net);
+                fn(player);
+            } catch (...) {
+                errors[pid] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto &t : threads)
+        t.join();
+
+    for (auto &e : errors) {
+        if (e)
+            std::rethrow_exception(e);
+    }
+}
+
+/************************ symbolic player ************************/
+
+SymbolicMultiPartyPlayer::SymbolicMultiPartyPlayer(playerid_t my_pid, size_type n_players)
+    : MultiPartyPlayer(my_pid, n_players),
+      _bytes_send(n_players, 0),
+      _bytes_recv(n_players, 0),
+      _last_send(n_players),
+      _last_to(my_pid)
+{
+}
+
+void SymbolicMultiPartyPlayer::store(playerid_t to, ByteVector const &message)
+{
+    _bytes_send.at(to) += message.size();
+    _last_send.at(to) = ByteVector(message.data(), message.size());
+    _last_to = to;
+}
+
+void SymbolicMultiPartyPlayer::impl_send(playerid_t to, ByteVector &&message)
+{
+    _bytes_send.at(to) += message.size();
+    _last_send.at(to) = std::move(message);
+    _last_to = to;
+}
+
+ByteVector SymbolicMultiPartyPlayer::impl_recv(playerid_t from, size_type size_hint)
+{
+    auto const &mirror = _last_send.at(from).empty() ? _last_send.at(_last_to) : _last_send.at(from);
+    _bytes_recv.at(from) += mirror.size();
+    return ByteVector(mirror.data(), mirror.size());
+}
+
+ByteVector SymbolicMultiPartyPlayer::impl_exchange(playerid_t peer, ByteVector &&message)
+{
+    impl_send(peer, std::move(message));
+    return impl_recv(peer, 0);
+}
+
+ByteVector SymbolicMultiPartyPlayer::impl_pass_around(offset_type offset, ByteVector &&message)
+{
+    auto n = static_cast<offset_type>(_n_players);
+    auto me = static_cast<offset_type>(_my_pid);
+    playerid_t to   = ((me + offset) % n + n) % n;
+    playerid_t from = ((me - offset) % n + n) % n;
+
+    impl_send(to, std::move(message));
+    return impl_recv(from, 0);
+}
+
+mByteVector SymbolicMultiPartyPlayer::impl_broadcast_recv(ByteVector &&message)
+{
+    return impl_mbroadcast_recv(all_but_me(), std::move(message));
+}
+
+void SymbolicMultiPartyPlayer::impl_broadcast(ByteVector &&message)
+{
+    impl_mbroadcast(all_but_me(), std::move(message));
+}
+
+void SymbolicMultiPartyPlayer::impl_msend(mplayerid_t tos, mByteVector &&messages)
+{
+    for (auto to : tos) {
+        impl_send(to, std::move(messages.at(to)));
+    }
+}
+
+mByteVector SymbolicMultiPartyPlayer::impl_mrecv(mplayerid_t froms, size_type size_hint)
+{
+    mByteVector messages_recv(_n_players);
+    for (auto from : froms) {
+        messages_recv.at(from) = impl_recv(from, size_hint);
+    }
+    return messages_recv;
+}
+
+void SymbolicMultiPartyPlayer::impl_mbroadcast(mplayerid_t tos, ByteVector &&message)
+{
+    for (auto to : tos) {
+        store(to, message);
+    }
+}
+
+mByteVector SymbolicMultiPartyPlayer::impl_mbroadcast_recv(mplayerid_t group, ByteVector &&message)
+{
+    impl_mbroadcast(group, std::move(message));
+    return impl_mrecv(group, 0);
+}
+
+Statistics SymbolicMultiPartyPlayer::get_statistics() const
+{
+    Statistics stat;
+    stat.bytes_send   = _bytes_send;
+    stat.bytes_recv   = _bytes_recv;
+    stat.elapsed_send = std::vector<Statistics::DurationType>(_n_players, Statistics::DurationType(0));
+    stat.elapsed_recv = std::vector<Statistics::DurationType>(_n_players, Statistics::DurationType(0));
+    stat.elapsed_total = MultiPartyPlayer::_timer.total_elapsed();
+    return stat;
+}
+
 } // namespace network
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+
 #include "bitrate.hpp"
 #include "comm_package.h"
+#include "link_profile.h"
+#include "local_channel.h"
+#include "phase_statistics.h"
 #include "playerid.h"
 #include "socket_package.h"
 #include "statistics.h"
@@ -22,11 +28,16 @@ class MultiPartyPlayer
     using size_type = std::size_t;
     using offset_type = int;
 
+    // takes the pieces of the message received from a peer, in order
+    using ChunkHandler = std::function<void(playerid_t from, ByteVector &&chunk)>;
+
   protected:
     playerid_t _my_pid;
     size_type  _n_players;
     Timer      _timer;
 
+    PhaseStatistics _phases;   // traffic accounted per phase tag
+
   protected:
     virtual void        impl_send           ( playerid_t to,      ByteVector && message ) = 0;
     virtual ByteVector  impl_recv           ( playerid_t from,    size_type size_hint   ) = 0;
@@ -40,6 +51,13 @@ class MultiPartyPlayer
     virtual void        impl_mbroadcast     (mplayerid_t to,      ByteVector && messages) = 0;
     virtual mByteVector impl_mbroadcast_recv(mplayerid_t group,   ByteVector && message ) = 0;
 
+    // hand every message received to on_chunk as a single piece, players that can
+    // deliver a message before all of it has arrived override these
+    // both return the number of bytes received from each player
+    virtual std::vector<size_type> impl_mrecv_chunked(mplayerid_t froms, size_type chunk_bytes, ChunkHandler const &on_chunk);
+    virtual std::vector<size_type> impl_mbroadcast_recv_chunked(mplayerid_t group, ByteVector &&message,
+                                                                size_type chunk_bytes, ChunkHandler const &on_chunk);
+
   public:
     virtual ~MultiPartyPlayer()                           = default;
     MultiPartyPlayer(MultiPartyPlayer &&)                 = default;
@@ -54,6 +72,10 @@ class MultiPartyPlayer
     mplayerid_t all()        const;   // return all players' mpid, including me
     mplayerid_t all_but_me() const;   // return all players' mpid, excluding me
 
+    // per-phase communication accounting, see PhaseGuard
+    PhaseStatistics&       phases()       { return _phases; }
+    PhaseStatistics const& phases() const { return _phases; }
+
     // send message to other players
     // blocks until operation completes
     void send(playerid_t to, ByteVector &&message);
@@ -86,6 +108,13 @@ class MultiPartyPlayer
     // blocks until operation completes
     mByteVector broadcast_recv(ByteVector &&message);
     mByteVector mbroadcast_recv(mplayerid_t group, ByteVector&& message);
+
+    // like mrecv and mbroadcast_recv, but the messages are handed to on_chunk on the
+    // calling thread in pieces of chunk_bytes as they arrive, so the caller can parse
+    // and use the start of a large message while the rest is still in flight
+    // the pieces of one message keep their order, pieces of different senders interleave
+    void mrecv_chunked(mplayerid_t froms, size_type chunk_bytes, ChunkHandler const &on_chunk);
+    void mbroadcast_recv_chunked(mplayerid_t group, ByteVector&& message, size_type chunk_bytes, ChunkHandler const &on_chunk);
 };
 
 /************************ socket multi party player ************************/
@@ -129,6 +158,13 @@ class SocketMultiPartyPlayer : public MultiPartyPlayer
     void        impl_mbroadcast     (mplayerid_t tos,     ByteVector && messages);
     mByteVector impl_mbroadcast_recv(mplayerid_t group,   ByteVector && message );
 
+    std::vector<size_type> impl_mrecv_chunked(mplayerid_t froms, size_type chunk_bytes, ChunkHandler const &on_chunk);
+    std::vector<size_type> impl_mbroadcast_recv_chunked(mplayerid_t group, ByteVector &&message,
+                                                        size_type chunk_bytes, ChunkHandler const &on_chunk);
+
+    // pop the pieces of one message from each of froms off queue and hand them to on_chunk
+    std::vector<size_type> drain_chunks(mplayerid_t froms, ChunkQueue &queue, ChunkHandler const &on_chunk);
+
     virtual SocketPackage<SocketType> get_empty_sockets() = 0;
 
   public:
@@ -139,14 +175,17 @@ class SocketMultiPartyPlayer : public MultiPartyPlayer
     // emulate different network conditions
     void set_delay (mplayerid_t tos, DurationType delay);
     void set_bucket(mplayerid_t tos, BitrateType bitrate, size_type capacity);
+    void set_link  (mplayerid_t tos, LinkProfile const& link);
 
-    // run underlying io context
+    // run underlying io context, the threads pinned to cpus if not empty
     bool is_running() const;
-    void run(size_type n_threads);
+    void run(size_type n_threads, std::vector<int> const &cpus = {});
     void stop();
 
     // connect to each other
     void connect(EndpointVector const &endpoints);
+    // and shape the link to every peer j with links[j]
+    void connect(EndpointVector const &endpoints, std::vector<LinkProfile> const &links);
 
     // get network statistics
     Statistics get_statistics() const;
@@ -187,4 +226,110 @@ class PlainMultiPartyPlayer : public detail::SocketMultiPartyPlayer<TCPSocket>
     PlainMultiPartyPlayer(playerid_t my_pid, size_type n_players);
 };
 
+/************************ local multi party player ************************/
+
+// in-process network shared by all local players
+// one lock-free channel per directed link (from, to)
+class LocalNetwork
+{
+  public:
+    using size_type   = std::size_t;
+    using ChannelType = detail::LocalChannel<ByteVector>;
+
+  protected:
+    size_type                                 _n_players;
+    std::vector<std::unique_ptr<ChannelType>> _channels;
+
+  public:
+    ~LocalNetwork()                              = default;
+    LocalNetwork(LocalNetwork &&)                = delete;
+    LocalNetwork(LocalNetwork const &)           = delete;
+    LocalNetwork &operator=(LocalNetwork &&)     = delete;
+    LocalNetwork &operator=(LocalNetwork const&) = delete;
+
+    explicit LocalNetwork(size_type n_players);
+
+    size_type n_players() const { return _n_players; }
+
+    ChannelType &channel(playerid_t from, playerid_t to);
+};
+
+// a player whose peers live in the same process
+// messages are moved through LocalNetwork, no socket and no copy
+// except one copy per extra receiver of a broadcast
+class LocalMultiPartyPlayer : public MultiPartyPlayer
+{
+  protected:
+    LocalNetwork &_net;
+
+    std::vector<size_type>                 _bytes_send;
+    std::vector<size_type>                 _bytes_recv;
+    std::vector<Statistics::DurationType>  _elapsed_recv;
+
+  protected:
+    void        impl_send          (playerid_t to,      ByteVector &&message);
+    ByteVector  impl_recv          (playerid_t from,    size_type size_hint );
+    ByteVector  impl_exchange      (playerid_t peer,    ByteVector &&message);
+    ByteVector  impl_pass_around   (offset_type offset, ByteVector &&message);
+    mByteVector impl_broadcast_recv(                    ByteVector &&message);
+
+    void        impl_broadcast      (                     ByteVector && message );
+    void        impl_msend          (mplayerid_t tos,    mByteVector && messages);
+    mByteVector impl_mrecv          (mplayerid_t froms,   size_type size_hint   );
+    void        impl_mbroadcast     (mplayerid_t tos,     ByteVector && messages);
+    mByteVector impl_mbroadcast_recv(mplayerid_t group,   ByteVector && message );
+
+    // push message to every player in tos, copying for all but the last one
+    void push_all(mplayerid_t tos, ByteVector &&message);
+
+  public:
+    ~LocalMultiPartyPlayer() = default;
+    LocalMultiPartyPlayer(playerid_t my_pid, LocalNetwork &net);
+
+    // get network statistics
+    Statistics get_statistics() const;
+};
+
+/************************ symbolic multi party player ************************/
+
+// a player without peers, used to cost a protocol run
+// messages sent are counted and kept; a receive returns a copy of the
+// message last sent to that peer (or to anyone), so symmetric protocols
+// such as openings see a reply of the right shape
+class SymbolicMultiPartyPlayer : public MultiPartyPlayer
+{
+  protected:
+    std::vector<size_type>  _bytes_send;
+    std::vector<size_type>  _bytes_recv;
+    std::vector<ByteVector> _last_send;   // last message sent to each peer
+    playerid_t              _last_to;     // peer of the last message sent
+
+  protected:
+    void        impl_send          (playerid_t to,      ByteVector &&message);
+    ByteVector  impl_recv          (playerid_t from,    size_type size_hint );
+    ByteVector  impl_exchange      (playerid_t peer,    ByteVector &&message);
+    ByteVector  impl_pass_around   (offset_type offset, ByteVector &&message);
+    mByteVector impl_broadcast_recv(                    ByteVector &&message);
+
+    void        impl_broadcast      (                     ByteVector && message );
+    void        impl_msend          (mplayerid_t tos,    mByteVector && messages);
+    mByteVector impl_mrecv          (mplayerid_t froms,   size_type size_hint   );
+    void        impl_mbroadcast     (mplayerid_t tos,     ByteVector && messages);
+    mByteVector impl_mbroadcast_recv(mplayerid_t group,   ByteVector && message );
+
+    void store(playerid_t to, ByteVector const &message);
+
+  public:
+    ~SymbolicMultiPartyPlayer() = default;
+    SymbolicMultiPartyPlayer(playerid_t my_pid, size_type n_players);
+
+    // get network statistics
+    Statistics get_statistics() const;
+};
+
+// run fn(player) for every party of a fresh LocalNetwork, one thread per party
+// rethrows the first exception raised by any party
+void run_local_parties(std::size_t n_players,
+                       std::function<void(LocalMultiPartyPlayer &)> const &fn);
+
 } // namespace network
@@ -28,7 +28,8 @@ void insert_empty(std::vector<T> &vec, mplayerid_t slots)
     }
 }
 
-std::vector<std::thread> run_io_context(boost::asio::io_context &ioc, std::size_t n_threads);
+// worker thread i is pinned to cpus[i % cpus.size()] if cpus is not empty
+std::vector<std::thread> run_io_context(boost::asio::io_context &ioc, std::size_t n_threads, std::vector<int> const &cpus = {});
 
 void stop_io_context(boost::asio::io_context &ioc, std::vector<std::thread> &worker_threads);
 
@@ -70,6 +71,15 @@ void SocketMultiPartyPlayer<SocketType>::set_bucket(
     _comm.set_bucket(tos, rate, capacity);
 }
 
+template <typename SocketType>
+void SocketMultiPartyPlayer<SocketType>::set_link(mplayerid_t tos, LinkProfile const& link)
+{
+    link.validate();
+    _comm.set_delay(tos, link.delay);
+    _comm.set_bucket(tos, link.bandwidth, link.bucket_capacity());
+    _comm.set_strategy(tos, link.strategy);
+}
+
 
 template <typename SocketType>
 Statistics SocketMultiPartyPlayer<SocketType>::get_statistics() const
@@ -89,13 +99,13 @@ bool SocketMultiPartyPlayer<SocketType>::is_running() const
 }
 
 template <typename SocketType>
-void SocketMultiPartyPlayer<SocketType>::run(size_type n_threads)
+void SocketMultiPartyPlayer<SocketType>::run(size_type n_threads, std::vector<int> const &cpus)
 {
     if (this->is_running())
         throw std::runtime_error("player already running");
 
     assert(_worker_threads.size() == 0);
-    _worker_threads = run_io_context(_ioc, n_threads);
+    _worker_threads = run_io_context(_ioc, n_threads, cpus);
     _is_running = true;
 }
 
@@ -118,6 +128,21 @@ void SocketMultiPartyPlayer<SocketType>::connect(EndpointVector const &endpoints
     _comm = std::move(CommPackageType(std::move(sockets)));
 }
 
+template <typename SocketType>
+void SocketMultiPartyPlayer<SocketType>::connect(EndpointVector const &endpoints, std::vector<LinkProfile> const &links)
+{
+    if (links.size() != _n_players)
+        throw std::invalid_argument("need one link profile per player");
+    for (auto const& link : links)
+        link.validate();
+
+    connect(endpoints);
+    for (playerid_t j = 0; j != _n_players; ++j) {
+        if (j != _my_pid)
+            set_link(mplayerid_t{j}, links[j]);
+    }
+}
+
 template <typename SocketType>
 void SocketMultiPartyPlayer<SocketType>::impl_send(playerid_t to, ByteVector &&message)
 {
@@ -270,6 +295,60 @@ mByteVector SocketMultiPartyPlayer<SocketType>::impl_mbroadcast_recv(mplayerid_t
     return messages_recv;
 }
 
+template <typename SocketType>
+std::vector<typename SocketMultiPartyPlayer<SocketType>::size_type>
+SocketMultiPartyPlayer<SocketType>::drain_chunks(mplayerid_t froms, ChunkQueue &queue, ChunkHandler const &on_chunk)
+{
+    std::vector<size_type> bytes_recv(_n_players, 0);
+    for (size_type remaining = froms.size(); remaining != 0;) {
+        auto chunk = queue.pop();
+        bytes_recv.at(chunk.from) += chunk.bytes.size();
+        if (chunk.last)
+            --remaining;
+        on_chunk(chunk.from, std::move(chunk.bytes));
+    }
+    return bytes_recv;
+}
+
+template <typename SocketType>
+std::vector<typename SocketMultiPartyPlayer<SocketType>::size_type>
+SocketMultiPartyPlayer<SocketType>::impl_mrecv_chunked(mplayerid_t froms, size_type chunk_bytes, ChunkHandler const &on_chunk)
+{
+    // shared with the receives, which outlive this call if one of them fails
+    auto queue = std::make_shared<ChunkQueue>();
+    for (auto from : froms) {
+        _comm.recv_chunked(from, chunk_bytes, queue);
+    }
+    return drain_chunks(froms, *queue, on_chunk);
+}
+
+template <typename SocketType>
+std::vector<typename SocketMultiPartyPlayer<SocketType>::size_type>
+SocketMultiPartyPlayer<SocketType>::impl_mbroadcast_recv_chunked(mplayerid_t group, ByteVector &&message,
+                                                                 size_type chunk_bytes, ChunkHandler const &on_chunk)
+{
+    auto message_send = std::move(message);
+    auto queue = std::make_shared<ChunkQueue>();
+
+    FutureVector<void> futures_send;
+    for (auto peer : group) {
+        futures_send.emplace_back(_comm.send_copy(peer, message_send));
+        _comm.recv_chunked(peer, chunk_bytes, queue);
+    }
+
+    std::vector<size_type> bytes_recv;
+    try {
+        bytes_recv = drain_chunks(group, *queue, on_chunk);
+    }
+    catch (...) {
+        // the sends still read message_send
+        futures_send.wait();
+        throw;
+    }
+    futures_send.get();
+    return bytes_recv;
+}
+
 } // namespace detail
 
 /************************ secure player ************************/
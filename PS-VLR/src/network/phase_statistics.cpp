@@ -0,0 +1,106 @@
+#include "phase_statistics.h"
+
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace network
+{
+
+/************************ phase statistics ************************/
+
+void PhaseStatistics::enter(std::string const& tag)
+{
+    if (_stack.empty())
+        _stack.emplace_back(tag);
+    else
+        _stack.emplace_back(_stack.back() + "/" + tag);
+
+    _records[_stack.back()].entered += 1;
+}
+
+void PhaseStatistics::leave(DurationType wall)
+{
+    if (_stack.empty())
+        throw std::logic_error("leave phase without entering");
+
+    _records[_stack.back()].elapsed_wall += wall;
+    _stack.pop_back();
+}
+
+std::string PhaseStatistics::current() const
+{
+    return _stack.empty() ? std::string(untagged) : _stack.back();
+}
+
+PhaseRecord& PhaseStatistics::current_record()
+{
+    return _records[current()];
+}
+
+void PhaseStatistics::on_send(size_type bytes, size_type messages)
+{
+    auto& record = current_record();
+    record.bytes_send    += bytes;
+    record.messages_send += messages;
+}
+
+void PhaseStatistics::on_recv(size_type bytes, size_type messages)
+{
+    auto& record = current_record();
+    record.bytes_recv    += bytes;
+    record.messages_recv += messages;
+}
+
+void PhaseStatistics::on_blocked(DurationType blocked, bool is_round)
+{
+    auto& record = current_record();
+    record.elapsed_blocked += blocked;
+    if (is_round) {
+        record.rounds += 1;
+        _rounds += 1;
+    }
+}
+
+void PhaseStatistics::clear()
+{
+    _records.clear();
+}
+
+std::string PhaseStatistics::to_json(playerid_t my_pid) const
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    std::string json = fmt::format("{{\n  \"party\": {},\n  \"phases\": {{", my_pid);
+
+    bool first = true;
+    for (auto const& [tag, record] : _records) {
+        json += fmt::format(
+            "{}\n    \"{}\": {{\"entered\": {}, \"rounds\": {}, "
+            "\"messages_send\": {}, \"messages_recv\": {}, "
+            "\"bytes_send\": {}, \"bytes_recv\": {}, "
+            "\"wall_us\": {}, \"blocked_us\": {}}}",
+            first ? "" : ",", tag, record.entered, record.rounds,
+            record.messages_send, record.messages_recv,
+            record.bytes_send, record.bytes_recv,
+            duration_cast<microseconds>(record.elapsed_wall).count(),
+            duration_cast<microseconds>(record.elapsed_blocked).count());
+        first = false;
+    }
+
+    json += "\n  }\n}\n";
+    return json;
+}
+
+void PhaseStatistics::dump(std::string const& file_path, playerid_t my_pid) const
+{
+    std::ofstream file(file_path);
+    if (!file)
+        throw std::runtime_error("cannot open " + file_path);
+    file << to_json(my_pid);
+}
+
+} // namespace network
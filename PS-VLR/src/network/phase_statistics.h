@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "playerid.h"
+#include "../tools/timer.h"
+
+namespace network {
+
+// communication accounted to one phase tag
+struct PhaseRecord
+{
+    using size_type    = std::size_t;
+    using DurationType = Timer::DurationType;
+
+    size_type    bytes_send       = 0;   // bytes handed to the network
+    size_type    bytes_recv       = 0;   // bytes received from the network
+    size_type    messages_send    = 0;   // number of messages sent
+    size_type    messages_recv    = 0;   // number of messages received
+    size_type    rounds           = 0;   // number of blocking receive operations
+    size_type    entered          = 0;   // number of times the phase was entered
+    DurationType elapsed_wall     {0};   // time spent inside the phase scope
+    DurationType elapsed_blocked  {0};   // time spent inside network operations
+};
+
+// per-player phase accounting
+// phases nest, and each is keyed by its full path, e.g. "train/sigmoid/msb"
+// traffic is accounted to the innermost open phase only,
+// wall time of a phase includes its nested phases
+class PhaseStatistics
+{
+  public:
+    using size_type    = std::size_t;
+    using DurationType = Timer::DurationType;
+
+    static constexpr const char* untagged = "(untagged)";
+
+  protected:
+    std::vector<std::string>           _stack;
+    std::map<std::string, PhaseRecord> _records;
+    size_type                          _rounds = 0;
+
+  public:
+    PhaseStatistics() = default;
+
+    void enter(std::string const& tag);
+    void leave(DurationType wall);
+
+    std::string  current() const;
+    PhaseRecord& current_record();
+
+    void on_send(size_type bytes, size_type messages);
+    void on_recv(size_type bytes, size_type messages);
+    void on_blocked(DurationType blocked, bool is_round);
+
+    std::map<std::string, PhaseRecord> const& records() const { return _records; }
+    // blocking receive operations over all phases since construction, clear keeps them
+    size_type rounds() const { return _rounds; }
+    void clear();
+
+    std::string to_json(playerid_t my_pid) const;
+    void dump(std::string const& file_path, playerid_t my_pid) const;
+};
+
+// enter a phase for the lifetime of the guard
+class PhaseGuard
+{
+  protected:
+    PhaseStatistics& _stats;
+    Timer            _timer;
+
+  public:
+    PhaseGuard(PhaseGuard const&)            = delete;
+    PhaseGuard& operator=(PhaseGuard const&) = delete;
+
+    PhaseGuard(PhaseStatistics& stats, std::string const& tag): _stats(stats) {
+        _stats.enter(tag);
+        _timer.start();
+    }
+
+    ~PhaseGuard() {
+        _timer.stop();
+        _stats.leave(_timer.elapsed());
+    }
+};
+
+// account one network operation of MultiPartyPlayer
+class PhaseCallGuard
+{
+  protected:
+    PhaseStatistics& _stats;
+    Timer            _timer;
+    bool             _is_round;
+
+  public:
+    PhaseCallGuard(PhaseCallGuard const&)            = delete;
+    PhaseCallGuard& operator=(PhaseCallGuard const&) = delete;
+
+    PhaseCallGuard(PhaseStatistics& stats, bool is_round): _stats(stats), _is_round(is_round) {
+        _timer.start();
+    }
+
+    ~PhaseCallGuard() {
+        _timer.stop();
+        _stats.on_blocked(_timer.elapsed(), _is_round);
+    }
+
+    void sent(std::size_t bytes, std::size_t messages = 1) { _stats.on_send(bytes, messages); }
+    void recved(std::size_t bytes, std::size_t messages = 1) { _stats.on_recv(bytes, messages); }
+};
+
+} // namespace network
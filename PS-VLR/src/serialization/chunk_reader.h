@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#include "deserializer.h"
+#include "exceptions.h"
+
+#include "../tools/byte_vector.h"
+
+// reads a std::vector<T> serialized by Serializer from the consecutive pieces of
+// the message, as handed out by MultiPartyPlayer::mrecv_chunked
+// elements split between two pieces are completed with the start of the next one
+template <detail::TriviallySerializable T>
+class VectorChunkReader {
+public:
+    using size_type = std::size_t;
+
+protected:
+    static constexpr size_type unknown = std::numeric_limits<size_type>::max();
+
+    size_type _size = unknown;   // elements in the vector, read from the first bytes
+    size_type _read = 0;         // elements handed out so far
+    std::byte _partial[sizeof(T) > sizeof(size_type) ? sizeof(T) : sizeof(size_type)];
+    size_type _partial_bytes = 0;
+
+    // completes the object of n bytes in _partial with the front of [data, end)
+    // returns whether it is complete
+    bool fill(std::byte const*& data, std::byte const* end, size_type n) {
+        size_type take = std::min<size_type>(n - _partial_bytes, end - data);
+        std::memcpy(_partial + _partial_bytes, data, take);
+        _partial_bytes += take;
+        data += take;
+        if (_partial_bytes != n) return false;
+        _partial_bytes = 0;
+        return true;
+    }
+
+public:
+    bool      done() const { return _size != unknown && _read == _size && _partial_bytes == 0; }
+    size_type size() const { return _size; }
+
+    // calls fn(i, x) for every element x, the i-th of the vector, completed by chunk
+    // throws deserialization_error on bytes past the end of the vector
+    template <typename Fn>
+    void feed(ByteVector const& chunk, Fn&& fn) {
+        std::byte const* data = chunk.data();
+        std::byte const* end  = data + chunk.size();
+
+        if (_size == unknown) {
+            if (!fill(data, end, sizeof(size_type))) return;
+            std::memcpy(&_size, _partial, sizeof(size_type));
+        }
+        T x;
+        if (_partial_bytes != 0) {
+            if (!fill(data, end, sizeof(T))) return;
+            std::memcpy(&x, _partial, sizeof(T));
+            fn(_read++, x);
+        }
+        for (; end - data >= static_cast<std::ptrdiff_t>(sizeof(T)) && _read < _size; data += sizeof(T)) {
+            std::memcpy(&x, data, sizeof(T));
+            fn(_read++, x);
+        }
+        if (data != end && _read < _size) {
+            fill(data, end, sizeof(T));
+        }
+        if (data != end) throw deserialization_error{};
+    }
+};
@@ -201,13 +201,13 @@ BitVector BitVector::operator|(BitVector const &other) const
     return ans;
 }
 
+#endif // #ifdef __bitvector_enable_expression_templates__
+
 void BitVector::invert()
 {
     mpn_com((mp_limb_t *)this->data(), (mp_limb_t *)this->data(), this->size_in_limbs());
 }
 
-#endif // #ifdef __bitvector_enable_expression_templates__
-
 BitVector &BitVector::operator^=(BitVector const &other)
 {
     if (_size != other._size)
@@ -73,7 +73,7 @@ auto operator op (ExprType const& expr)                               \
 {                                                                     \
     using OperationType = optypename;                                 \
     using ExprRefType = ExprTraits<ExprType>::ref_type;               \
-    return UnaryExpression<OperationType, ExprType> { expr };         \
+    return UnaryExpression<OperationType, ExprRefType> { expr };      \
 }                                                                     \
 
 #define __define_binary_operator_expression_template__(op, optypename)  \
@@ -90,6 +90,36 @@ auto operator op (LhsExprType const& lhs, RhsExprType const& rhs)       \
     > {lhs, rhs};                                                       \
 }                                                                       \
 
+// the same, for the expressions satisfying concept only
+// lets several kinds of arrays define one operator without mixing
+#define __define_constrained_unary_operator_expression_template__(op, optypename, concept)     \
+template <ConceptExpr ExprType>                                                             \
+requires (!ConceptExprScalar<ExprType>) &&                                                  \
+         concept<UnaryExpression<optypename, typename ExprTraits<ExprType>::ref_type>>      \
+auto operator op (ExprType const& expr)                                                     \
+{                                                                                           \
+    using OperationType = optypename;                                                       \
+    using ExprRefType = ExprTraits<ExprType>::ref_type;                                     \
+    return UnaryExpression<OperationType, ExprRefType> { expr };                            \
+}                                                                                           \
+
+#define __define_constrained_binary_operator_expression_template__(op, optypename, concept)    \
+template <ConceptExpr LhsExprType, ConceptExpr RhsExprType>                                 \
+requires (!ConceptExprScalar<LhsExprType> ||                                                \
+          !ConceptExprScalar<RhsExprType>) &&                                               \
+         concept<BinaryExpression<optypename,                                               \
+                                  typename ExprTraits<LhsExprType>::ref_type,               \
+                                  typename ExprTraits<RhsExprType>::ref_type>>              \
+auto operator op (LhsExprType const& lhs, RhsExprType const& rhs)                           \
+{                                                                                           \
+    using OperationType = optypename;                                                       \
+    using LhsExprRefType = ExprTraits<LhsExprType>::ref_type;                               \
+    using RhsExprRefType = ExprTraits<RhsExprType>::ref_type;                               \
+    return BinaryExpression<                                                                \
+        OperationType, LhsExprRefType, RhsExprRefType                                       \
+    > {lhs, rhs};                                                                           \
+}                                                                                           \
+
 /************************ only enable needed ones ***********************/
 
 //  __define_unary_operator_expression_template__(~, std::bit_not<>);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+/// @brief A rows x cols matrix of trivially copyable T, stored in chunks of chunk_rows rows.
+/// Every chunk starts on a page boundary, so a batch of chunk_rows rows covers whole pages that
+/// are read ahead (prefetch) and dropped from memory (release) on their own.
+/// Without a path the chunks live in anonymous memory. With a path they are mapped from that
+/// file, which is created and sized up front and removed with the store: the matrix may then be
+/// larger than RAM and only the batches in use stay resident.
+template <typename T>
+class ShareStore{
+public:
+    using size_type = std::size_t;
+
+    ShareStore() = default;
+    ShareStore(size_type rows, size_type cols, size_type chunk_rows, const std::string& path = "");
+    ShareStore(const ShareStore&) = delete;
+    ShareStore& operator=(const ShareStore&) = delete;
+    ShareStore(ShareStore&& other) noexcept;
+    ShareStore& operator=(ShareStore&& other) noexcept;
+    ~ShareStore();
+
+    size_type rows() const { return _rows; }
+    size_type cols() const { return _cols; }
+    size_type chunk_rows() const { return _chunk_rows; }
+    bool empty() const { return _rows == 0; }
+    bool on_disk() const { return !_path.empty(); }
+
+    std::span<T> row(size_type i);
+    std::span<const T> row(size_type i) const;
+
+    /// @brief rows [first, last) as vectors, e.g. for Semi2kContext::mult_sharing_matrix
+    std::vector<std::vector<T>> read(size_type first, size_type last) const;
+
+    /// @brief rows[k] to columns [col, col + rows[k].size()) of row first + k
+    void write(size_type first, const std::vector<std::vector<T>>& rows, size_type col = 0);
+
+    /// @brief the chunks holding rows [first, last) are read next, the kernel reads them ahead
+    void prefetch(size_type first, size_type last) const;
+
+    /// @brief the chunks holding rows [first, last) are not needed for a while, file-backed pages
+    /// leave memory and are read back from the file on the next access, anonymous ones stay
+    void release(size_type first, size_type last) const;
+
+private:
+    size_type _rows = 0, _cols = 0, _chunk_rows = 0;
+    size_type _chunk_bytes = 0;     // one chunk rounded up to whole pages
+    std::string _path;
+    std::byte* _base = nullptr;
+
+    size_type mapped_bytes() const;
+    // the pages of the chunks holding rows [first, last)
+    std::span<std::byte> chunks(size_type first, size_type last) const;
+    void unmap();
+};
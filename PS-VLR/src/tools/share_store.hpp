@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "share_store.h"
+
+template <typename T>
+ShareStore<T>::ShareStore(size_type rows, size_type cols, size_type chunk_rows, const std::string& path)
+    : _rows(rows), _cols(cols), _chunk_rows(chunk_rows), _path(path){
+    static_assert(std::is_trivially_copyable_v<T>, "ShareStore keeps raw bytes");
+    if(chunk_rows == 0) throw std::invalid_argument("ShareStore: chunks need at least one row");
+
+    size_type page = sysconf(_SC_PAGESIZE);
+    _chunk_bytes = (chunk_rows * cols * sizeof(T) + page - 1) / page * page;
+    if(mapped_bytes() == 0) return;
+
+    void* base = MAP_FAILED;
+    if(_path.empty()){
+        base = mmap(nullptr, mapped_bytes(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else{
+        int fd = open(_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if(fd < 0) throw std::runtime_error("ShareStore: cannot create " + _path + ": " + std::strerror(errno));
+        if(ftruncate(fd, mapped_bytes()) == 0){
+            base = mmap(nullptr, mapped_bytes(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int err = errno;
+        close(fd);
+        if(base == MAP_FAILED){
+            unlink(_path.c_str());
+            throw std::runtime_error("ShareStore: cannot map " + _path + ": " + std::strerror(err));
+        }
+    }
+    if(base == MAP_FAILED) throw std::runtime_error(std::string("ShareStore: cannot map memory: ") + std::strerror(errno));
+    _base = static_cast<std::byte*>(base);
+}
+
+template <typename T>
+ShareStore<T>::ShareStore(ShareStore&& other) noexcept
+    : _rows(other._rows), _cols(other._cols), _chunk_rows(other._chunk_rows), _chunk_bytes(other._chunk_bytes),
+      _path(std::move(other._path)), _base(std::exchange(other._base, nullptr)){
+    other._path.clear();
+    other._rows = 0;
+}
+
+template <typename T>
+ShareStore<T>& ShareStore<T>::operator=(ShareStore&& other) noexcept{
+    if(this != &other){
+        unmap();
+        _rows = std::exchange(other._rows, 0);
+        _cols = other._cols;
+        _chunk_rows = other._chunk_rows;
+        _chunk_bytes = other._chunk_bytes;
+        _path = std::move(other._path);
+        other._path.clear();
+        _base = std::exchange(other._base, nullptr);
+    }
+    return *this;
+}
+
+template <typename T>
+ShareStore<T>::~ShareStore(){
+    unmap();
+}
+
+template <typename T>
+void ShareStore<T>::unmap(){
+    if(_base) munmap(_base, mapped_bytes());
+    if(!_path.empty()) unlink(_path.c_str());
+    _base = nullptr;
+    _path.clear();
+}
+
+template <typename T>
+typename ShareStore<T>::size_type ShareStore<T>::mapped_bytes() const{
+    return _chunk_rows == 0 ? 0 : (_rows + _chunk_rows - 1) / _chunk_rows * _chunk_bytes;
+}
+
+template <typename T>
+std::span<T> ShareStore<T>::row(size_type i){
+    auto* chunk = _base + i / _chunk_rows * _chunk_bytes;
+    return {reinterpret_cast<T*>(chunk) + i % _chunk_rows * _cols, _cols};
+}
+
+template <typename T>
+std::span<const T> ShareStore<T>::row(size_type i) const{
+    const auto* chunk = _base + i / _chunk_rows * _chunk_bytes;
+    return {reinterpret_cast<const T*>(chunk) + i % _chunk_rows * _cols, _cols};
+}
+
+template <typename T>
+std::vector<std::vector<T>> ShareStore<T>::read(size_type first, size_type last) const{
+    std::vector<std::vector<T>> ret;
+    ret.reserve(last - first);
+    for(size_type i = first; i != last; ++i){
+        auto r = row(i);
+        ret.emplace_back(r.begin(), r.end());
+    }
+    return ret;
+}
+
+template <typename T>
+void ShareStore<T>::write(size_type first, const std::vector<std::vector<T>>& rows, size_type col){
+    if(first + rows.size() > _rows) throw std::out_of_range("ShareStore: rows out of range");
+    for(size_type k = 0; k != rows.size(); ++k){
+        if(col + rows[k].size() > _cols) throw std::out_of_range("ShareStore: columns out of range");
+        std::memcpy(row(first + k).data() + col, rows[k].data(), rows[k].size() * sizeof(T));
+    }
+}
+
+template <typename T>
+std::span<std::byte> ShareStore<T>::chunks(size_type first, size_type last) const{
+    last = std::min(last, _rows);
+    if(_base == nullptr || first >= last) return {};
+    size_type begin = first / _chunk_rows, end = (last + _chunk_rows - 1) / _chunk_rows;
+    return {_base + begin * _chunk_bytes, (end - begin) * _chunk_bytes};
+}
+
+template <typename T>
+void ShareStore<T>::prefetch(size_type first, size_type last) const{
+    auto pages = chunks(first, last);
+    if(!pages.empty()) madvise(pages.data(), pages.size(), MADV_WILLNEED);
+}
+
+template <typename T>
+void ShareStore<T>::release(size_type first, size_type last) const{
+    // MADV_DONTNEED would zero anonymous pages, shared file pages are kept in the file
+    auto pages = chunks(first, last);
+    if(on_disk() && !pages.empty()) madvise(pages.data(), pages.size(), MADV_DONTNEED);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// bounded lock-free single-producer single-consumer ring buffer
+// values are moved in and moved out
+// blocking calls back off from spinning to short sleeps
+// close ends the stream from either side: pop drains what is left and then reports the
+// end, push drops its value, so neither side waits forever for one that has stopped
+template <typename T>
+class SPSCRing
+{
+  public:
+    using size_type = std::size_t;
+
+  protected:
+    std::vector<std::optional<T>> _slots;
+    size_type                     _capacity;
+
+    alignas(64) std::atomic<size_type> _head;   // next slot to pop, written by consumer
+    alignas(64) std::atomic<size_type> _tail;   // next slot to push, written by producer
+    std::atomic<bool>                  _closed;
+
+    static void backoff(size_type& round) {
+        if (round < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        ++round;
+    }
+
+  public:
+    explicit SPSCRing(size_type capacity)
+        : _slots(capacity), _capacity(capacity), _head(0), _tail(0), _closed(false)
+    {
+        if (capacity == 0)
+            throw std::invalid_argument("ring capacity must be positive");
+    }
+
+    SPSCRing(SPSCRing const&)            = delete;
+    SPSCRing& operator=(SPSCRing const&) = delete;
+
+    size_type capacity() const { return _capacity; }
+    size_type size() const {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    bool full()  const { return size() == _capacity; }
+
+    void close() { _closed.store(true, std::memory_order_release); }
+    bool closed() const { return _closed.load(std::memory_order_acquire); }
+
+    bool try_push(T&& value) {
+        auto tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == _capacity)
+            return false;
+        _slots[tail % _capacity].emplace(std::move(value));
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> try_pop() {
+        auto head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire))
+            return std::nullopt;
+        auto& slot = _slots[head % _capacity];
+        std::optional<T> value(std::move(slot));
+        slot.reset();
+        _head.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    // blocks while full, false if the ring is closed
+    bool push(T&& value) {
+        size_type round = 0;
+        while (full()) {
+            if (closed())
+                return false;
+            backoff(round);
+        }
+        if (closed())
+            return false;
+        return try_push(std::move(value));
+    }
+
+    // blocks while empty, nullopt once the ring is closed and empty
+    // waited tells whether the caller had to wait
+    std::optional<T> pop(bool* waited = nullptr) {
+        size_type round = 0;
+        std::optional<T> value;
+        while (!(value = try_pop())) {
+            if (closed()) {
+                // a push that came before close is visible now
+                value = try_pop();
+                break;
+            }
+            backoff(round);
+        }
+        if (waited)
+            *waited = (round > 0);
+        return value;
+    }
+};
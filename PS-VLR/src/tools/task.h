@@ -0,0 +1,214 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// lazily started coroutine returning a T
+// co_await on a task starts it and resumes the awaiting coroutine once it returns,
+// so protocols compose like plain calls; the outermost task is started by whoever
+// drives it, e.g. run_inline or RoundScheduler::run
+// arguments taken by reference must outlive the task, which holds within one full
+// expression such as run_inline(f(x)) or co_await f(g(x))
+template <typename T>
+class Task
+{
+  public:
+    struct promise_type;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        std::optional<T>        value;
+        std::exception_ptr      error;
+        std::coroutine_handle<> continuation;
+
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(handle_type h) noexcept {
+                auto next = h.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        Task get_return_object() { return Task(handle_type::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_value(T v) { value.emplace(std::move(v)); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+  protected:
+    handle_type _handle;
+
+    explicit Task(handle_type h) : _handle(h) {}
+
+  public:
+    Task(Task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (_handle) _handle.destroy();
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+    Task(Task const&)            = delete;
+    Task& operator=(Task const&) = delete;
+    ~Task() {
+        if (_handle) _handle.destroy();
+    }
+
+    // runs the task until its first suspension or its end
+    void start() { _handle.resume(); }
+    bool done() const { return _handle.done(); }
+
+    // the returned value, rethrows what the task threw
+    T result() {
+        if (!_handle.done()) throw std::logic_error("task: result of a suspended task");
+        auto& promise = _handle.promise();
+        if (promise.error) std::rethrow_exception(promise.error);
+        return std::move(*promise.value);
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        _handle.promise().continuation = awaiter;
+        return _handle;
+    }
+    T await_resume() { return result(); }
+
+    // co_await task.finished() runs the task like co_await task, the result stays in the task
+    auto finished() {
+        struct Awaiter
+        {
+            handle_type handle;
+            bool        await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+                handle.promise().continuation = awaiter;
+                return handle;
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{_handle};
+    }
+};
+
+namespace detail
+{
+
+// the children of a when_all still running, plus one held while they are started
+struct JoinCounter
+{
+    std::size_t             remaining = 0;
+    std::coroutine_handle<> parent;
+};
+
+// runs one child of a when_all, the last child to finish resumes the parent
+class Joiner
+{
+  public:
+    struct promise_type
+    {
+        JoinCounter* counter = nullptr;
+
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                auto* counter = h.promise().counter;
+                return --counter->remaining == 0 ? counter->parent : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        Joiner get_return_object() { return Joiner(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }   // the awaited tasks keep their errors
+    };
+
+  protected:
+    std::coroutine_handle<promise_type> _handle;
+
+    explicit Joiner(std::coroutine_handle<promise_type> h) : _handle(h) {}
+
+  public:
+    Joiner(Joiner&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+    Joiner(Joiner const&)            = delete;
+    Joiner& operator=(Joiner const&) = delete;
+    ~Joiner() {
+        if (_handle) _handle.destroy();
+    }
+
+    void start(JoinCounter* counter) {
+        _handle.promise().counter = counter;
+        _handle.resume();
+    }
+};
+
+template <typename Awaitable>
+Joiner join(Awaitable awaitable)
+{
+    co_await awaitable;
+}
+
+// starts all joiners, the awaiting coroutine resumes once every one has finished
+struct JoinAll
+{
+    std::vector<Joiner>& joiners;
+    JoinCounter          counter;
+
+    bool await_ready() const noexcept { return joiners.empty(); }
+    bool await_suspend(std::coroutine_handle<> parent) {
+        counter.remaining = joiners.size() + 1;
+        counter.parent    = parent;
+        for (auto& j : joiners) j.start(&counter);
+        // all finished while being started: go on without suspending
+        return --counter.remaining != 0;
+    }
+    void await_resume() const noexcept {}
+};
+
+} // namespace detail
+
+// runs the tasks side by side and returns their results, rethrowing the first error
+// in argument order; the tasks run one after the other when every await completes at
+// once, and interleave when they suspend, e.g. on openings under a RoundScheduler
+template <typename... T>
+Task<std::tuple<T...>> when_all(Task<T>... tasks)
+{
+    std::vector<detail::Joiner> joiners;
+    (joiners.push_back(detail::join(tasks.finished())), ...);
+    co_await detail::JoinAll{joiners, {}};
+    std::tuple<T...> ret{tasks.result()...};
+    co_return ret;
+}
+
+template <typename T>
+Task<std::vector<T>> when_all(std::vector<Task<T>> tasks)
+{
+    std::vector<detail::Joiner> joiners;
+    for (auto& t : tasks) joiners.push_back(detail::join(t.finished()));
+    co_await detail::JoinAll{joiners, {}};
+    std::vector<T> ret;
+    ret.reserve(tasks.size());
+    for (auto& t : tasks) ret.push_back(t.result());
+    co_return ret;
+}
+
+// runs a task that never suspends for good, i.e. one whose awaits all complete at once
+template <typename T>
+T run_inline(Task<T> task)
+{
+    task.start();
+    if (!task.done()) throw std::logic_error("task: suspended outside a scheduler");
+    return task.result();
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// fixed set of worker threads for data-parallel loops
+// parallel_for splits [0, n) into blocks, the calling thread takes blocks as well and
+// returns once all are done, rethrowing the first exception of a block
+// the pool replaces OpenMP parallelism: every participant runs its blocks with an
+// OpenMP team of one, so HE calls inside a loop do not spawn teams of their own
+// one loop runs at a time, a call while the pool is busy, or from inside a loop,
+// runs inline on the calling thread
+class ThreadPool
+{
+  public:
+    using size_type = std::size_t;
+    using Body      = std::function<void(size_type, size_type)>;
+
+  protected:
+    std::vector<std::thread> _workers;
+
+    std::mutex              _call;       // held by the thread running a loop on the pool
+    std::mutex              _mutex;
+    std::condition_variable _start;
+    std::condition_variable _finish;
+    size_type               _generation = 0;   // loops started, workers wait for a new one
+    size_type               _finished   = 0;   // workers done with the current loop
+    bool                    _stop       = false;
+
+    // the current loop
+    Body const*            _body = nullptr;
+    size_type              _n = 0, _block = 0, _blocks = 0;
+    std::atomic<size_type> _next{0};
+    std::exception_ptr     _error;
+
+    static bool& in_loop() {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    void run_blocks() {
+        for (size_type b; (b = _next.fetch_add(1, std::memory_order_relaxed)) < _blocks;) {
+            try {
+                (*_body)(b * _block, std::min(_n, (b + 1) * _block));
+            }
+            catch (...) {
+                std::lock_guard lock(_mutex);
+                if (!_error) _error = std::current_exception();
+                _next.store(_blocks, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void work() {
+        in_loop() = true;
+#ifdef _OPENMP
+        omp_set_num_threads(1);
+#endif
+        size_type seen = 0;
+        std::unique_lock lock(_mutex);
+        for (;;) {
+            _start.wait(lock, [&] { return _stop || _generation != seen; });
+            if (_stop) return;
+            seen = _generation;
+            lock.unlock();
+            run_blocks();
+            lock.lock();
+            if (++_finished == _workers.size()) _finish.notify_one();
+        }
+    }
+
+  public:
+    explicit ThreadPool(size_type n_workers) {
+        _workers.reserve(n_workers);
+        for (size_type i = 0; i != n_workers; ++i)
+            _workers.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(_mutex);
+            _stop = true;
+        }
+        _start.notify_all();
+        for (auto& t : _workers) t.join();
+    }
+
+    ThreadPool(ThreadPool const&)            = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    // threads taking part in a loop, the caller included
+    size_type size() const { return _workers.size() + 1; }
+
+    // f(begin, end) for blocks of at least grain indices covering [0, n)
+    template <typename F>
+    void parallel_for(size_type n, size_type grain, F&& f) {
+        if (n == 0) return;
+        grain = std::max<size_type>(grain, 1);
+        // a few blocks per thread even out uneven blocks
+        size_type block = std::max(grain, (n + 4 * size() - 1) / (4 * size()));
+        if (_workers.empty() || block >= n || in_loop()) {
+            f(size_type(0), n);
+            return;
+        }
+        std::unique_lock call(_call, std::try_to_lock);
+        if (!call.owns_lock()) {
+            f(size_type(0), n);
+            return;
+        }
+
+        Body body = std::ref(f);
+        {
+            std::lock_guard lock(_mutex);
+            _body     = &body;
+            _n        = n;
+            _block    = block;
+            _blocks   = (n + block - 1) / block;
+            _finished = 0;
+            _error    = nullptr;
+            _next.store(0, std::memory_order_relaxed);
+            ++_generation;
+        }
+        _start.notify_all();
+
+        in_loop() = true;
+#ifdef _OPENMP
+        int omp_threads = omp_get_max_threads();
+        omp_set_num_threads(1);
+#endif
+        run_blocks();
+#ifdef _OPENMP
+        omp_set_num_threads(omp_threads);
+#endif
+        in_loop() = false;
+
+        std::unique_lock lock(_mutex);
+        _finish.wait(lock, [&] { return _finished == _workers.size(); });
+        _body = nullptr;
+        if (_error) std::rethrow_exception(_error);
+    }
+};
+
+// f(begin, end) over [0, n), on pool if given, else in one call
+template <typename F>
+void parallel_for(ThreadPool* pool, std::size_t n, std::size_t grain, F&& f)
+{
+    if (pool)
+        pool->parallel_for(n, grain, std::forward<F>(f));
+    else if (n != 0)
+        f(std::size_t(0), n);
+}
@@ -2,6 +2,8 @@
 
 #include <chrono>
 
+#include "trace.h"
+
 class Timer {
 public:
     using Clock         = std::chrono::steady_clock;
@@ -36,12 +38,16 @@ public:
 };
 
 
+// times a scope, and also records it as a trace event
+// when a name is given and tracing is enabled on this thread
 class TimerGuard {
 protected:
     Timer& _timer;
+    trace::Scope _trace;
 
 public:
-    TimerGuard(Timer& timer):_timer(timer) {
+    TimerGuard(Timer& timer, const char* trace_name = "timer", const char* trace_category = trace::cpu)
+        :_timer(timer), _trace(trace_name, trace_category) {
         _timer.start();
     }
 
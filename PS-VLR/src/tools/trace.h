@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// opt-in event tracing in chrome trace-event format (chrome://tracing, ui.perfetto.dev)
+// each thread may install one Tracer, events are dropped while none is installed
+// timestamps are microseconds since unix epoch, anchored once per tracer and advanced
+// by the steady clock, so traces of different parties share a common time axis
+namespace trace
+{
+
+// event categories
+inline constexpr const char* cpu       = "cpu";        // local computation
+inline constexpr const char* serialize = "serialize";  // (de)serialization of messages
+inline constexpr const char* network   = "network";    // blocked on network
+inline constexpr const char* he        = "he";         // homomorphic encryption
+
+class Tracer
+{
+  public:
+    using SteadyClock = std::chrono::steady_clock;
+    using SystemClock = std::chrono::system_clock;
+
+    struct Event {
+        const char*   name;
+        const char*   category;
+        std::int64_t  ts;    // begin, us since epoch
+        std::int64_t  dur;   // us
+    };
+
+  protected:
+    std::size_t              _pid;
+    std::int64_t             _anchor_us;     // epoch us at construction
+    SteadyClock::time_point  _anchor_steady;
+    std::vector<Event>       _events;
+
+    static Tracer*& _current() {
+        thread_local Tracer* tracer = nullptr;
+        return tracer;
+    }
+
+  public:
+    Tracer(Tracer const&)            = delete;
+    Tracer& operator=(Tracer const&) = delete;
+
+    explicit Tracer(std::size_t pid)
+        : _pid(pid),
+          _anchor_us(std::chrono::duration_cast<std::chrono::microseconds>(
+              SystemClock::now().time_since_epoch()).count()),
+          _anchor_steady(SteadyClock::now())
+    {
+        _events.reserve(1 << 16);
+    }
+
+    ~Tracer() {
+        if (_current() == this)
+            _current() = nullptr;
+    }
+
+    // install on / remove from calling thread
+    static Tracer* current()          { return _current(); }
+    static void    install(Tracer* t) { _current() = t; }
+
+    std::int64_t now() const {
+        return _anchor_us + std::chrono::duration_cast<std::chrono::microseconds>(
+            SteadyClock::now() - _anchor_steady).count();
+    }
+
+    void record(const char* name, const char* category, std::int64_t begin, std::int64_t end) {
+        _events.push_back(Event{name, category, begin, end - begin});
+    }
+
+    std::vector<Event> const& events() const { return _events; }
+
+    void dump(std::string const& file_path) const
+    {
+        std::ofstream file(file_path);
+        if (!file)
+            throw std::runtime_error("cannot open " + file_path);
+
+        file << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"party\":" << _pid
+             << ",\"clock\":\"unix_us\"},\"traceEvents\":[\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << _pid
+             << ",\"tid\":0,\"args\":{\"name\":\"party " << _pid << "\"}}";
+        for (auto const& e : _events) {
+            file << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category
+                 << "\",\"ph\":\"X\",\"pid\":" << _pid << ",\"tid\":0,\"ts\":" << e.ts
+                 << ",\"dur\":" << e.dur << "}";
+        }
+        file << "\n]}\n";
+    }
+};
+
+// record one complete event for the lifetime of the guard
+// costs a thread_local lookup only when no tracer is installed
+class Scope
+{
+  protected:
+    Tracer*      _tracer;
+    const char*  _name;
+    const char*  _category;
+    std::int64_t _begin;
+
+  public:
+    Scope(Scope const&)            = delete;
+    Scope& operator=(Scope const&) = delete;
+
+    Scope(const char* name, const char* category = cpu)
+        : _tracer(Tracer::current()), _name(name), _category(category), _begin(0)
+    {
+        if (_tracer)
+            _begin = _tracer->now();
+    }
+
+    ~Scope() {
+        if (_tracer)
+            _tracer->record(_name, _category, _begin, _tracer->now());
+    }
+};
+
+} // namespace trace
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include "../tools/thread_pool.h"
 
 
 template <class T>
@@ -61,14 +62,17 @@ std::vector<T> mult(const std::vector<T>& v1, const std::vector<T>& v2){
     return ret;
 }
 
+// rows in parallel on pool if given
 template <class T>
-std::vector<T> mult_mv(const std::vector<std::vector<T>>& mat, const std::vector<T>& vec){
+std::vector<T> mult_mv(const std::vector<std::vector<T>>& mat, const std::vector<T>& vec, ThreadPool* pool = nullptr){
     std::vector<T> ret(mat.size(), 0);
-    for(int i = 0; i != mat.size(); ++i){
-        for(int j = 0; j != mat[i].size(); ++j){
-            ret[i] += mat[i][j] * vec[j];
+    parallel_for(pool, mat.size(), 64, [&](size_t begin, size_t end){
+        for(size_t i = begin; i != end; ++i){
+            for(int j = 0; j != mat[i].size(); ++j){
+                ret[i] += mat[i][j] * vec[j];
+            }
         }
-    }
+    });
     return ret;
 }
 
@@ -4,15 +4,220 @@
 #include <string>
 #include <iostream>
 #include <cstdlib>
+#include <fmt/format.h>
 #include "src/config/config.h"
+#include "src/config/network_config.h"
+#include "src/config/execution.h"
 #include "src/network/multi_party_player.hpp"
 #include "src/models/psvlr.h"
 
 using namespace std;
 
+struct PartyOptions {
+    std::string data_file, stats_file, trace_file, share_store;
+    std::size_t triple_buffer = 2;
+    bool use_dealer = false;
+    unsigned long dealer_seed = 0;
+    MsbBackend msb_backend = MsbBackend::edabit;
+    OpenStrategy open_strategy = OpenStrategy::automatic;
+    int open_king = -1;
+    std::size_t stream_chunk = 1 << 20;
+    bool hybrid = false;
+    bool he_gradient = false;
+    bool sparse = false;
+    bool predict = false;
+    ExecutionBudget budget;
+};
+
+// calls f(n, d) with n, d std::integral_constants of the ring size and fractional bits
+// Client and PSVLR are compiled for these pairs only
+template <typename F>
+void with_ring(std::size_t ring, std::size_t precision, F&& f) {
+    if (ring == 64 && precision == 16) {
+        f(std::integral_constant<std::size_t, 64>{}, std::integral_constant<std::size_t, 16>{});
+    }
+    else if (ring == 128 && precision == 12) {
+        f(std::integral_constant<std::size_t, 128>{}, std::integral_constant<std::size_t, 12>{});
+    }
+    else if (ring == 128 && precision == 20) {
+        f(std::integral_constant<std::size_t, 128>{}, std::integral_constant<std::size_t, 20>{});
+    }
+    else {
+        throw std::invalid_argument(fmt::format("unsupported ring {} with precision {}, choose 64/16, 128/12 or 128/20", ring, precision));
+    }
+}
+
+// offline_player: if given, matrix triples are produced by a background thread over it
+template <size_t N, size_t D>
+void train_shared(Client<N, D>& client, PSVLR<N, D>& model, network::MultiPartyPlayer* offline_player, std::size_t my_pid, std::size_t n_players, PartyOptions const& options) {
+    model.share_data();
+
+    client.initialize_keys(2, 50, 4096);
+
+    std::vector<std::vector<std::vector<double>>> u, u_transpose;
+    u.resize(4);
+    u_transpose.resize(4);
+    for(int i = 0; i != u.size(); ++i){
+        u[i].resize(model.batchsize);
+        for(int j = 0; j != u[i].size(); ++j){
+            u[i][j].resize(model.shared_data.cols());
+        }
+        u_transpose[i].resize(model.shared_data.cols());
+        for(int j = 0; j != u_transpose[i].size(); ++j){
+            u_transpose[i][j].resize(model.batchsize);
+        }
+
+    }
+
+    MatrixTriplePool<N> pool(options.triple_buffer);
+    pool.set_producer_init([threads = options.budget.background_threads]() { set_openmp_threads(threads); });
+    if (offline_player) {
+        int m = model.shared_data.cols();
+        client.start_matrix_triple_producer(pool, offline_player,
+            {{u, model.batchsize, m}, {u_transpose, m, model.batchsize}}, 1, 4, time(0) + my_pid + n_players);
+    }
+    else {
+        client.generate_matrix_triple(u, 1, 4, model.batchsize, model.shared_data.cols());
+        client.generate_matrix_triple(u_transpose, 1, 4, model.shared_data.cols(), model.batchsize);
+    }
+
+    model.train(1);
+    pool.join();
+}
+
+template <size_t N, size_t D>
+void run_party(network::MultiPartyPlayer* player, network::MultiPartyPlayer* offline_player, std::size_t my_pid, std::size_t n_players, PartyOptions const& options) {
+    mplayerid_t parties = player->all_but_me();
+
+    trace::Tracer tracer(my_pid);
+    if (!options.trace_file.empty()) {
+        trace::Tracer::install(&tracer);
+    }
+
+    // the party thread is one of the compute threads, with --pin-io it keeps them off the io cpus
+    pin_calling_thread(options.budget.compute_cpus());
+    set_openmp_threads(options.budget.compute_threads);
+    ThreadPool compute(options.budget.compute_threads - 1);
+
+    Semi2kContext<N> sc(player, parties, my_pid, time(0) + my_pid);
+    sc.set_open_strategy(options.open_strategy, options.open_king);
+    sc.set_stream_chunk(options.stream_chunk);
+    sc.set_thread_pool(&compute);
+    if (options.open_strategy == OpenStrategy::automatic && n_players > 2) {
+        network::PhaseGuard phase(player->phases(), "calibrate_open");
+        sc.calibrate_open();
+    }
+    FSemi2kContext<N, D> fsc(sc);
+    fsc.set_msb_backend(options.msb_backend);
+
+    Semi2kDealer<N> dealer(options.dealer_seed, my_pid, n_players);
+    if (options.use_dealer) {
+        fsc.set_dealer(&dealer);
+    }
+
+    bool has_label = (my_pid == SUPER_CLIENT_ID);
+
+    Client<N, D> client(my_pid, n_players, has_label, fsc, options.data_file, parties, my_pid, player);
+
+    PSVLR<N, D> model(client, 512);
+    model.store_dir = options.share_store;
+
+    if (options.hybrid) {
+        // no shared data and no matrix triples, HE only for the gradient if asked
+        if (options.sparse) {
+            client.to_sparse();
+        }
+        model.share_partition();
+        if (options.he_gradient) {
+            client.initialize_keys(2, 50, 4096);
+            model.he_gradient = true;
+        }
+        model.train_hybrid(1);
+        if (options.predict) {
+            // all batches at once, opened to everyone for the accuracy at the label client
+            RoundScheduler<N> scheduler(client.mplayer);
+            auto y_hat = model.predict_hybrid(&scheduler);
+            std::vector<Semi2kSharing<N>> raw(y_hat.size());
+            for (std::size_t i = 0; i != raw.size(); ++i) raw[i] = UnsignedZ2<N>(y_hat[i].get_data());
+            auto opened = sc.open(raw);
+            for (std::size_t i = 0; i != raw.size(); ++i) y_hat[i] = SignedZ2<N>(opened[i]);
+            if (has_label) {
+                auto p = client.share2double(y_hat);
+                std::size_t correct = 0;
+                for (std::size_t i = 0; i != p.size(); ++i) {
+                    correct += (p[i] >= 0.5) == (client.labels[i] >= 0.5);
+                }
+                std::cout << fmt::format("training accuracy {:.4f}, sigmoids in {}, predictions in {}", double(correct) / p.size(), model.sigmoid_scheduler.to_string(), scheduler.to_string()) << std::endl;
+            }
+        }
+    }
+    else {
+        train_shared(client, model, offline_player, my_pid, n_players, options);
+    }
+
+    if (!options.stats_file.empty()) {
+        player->phases().dump(fmt::format(fmt::runtime(options.stats_file), my_pid), my_pid);
+    }
+    if (!options.trace_file.empty()) {
+        tracer.dump(fmt::format(fmt::runtime(options.trace_file), my_pid));
+    }
+}
+
+// cost a training run from the lead client's view without peers, HE or share arithmetic
+template <size_t N, size_t D>
+void dry_run(std::size_t n_players, std::size_t samples, std::size_t features, int batch_size, int epochs, std::size_t ciphertext_bytes, PartyOptions const& options) {
+    network::SymbolicMultiPartyPlayer player(SUPER_CLIENT_ID, n_players);
+    mplayerid_t parties = player.all_but_me();
+
+    CostModel cost(true);
+    cost.ciphertext_bytes = ciphertext_bytes;
+
+    Semi2kContext<N> sc(&player, parties, SUPER_CLIENT_ID, 0);
+    sc.set_cost_model(&cost);
+    sc.set_open_strategy(options.open_strategy, options.open_king);
+    FSemi2kContext<N, D> fsc(sc);
+    fsc.set_msb_backend(options.msb_backend);
+
+    std::vector<std::vector<double>> data(samples, std::vector<double>(features + 1, 0));
+    Client<N, D> client(SUPER_CLIENT_ID, n_players, true, fsc, std::move(data), parties, SUPER_CLIENT_ID, &player);
+
+    PSVLR<N, D> model(client, batch_size);
+
+    if (options.hybrid) {
+        model.share_partition();
+        model.he_gradient = options.he_gradient;
+        model.train_hybrid(epochs);
+    }
+    else {
+        model.share_data();
+
+        int num_blocks = (samples + batch_size - 1) / batch_size;
+        int total_features = model.shared_data.cols();
+        client.generate_matrix_triple({}, epochs, num_blocks, batch_size, total_features);
+        client.generate_matrix_triple({}, epochs, num_blocks, total_features, batch_size);
+
+        model.train(epochs);
+    }
+
+    auto stat = player.get_statistics();
+    std::string bytes_send, bytes_recv;
+    for (auto pid : parties) {
+        bytes_send += fmt::format("{}{}", bytes_send.empty() ? "" : ", ", stat.bytes_send[pid]);
+        bytes_recv += fmt::format("{}{}", bytes_recv.empty() ? "" : ", ", stat.bytes_recv[pid]);
+    }
+    std::cout << "{\"bytes_send_per_peer\": [" << bytes_send << "], "
+              << "\"bytes_recv_per_peer\": [" << bytes_recv << "],\n"
+              << "\"cost\": " << cost.to_json() << ",\n"
+              << "\"communication\": " << player.phases().to_json(SUPER_CLIENT_ID) << "}" << std::endl;
+}
+
 int main(int argc, char *argv[]) {
-    std::size_t my_pid, n_players;
-    std::string network_file, data_file;
+    std::size_t my_pid, n_players, samples, features, ciphertext_bytes, ring, precision, cpus, io_threads, cpu_base;
+    int batch_size, epochs;
+    double delay_ms, bandwidth_mbps;
+    std::string network_profile;
+    std::string network_file, msb_backend, open_strategy;
+    PartyOptions options;
 
     srand(time(0));
 
@@ -21,20 +226,132 @@ int main(int argc, char *argv[]) {
     description.add_options()
         ("help,h", "display this help message")
         ("version,v", "display the version number")
+        ("local", "run all clients as threads of this process, data-file may contain {} for the client id")
         ("client-id", po::value<std::size_t>(&my_pid), "current client id")
         ("client-num", po::value<std::size_t>(&n_players), "total client num")
         ("network-file", po::value<std::string>(&network_file), "network file used")
-        ("data-file", po::value<std::string>(&data_file), "dataset used for the task");
+        ("data-file", po::value<std::string>(&options.data_file), "dataset used for the task")
+        ("stats-file", po::value<std::string>(&options.stats_file), "dump per-phase communication statistics as json, {} is replaced by the client id")
+        ("dry-run", "only count rounds, bytes, correlated randomness and HE operations of a training run")
+        ("samples", po::value<std::size_t>(&samples)->default_value(10000), "dry run: number of samples")
+        ("features", po::value<std::size_t>(&features)->default_value(16), "dry run: number of features per client")
+        ("batch-size", po::value<int>(&batch_size)->default_value(512), "dry run: batch size")
+        ("epochs", po::value<int>(&epochs)->default_value(1), "dry run: number of epochs")
+        ("ciphertext-bytes", po::value<std::size_t>(&ciphertext_bytes)->default_value(393216), "dry run: estimated size of one ciphertext")
+        ("background-triples", "produce matrix triples in a background thread over a second connection (port + 1000, or party_i_offline_port)")
+        ("triple-buffer", po::value<std::size_t>(&options.triple_buffer)->default_value(2), "background triples: triples buffered per shape and block")
+        ("dealer-seed", po::value<unsigned long>(&options.dealer_seed), "draw triples, edaBits and daBits from a local dealer with this seed, the same on every client (testing only, the seed reveals all masks)")
+        ("ring", po::value<std::size_t>(&ring)->default_value(128), "bits of the share ring, 64 or 128")
+        ("precision", po::value<std::size_t>(&precision)->default_value(12), "fractional bits of the fixed-point shares, 16 with a 64-bit ring, 12 or 20 with a 128-bit ring")
+        ("hybrid", "keep the data with its owners in plaintext and share only weights, partial sums and residuals")
+        ("share-store", po::value<std::string>(&options.share_store), "keep the shared and masked data in files in this directory and map them batch by batch, for data larger than memory")
+        ("sparse", "hybrid: keep the local features as compressed sparse rows, for one-hot data")
+        ("he-gradient", "hybrid: compute X_p^T * r under threshold CKKS instead of with plaintext-by-share products")
+        ("predict", "hybrid: after training, predict the training rows with all batches in the rounds of one and print the accuracy")
+        ("msb", po::value<std::string>(&msb_backend)->default_value("edabit"), "comparison protocol: bitwise, edabit or dcf (needs --dealer-seed except in a dry run)")
+        ("open", po::value<std::string>(&open_strategy)->default_value("auto"), "how openings reconstruct: all-to-all, king, or auto to choose per opening from the party count and the latency measured at start")
+        ("open-king", po::value<int>(&options.open_king)->default_value(-1), "the client reconstructing king openings, -1 rotates over all clients")
+        ("stream-chunk", po::value<std::size_t>(&options.stream_chunk)->default_value(1 << 20), "bytes: larger openings sum the shares received piece by piece as they arrive, 0 waits for whole messages")
+        ("cpus", po::value<std::size_t>(&cpus)->default_value(0), "cpus of this client, 0 for all of the machine, with --local shared evenly by all clients")
+        ("io-threads", po::value<std::size_t>(&io_threads), "network threads of each player, by default one per peer up to a quarter of the cpus; the other cpus compute")
+        ("pin-io", "pin the network threads to the last io-threads cpus and the compute threads to the others")
+        ("cpu-base", po::value<std::size_t>(&cpu_base)->default_value(0), "with --pin-io, the first cpu of this client's cpus, clients on one host take disjoint ranges")
+        ("trace-file", po::value<std::string>(&options.trace_file), "dump chrome trace events of this client, {} is replaced by the client id")
+        ("network-profile", po::value<std::string>(&network_profile), "emulate this topology on every outgoing link instead of the link profiles of the network file: none, LAN-10G, LAN-1G, WAN-1G-10ms, WAN-100M-50ms or WAN-10M-100ms")
+        ("delay-ms", po::value<double>(&delay_ms), "emulate a one-way latency on every outgoing link, in milliseconds, on top of the link profiles")
+        ("bandwidth-mbps", po::value<double>(&bandwidth_mbps), "emulate a bandwidth limit on every outgoing link, in megabits per second, 0 for none, on top of the link profiles");
 
     po::variables_map vm;
     po::store(po::command_line_parser(argc, argv).options(description).run(), vm);
     po::notify(vm);
 
-    std::size_t n_threads = n_players - 1;
+    if (msb_backend == "bitwise") {
+        options.msb_backend = MsbBackend::bitwise;
+    }
+    else if (msb_backend == "dcf") {
+        options.msb_backend = MsbBackend::dcf;
+    }
+    else if (msb_backend != "edabit") {
+        throw std::invalid_argument("unknown msb backend " + msb_backend);
+    }
+
+    if (open_strategy == "all-to-all") {
+        options.open_strategy = OpenStrategy::all_to_all;
+    }
+    else if (open_strategy == "king") {
+        options.open_strategy = OpenStrategy::king;
+    }
+    else if (open_strategy != "auto") {
+        throw std::invalid_argument("unknown opening strategy " + open_strategy);
+    }
+
+    options.hybrid = vm.count("hybrid");
+    options.he_gradient = vm.count("he-gradient");
+    options.sparse = vm.count("sparse");
+    options.predict = vm.count("predict");
+    if ((options.he_gradient || options.sparse || options.predict) && !options.hybrid) {
+        throw std::invalid_argument("--he-gradient, --sparse and --predict need --hybrid");
+    }
+    if (options.hybrid && !options.share_store.empty()) {
+        throw std::invalid_argument("--share-store is for the shared mode, --hybrid shares no data");
+    }
+
+    if (vm.count("dry-run")) {
+        with_ring(ring, precision, [&](auto n, auto d) {
+            dry_run<decltype(n)::value, decltype(d)::value>(n_players, samples, features, batch_size, epochs, ciphertext_bytes, options);
+        });
+        return 0;
+    }
+
+    bool background = vm.count("background-triples");
+    options.use_dealer = vm.count("dealer-seed");
+
+    if (vm.count("local")) {
+        if (vm.count("network-profile") || vm.count("delay-ms") || vm.count("bandwidth-mbps")) {
+            throw std::invalid_argument("--network-profile, --delay-ms and --bandwidth-mbps need socket players, not --local");
+        }
+        if (vm.count("io-threads") || vm.count("pin-io")) {
+            throw std::invalid_argument("--io-threads and --pin-io need socket players, not --local");
+        }
+        // local players need no io threads
+        std::size_t all = ExecutionBudget::split(cpus, 0, false).cpus;
+        options.budget = ExecutionBudget::split(std::max<std::size_t>(1, all / n_players), 0, background);
+        std::cout << "each client: " << options.budget.to_string() << std::endl;
+        network::LocalNetwork offline_net(n_players);
+        network::run_local_parties(n_players, [&](network::LocalMultiPartyPlayer& player) {
+            PartyOptions party_options = options;
+            party_options.data_file = fmt::format(fmt::runtime(options.data_file), player.id());
+            network::LocalMultiPartyPlayer offline_player(player.id(), offline_net);
+            with_ring(ring, precision, [&](auto n, auto d) {
+                run_party<decltype(n)::value, decltype(d)::value>(&player, background ? &offline_player : nullptr, player.id(), n_players, party_options);
+            });
+        });
+        return 0;
+    }
+
+    if (vm.count("io-threads") && io_threads == 0) {
+        throw std::invalid_argument("--io-threads must be positive");
+    }
+    options.budget = ExecutionBudget::split(cpus, vm.count("io-threads") ? io_threads : ExecutionBudget::default_io_threads(cpus, n_players), background);
+    options.budget.pin_io = vm.count("pin-io");
+    options.budget.cpu_base = cpu_base;
+    std::vector<int> io_cpus = options.budget.io_cpus();
+    std::cout << options.budget.to_string() << std::endl;
     ConfigFile config_file(network_file);
+    std::vector<network::LinkProfile> links = vm.count("network-profile")
+        ? std::vector<network::LinkProfile>(n_players, network::LinkProfile::preset(network_profile))
+        : read_link_profiles(config_file, my_pid, n_players);
+    for (auto& link : links) {
+        if (vm.count("delay-ms")) {
+            link.delay = std::chrono::duration_cast<network::LinkProfile::DurationType>(std::chrono::duration<double, std::milli>(delay_ms));
+        }
+        if (vm.count("bandwidth-mbps")) {
+            link.bandwidth = bandwidth_mbps == 0 ? network::LinkProfile::BitrateType::unlimited() : network::GigaBitsPerSecond(bandwidth_mbps / 1000);
+            link.capacity = 0;
+        }
+    }
     std::string portString, ipString;
-    std::vector<boost::asio::ip::tcp::endpoint> endpoints;
-    mplayerid_t parties;
+    std::vector<boost::asio::ip::tcp::endpoint> endpoints, offline_endpoints;
     for (int i = 0; i != n_players; ++i) {
         portString = "party_" + std::to_string(i) + "_port";
         ipString = "party_" + std::to_string(i) + "_ip";
@@ -43,49 +360,30 @@ int main(int argc, char *argv[]) {
         }
         else {
             endpoints.emplace_back(boost::asio::ip::address::from_string(config_file.value("",ipString)), std::stoi(config_file.value("",portString)));
-            parties.insert(i);
         }
-        std::cout << i << ": (" << config_file.value("",ipString) << ", " << config_file.value("",portString) << ")" << std::endl;
-    }
-    
-    network::PlainMultiPartyPlayer player(my_pid, n_players);
-    player.run(n_threads);
-    player.connect(endpoints);
-    constexpr size_t K = 128, N = K, D = 12;
-    Semi2kContext<K> sc(&player, parties, my_pid, time(0) + my_pid);
-    FSemi2kContext<N, D> fsc(sc);
-
-    bool has_label = (my_pid == SUPER_CLIENT_ID);
+        std::cout << i << ": (" << config_file.value("",ipString) << ", " << config_file.value("",portString) << ")"
+                  << (i == my_pid ? "" : " " + links[i].to_string()) << std::endl;
 
-    Client client(my_pid, n_players, has_label, fsc, data_file, parties, my_pid, &player);
-
-    PSVLR model(client, 512);
-
-    model.share_data();
-
-    client.initialize_keys(2, 50, 4096);
-
-    std::vector<std::vector<std::vector<double>>> u, u_transpose;
-    u.resize(4);
-    u_transpose.resize(4);
-    for(int i = 0; i != u.size(); ++i){
-        u[i].resize(model.batchsize);
-        for(int j = 0; j != u[i].size(); ++j){
-            u[i][j].resize(model.shared_data[0].size());
-        }
-        u_transpose[i].resize(model.shared_data[0].size());
-        for(int j = 0; j != u_transpose[i].size(); ++j){
-            u_transpose[i][j].resize(model.batchsize);
-        }
-        
+        std::string offlinePortString = "party_" + std::to_string(i) + "_offline_port";
+        int offline_port = config_file.has("", offlinePortString)
+            ? std::stoi(config_file.value("", offlinePortString))
+            : std::stoi(config_file.value("", portString)) + 1000;
+        offline_endpoints.emplace_back(endpoints.back().address(), offline_port);
     }
 
-    client.generate_matrix_triple(u, 1, 4, model.batchsize, model.shared_data[0].size());
-    client.generate_matrix_triple(u_transpose, 1, 4, model.shared_data[0].size(), model.batchsize);
-
-    model.train(1);
+    network::PlainMultiPartyPlayer player(my_pid, n_players);
+    player.run(options.budget.io_threads, io_cpus);
+    player.connect(endpoints, links);
 
+    std::unique_ptr<network::PlainMultiPartyPlayer> offline_player;
+    if (background) {
+        offline_player = std::make_unique<network::PlainMultiPartyPlayer>(my_pid, n_players);
+        offline_player->run(options.budget.io_threads, io_cpus);
+        offline_player->connect(offline_endpoints, links);
+    }
 
+    with_ring(ring, precision, [&](auto n, auto d) {
+        run_party<decltype(n)::value, decltype(d)::value>(&player, offline_player.get(), my_pid, n_players, options);
+    });
 }
 
-